@@ -41,27 +41,53 @@ struct AFS : public ContainerFile {
 
         Entry(OffsetEntry offsetEntry)
             : offset(offsetEntry)
-        {
-            data.resize(offsetEntry.fileSize);
-        }
+            , meta()
+        {}
 
         Entry(OffsetEntry offsetEntry, MetaEntry metaEntry)
             : offset(offsetEntry)
             , meta(metaEntry)
-        {
-            data.resize(offsetEntry.fileSize);
-        }
+        {}
 
         void readData(std::istream& stream) {
+            view = MemoryView();
+            data.resize(offset.fileSize);
             stream.read(data.data(), offset.fileSize);
         }
 
+        /**
+         * @brief Returns true if the entry data is available in memory.
+         */
+        bool isLoaded() const {
+            return view || data.size() == offset.fileSize;
+        }
+
         void writeData(std::ostream& stream) {
-            stream.write(data.data(), offset.fileSize);
+            stream.write(getView().data, offset.fileSize);
+        }
+
+        /**
+         * @brief References the entry data in memory owned by someone else (e.g. a file mapping).
+         */
+        void setView(MemoryView _view) {
+            data.clear();
+            view = _view;
         }
 
-        std::vector<char> getData() { return data; }
+        /**
+         * @brief Returns the entry data without copying it.
+         */
+        MemoryView getView() const {
+            if (view) return view;
+            return MemoryView(data.data(), data.size());
+        }
+
+        std::vector<char> getData() {
+            if (view) return std::vector<char>(view.begin(), view.end());
+            return data;
+        }
         void setData(std::vector<char>& _data) {
+            view = MemoryView();
             data = _data;
             offset.fileSize = data.size();
         }
@@ -72,23 +98,65 @@ struct AFS : public ContainerFile {
 
     private:
         std::vector<char> data;
+        MemoryView view;
     };
 
     AFS();
     AFS(const std::string& filepath);
+    AFS(const std::string& filepath, ReadMode mode);
     AFS(std::istream& stream);
     ~AFS();
 
     virtual void unpack(const std::string& folder);
+
+    /**
+     * @brief Extracts all entries into a folder using multiple threads.
+     * @param idx Optional index used to name the entries.
+     * @param threads Number of worker threads, 0 uses all cores.
+     */
+    UnpackStats unpack(const std::string& folder, IDX* idx, unsigned threads = 0);
     void mapIdxFilenames(IDX& idx);
 
+    /**
+     * @brief Returns the name of an entry from the index, its meta entry or its position.
+     */
+    std::string getEntryFilename(size_t index, IDX* idx = nullptr) const;
+
+    /**
+     * @brief Loads the data of an entry that was skipped in index-only mode
+     *        from the file the archive was read from.
+     */
+    void loadEntry(AFS::Entry& entry);
+    void loadEntry(AFS::Entry& entry, std::istream& stream);
+
+    /**
+     * @brief Loads every entry skipped in index-only mode, reading the source file once.
+     */
+    void loadAll();
+
+    /**
+     * @brief Writes the archive, entries are loaded before the output is opened
+     *        so it can replace the file the archive was read from.
+     */
+    using File::write;
+    virtual void write(const std::string& filepath);
+
+    /**
+     * @brief Returns the data of an entry without copying it, loading it first if needed.
+     */
+    MemoryView getEntryView(size_t index);
+
     AFS::Header header;
     std::vector<AFS::Entry> entries;
 
 protected:
-    const uint32_t padding = 0x0800; // TODO: make padding adjustable
-    const uint32_t maxPadding = 0x0008000;
-    const uint32_t fileCountMagic = 1016; // TODO: fix this magic number
+    friend struct AFSBuilder;
+
+    static constexpr uint32_t padding = 0x0800; // TODO: make padding adjustable
+    static constexpr uint32_t maxPadding = 0x0008000;
+    static constexpr uint32_t fileCountMagic = 1016; // TODO: fix this magic number
+    std::string sourcePath; // file the entries were read from, used for on demand loading
+    int64_t sourceOffset = 0;
 
     virtual void _read(std::istream& stream);
     virtual void _write(std::ostream& stream);
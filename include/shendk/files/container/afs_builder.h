@@ -0,0 +1,56 @@
+#pragma once
+
+#include <functional>
+#include <memory>
+#include <vector>
+
+#include "shendk/files/container/afs.h"
+
+namespace shendk {
+
+/**
+ * @brief Writes an AFS archive by streaming the sources one after another.
+ *        Only one copy buffer is held in memory regardless of the archive size.
+ */
+struct AFSBuilder {
+
+    /**
+     * @brief Opens the stream of a source right before it is written.
+     */
+    using Opener = std::function<std::unique_ptr<std::istream>()>;
+
+    struct Source {
+        AFS::MetaEntry meta;
+        uint32_t size;
+        Opener open;
+    };
+
+    /**
+     * @brief Adds a file from disk, named after its filename.
+     */
+    void addFile(const std::string& filepath);
+    void addFile(const std::string& filepath, const std::string& name);
+
+    /**
+     * @brief Adds a source of the given size that is read through its opener.
+     */
+    void addStream(const std::string& name, uint32_t size, Opener open);
+    void addStream(const AFS::MetaEntry& meta, uint32_t size, Opener open);
+
+    /**
+     * @brief Adds the entries of an existing archive (loaded or not).
+     *        Entries that aren't loaded are streamed from the archive's file,
+     *        which therefore must not be the build output.
+     */
+    void addEntries(AFS& afs);
+
+    void build(const std::string& filepath);
+    void build(std::ostream& stream);
+
+    std::vector<Source> sources;
+
+private:
+    static AFS::MetaEntry makeMeta(const std::string& name, uint32_t size);
+};
+
+}
@@ -1,5 +1,7 @@
 #pragma once
 
+#include <vector>
+
 #include "shendk/files/file.h"
 
 namespace shendk {
@@ -9,14 +11,54 @@ namespace shendk {
  */
 struct GZ : public File {
 
+    /**
+     * @brief Compression settings, level and strategy take the zlib values.
+     */
+    struct Options {
+        int level = -1;                 // Z_DEFAULT_COMPRESSION
+        int strategy = 0;               // Z_DEFAULT_STRATEGY
+        uint32_t blockSize = 1 << 20;   // input bytes per gzip member
+        unsigned threads = 0;           // 0 uses all cores
+    };
+
     GZ();
     GZ(const std::string& filepath);
     GZ(std::istream& stream);
     ~GZ();
 
+    /**
+     * @brief Checks for a gzip header at the current stream position.
+     */
     static bool testGzip(std::istream& stream);
+
+    /**
+     * @brief Inflates the gzip data at the current stream position into a new buffer.
+     *        Prefer igzstream (shendk/utils/gzstream.h) to parse the data without materializing it.
+     */
     static char* inflateStream(std::istream& inStream, uint64_t& bufferSize);
 
+    /**
+     * @brief Inflates gzip data in memory using a pooled zlib stream.
+     */
+    static bool inflateMemory(MemoryView input, std::vector<char>& output);
+
+    /**
+     * @brief Inflates many gzip payloads concurrently. Payloads that fail to inflate yield empty buffers.
+     * @param threads Number of worker threads, 0 uses all cores.
+     */
+    static std::vector<std::vector<char>> inflateBatch(const std::vector<MemoryView>& payloads, unsigned threads = 0);
+
+    /**
+     * @brief Compresses data on all cores (pigz style). The input is split into
+     *        blocks that are deflated independently and written as consecutive
+     *        gzip members, which every gzip reader handles as one file.
+     */
+    static bool deflateStream(const char* data, uint64_t size, std::ostream& outStream);
+    static bool deflateStream(const char* data, uint64_t size, std::ostream& outStream, const GZ::Options& options);
+
+    std::vector<char> data;
+    GZ::Options options;
+
 protected:
     virtual void _read(std::istream& stream);
     virtual void _write(std::ostream& stream);
@@ -0,0 +1,74 @@
+#pragma once
+
+#include <vector>
+
+#include "shendk/files/file.h"
+
+namespace shendk {
+
+/**
+ * @brief Checkpoint index for random access into gzip data (zran style).
+ *        Every checkpoint stores the inflate state at a deflate block boundary
+ *        (bit position and the last 32 KiB of output), so inflating can start
+ *        there instead of at the beginning. Used through igzstream.
+ */
+struct GZIndex : public File {
+    const static uint32_t signature = 0x58495A47; // "GZIX"
+    const static uint32_t version = 2;
+    const static uint32_t windowSize = 0x8000;
+
+    struct Header {
+        uint32_t signature;
+        uint32_t version;
+        uint64_t sourceSize;
+        int64_t sourceTime;
+        uint64_t compressedSize;
+        uint64_t uncompressedSize;
+        uint64_t span;
+        uint32_t checkpointCount;
+        uint32_t windowSize;
+    };
+
+    struct Checkpoint {
+        uint64_t in;        // compressed offset of the first full byte
+        uint64_t out;       // uncompressed offset
+        uint8_t bits;       // bits of the previous byte that belong to the block
+        std::vector<uint8_t> window;
+    };
+
+    GZIndex();
+    GZIndex(const std::string& filepath);
+    ~GZIndex();
+
+    /**
+     * @brief Builds the index from the gzip data at the current stream position.
+     * @param span Minimum uncompressed distance between checkpoints.
+     */
+    bool build(std::istream& stream, uint64_t span = 1 << 20);
+
+    /**
+     * @brief Loads the cached index next to a gzip file (filepath + ".gzi"),
+     *        or builds it and writes the cache if it's missing or outdated.
+     *        The cache is outdated when the gzip file's size or modification time changed.
+     */
+    bool loadOrBuild(const std::string& gzFilepath, uint64_t span = 1 << 20);
+
+    /**
+     * @brief Returns the last checkpoint at or before an uncompressed offset.
+     */
+    const Checkpoint* find(uint64_t offset) const;
+
+    uint64_t sourceSize = 0;        // size of the indexed file, trailing bytes included
+    int64_t sourceTime = 0;         // modification time of the indexed file
+    uint64_t compressedSize = 0;    // bytes consumed by inflate
+    uint64_t uncompressedSize = 0;
+    uint64_t span = 0;
+    std::vector<Checkpoint> checkpoints;
+
+protected:
+    virtual void _read(std::istream& stream);
+    virtual void _write(std::ostream& stream);
+    virtual bool _isValid(uint32_t signature);
+};
+
+}
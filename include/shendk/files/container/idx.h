@@ -1,6 +1,7 @@
 #pragma once
 
 #include <map>
+#include <vector>
 
 #include "shendk/files/container_file.h"
 
@@ -53,7 +54,7 @@ struct IDX : public File {
     IDX(std::istream& stream);
     ~IDX();
 
-    std::string getFilename(uint32_t index);
+    const std::string& getFilename(uint32_t index) const;
     IDX::Type getType(uint32_t signature);
 
     std::vector<std::string> entries;
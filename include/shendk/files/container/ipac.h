@@ -36,20 +36,40 @@ struct IPAC : public File {
 
         Entry(EntryMeta entryMeta)
             : meta(entryMeta)
-        {
-            data.resize(meta.fileSize);
-        }
+        {}
 
         void readData(std::istream& stream) {
+            view = MemoryView();
+            data.resize(meta.fileSize);
             stream.read(data.data(), meta.fileSize);
         }
 
         void writeData(std::ostream& stream) {
-            stream.write(data.data(), meta.fileSize);
+            stream.write(getView().data, meta.fileSize);
+        }
+
+        /**
+         * @brief References the entry data in memory owned by someone else (e.g. a file mapping).
+         */
+        void setView(MemoryView _view) {
+            data.clear();
+            view = _view;
+        }
+
+        /**
+         * @brief Returns the entry data without copying it.
+         */
+        MemoryView getView() const {
+            if (view) return view;
+            return MemoryView(data.data(), data.size());
         }
 
-        std::vector<char> getData() { return data; }
+        std::vector<char> getData() {
+            if (view) return std::vector<char>(view.begin(), view.end());
+            return data;
+        }
         void setData(std::vector<char>& _data) {
+            view = MemoryView();
             data = _data;
             meta.fileSize = data.size();
         }
@@ -58,6 +78,7 @@ struct IPAC : public File {
 
     private:
         std::vector<char> data;
+        MemoryView view;
     };
 
     IPAC();
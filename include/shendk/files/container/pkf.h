@@ -4,6 +4,7 @@
 #include <map>
 
 #include "shendk/files/file.h"
+#include "shendk/files/container/gz.h"
 #include "shendk/files/container/ipac.h"
 #include "shendk/node/texn.h"
 
@@ -34,10 +35,12 @@ struct PKF : public File {
     IPAC* ipac = nullptr;
 
     bool Compressed = false;
+    GZ::Options compression;
 
 protected:
     virtual void _read(std::istream& stream);
     virtual void _write(std::ostream& stream);
+    void writeContent(std::ostream& stream);
     virtual bool _isValid(uint32_t signature);
 };
 }
@@ -1,6 +1,7 @@
 #pragma once
 
 #include "shendk/files/file.h"
+#include "shendk/files/container/gz.h"
 #include "shendk/files/container/ipac.h"
 
 namespace shendk {
@@ -26,9 +27,13 @@ struct PKS : public File {
     PKS::Header header;
     IPAC ipac;
 
+    bool Compressed = false;
+    GZ::Options compression;
+
 protected:
     virtual void _read(std::istream& stream);
     virtual void _write(std::ostream& stream);
+    void writeContent(std::ostream& stream);
     virtual bool _isValid(uint32_t signature);
 };
 
@@ -39,16 +39,44 @@ struct TAD : public File {
         uint32_t pad52;
     };
 
+    /**
+     * @brief File that replaces (or is added as) the TAC entry with the given hashes.
+     */
+    struct Patch {
+        uint32_t hash1;
+        uint32_t hash2;
+        std::string filepath;
+    };
+
     TAD();
     TAD(const std::string& filepath);
     ~TAD();
 
-    bool extract(const std::string& tacFilepath, const std::string& outputFolder);
+    /**
+     * @brief Extracts the TAC entries into a folder using multiple threads.
+     * @param filter Optional glob pattern, only matching entry paths are extracted.
+     * @param threads Number of worker threads, 0 uses all cores.
+     */
+    bool extract(const std::string& tacFilepath, const std::string& outputFolder,
+                 const std::string& filter = "", unsigned threads = 0);
+
+    /**
+     * @brief Replaces or adds files in a TAC without rebuilding it.
+     *        A file is written over its old data when it fits the old slot
+     *        (and no other entry shares it), otherwise it's appended to the TAC.
+     *        The entries and header are updated, only the TAD has to be written afterwards.
+     */
+    void patch(const std::string& tacFilepath, const std::vector<TAD::Patch>& patches);
+    void patch(const std::string& tacFilepath, uint32_t hash1, uint32_t hash2, const char* data, uint32_t size);
 
     TAD::Header header;
     std::vector<TAD::Entry> entries;
 
 protected:
+    const uint32_t patchAlignment = 0x10;
+
+    void patch(std::fstream& tac, uint32_t hash1, uint32_t hash2, std::istream& source, uint32_t size);
+
     virtual void _read(std::istream& stream);
     virtual void _write(std::ostream& stream);
     virtual bool _isValid(uint32_t signature);
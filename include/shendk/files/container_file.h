@@ -5,8 +5,32 @@
 namespace shendk {
 
 struct ContainerFile : File {
+
+    /**
+     * @brief Controls how much of a container is read up front.
+     */
+    enum class ReadMode {
+        Full,       // entry data is read (or mapped) while reading the container
+        IndexOnly   // only the entry tables are read, data is loaded on demand
+    };
+
     virtual void unpack(const std::string& folder) = 0;
     //virtual void pack(std::vector<std::string> files) = 0;
+
+    /**
+     * @brief Summary of an unpack run.
+     */
+    struct UnpackStats {
+        uint64_t files = 0;
+        uint64_t bytes = 0;
+        double seconds = 0.0;
+
+        double megabytesPerSecond() const {
+            return seconds > 0.0 ? bytes / (1024.0 * 1024.0) / seconds : 0.0;
+        }
+    };
+
+    ReadMode readMode = ReadMode::Full;
 };
 
 
@@ -3,6 +3,9 @@
 #include <string>
 #include <fstream>
 #include <filesystem>
+#include <memory>
+
+#include "shendk/utils/mapped_file.h"
 
 namespace fs = std::filesystem;
 
@@ -23,11 +26,25 @@ struct File {
 
     void read(std::istream& stream);
 
+    /**
+    * @brief Reads a file from memory.
+    * @param data Pointer to the file data.
+    * @param size Size of the file data in bytes.
+    **/
+    void read(const char* data, uint64_t size);
+
+    /**
+    * @brief Reads a file through a read-only memory mapping.
+    *        Container entries reference the mapping instead of copying their data.
+    * @param filepath Path of the file.
+    **/
+    void readMapped(const std::string& filepath);
+
     /**
     * @brief Writes a file.
     * @param filepath Path of the file.
     **/
-    void write(const std::string& filepath);
+    virtual void write(const std::string& filepath);
 
     void write(std::ostream& stream);
 
@@ -39,11 +56,18 @@ struct File {
 
     std::string filepath;
 
+    /**
+    * @brief Mapping backing the views handed out by this file (if any).
+    **/
+    std::shared_ptr<MappedFile> mappedFile;
+
 protected:
     virtual void _read(std::istream& stream) = 0;
     virtual void _write(std::ostream& stream) = 0;
     virtual bool _isValid(uint32_t signature) = 0;
 
+    MemoryView mappedView(std::istream& stream, uint64_t offset, uint64_t size);
+
     int64_t baseOffset;
 };
 
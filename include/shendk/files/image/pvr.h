@@ -15,7 +15,7 @@ struct PVR : public ImageFile {
 
     struct GBIX {
         uint32_t signature = gbix;
-        uint32_t size = 0;
+        uint32_t size = 4; // bytes after the size field, PVRT follows at 8 + size
         uint32_t index = 0;
     };
 
@@ -37,16 +37,24 @@ struct PVR : public ImageFile {
 
     PVR::Header header;
     PVR::GBIX globalIndex;
-    bool hasGlobalIndex;
+    bool hasGlobalIndex = false;
+
+    /**
+     * @brief External palette (PVP) of palettized textures, used when reading.
+     *        Writing maps the texture to it, or creates it when empty.
+     */
+    std::vector<RGBA> palette;
+
+    /**
+     * @brief The external palette in the texture's pixel format, the entries of a PVP file.
+     */
+    std::vector<uint8_t> encodePalette() const;
 
 protected:
     virtual void _read(std::istream& stream);
     virtual void _write(std::ostream& stream);
     virtual bool _isValid(uint32_t signature);
 
-private:
-    std::vector<char> bitmapToRawVQ(std::shared_ptr<Image> img, uint16_t codeBookSize, std::vector<char>& palette);
-
 };
 
 }
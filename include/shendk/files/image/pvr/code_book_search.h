@@ -0,0 +1,48 @@
+#pragma once
+
+#include <stdint.h>
+#include <vector>
+
+namespace shendk {
+namespace pvr {
+
+/**
+ * @brief Nearest entry search over a code book or palette (squared error).
+ *        Entries are sorted by their projection on the code book's principal axis, a query visits them
+ *        outwards from its own projection and stops once the projection gap alone exceeds the best
+ *        error found; distances are given up as soon as a partial sum exceeds it.
+ */
+struct CodeBookSearch {
+
+    CodeBookSearch() = default;
+
+    /**
+     * @brief Builds the search over size entries of dimensions floats (a multiple of 4).
+     */
+    CodeBookSearch(const float* codeBook, uint32_t size, uint32_t dimensions);
+
+    /**
+     * @brief Builds the search over a code book of 8 bit channels.
+     */
+    CodeBookSearch(const std::vector<uint8_t>& codeBook, uint32_t dimensions);
+
+    /**
+     * @brief Index of the nearest entry and its squared error.
+     */
+    uint32_t nearest(const float* block, float& distance) const;
+
+    inline uint32_t size() const { return static_cast<uint32_t>(m_indices.size()); }
+    inline uint32_t dimensions() const { return m_dimensions; }
+
+private:
+    void build(const float* codeBook, uint32_t size, uint32_t dimensions);
+
+    uint32_t m_dimensions = 0;
+    std::vector<float> m_axis;
+    std::vector<float> m_entries;       // sorted by projection
+    std::vector<float> m_projections;
+    std::vector<uint32_t> m_indices;    // code book index of every sorted entry
+};
+
+}
+}
@@ -14,15 +14,48 @@ namespace pvr {
 
 struct CompressionCodec {
     virtual ~CompressionCodec();
+
+    /**
+     * @brief Decompresses a whole texture file, dataOffset is the offset of the compressed pixel data in input.
+     *        Returns a buffer of decompressedSize(input) bytes or nullptr on error.
+     */
     virtual uint8_t* decompress(uint8_t* input, uint32_t inputLength, uint64_t DataOffset, DataCodec* DataCodec) = 0;
-    virtual uint8_t* compress(uint8_t* input, uint32_t inputLength, uint64_t DataOffset, DataCodec* DataCodec) = 0;
+
+    /**
+     * @brief Compresses a whole texture file, dataOffset is the offset of the pixel data in input.
+     *        The compressed size is stored in outputLength.
+     */
+    virtual uint8_t* compress(uint8_t* input, uint32_t inputLength, uint64_t DataOffset, DataCodec* DataCodec, uint64_t& outputLength) = 0;
+
+    /**
+     * @brief Size of the decompressed texture file stored in front of compressed data.
+     */
+    static uint32_t decompressedSize(const uint8_t* input, uint64_t inputLength);
 
     static CompressionCodec* getCompressionCodec(CompressionFormat format);
 };
 
+/**
+ * @brief Run length encoding of whole pixels, every pixel is followed by its repeat count (0-255).
+ *        The compressed file starts with the decompressed size and the uncompressed texture header.
+ */
 struct RLE : CompressionCodec {
     uint8_t* decompress(uint8_t* input, uint32_t inputLength, uint64_t dataOffset, DataCodec* dataCodec);
-    uint8_t* compress(uint8_t* input, uint32_t inputLength, uint64_t dataOffset, DataCodec* dataCodec);
+    uint8_t* compress(uint8_t* input, uint32_t inputLength, uint64_t dataOffset, DataCodec* dataCodec, uint64_t& outputLength);
+
+    /**
+     * @brief Decompresses into a buffer of decompressedSize(input) bytes.
+     * @return Number of input bytes consumed, 0 if the data is invalid.
+     */
+    static uint64_t decompress(const uint8_t* input, uint64_t inputLength, uint64_t dataOffset, uint16_t pixelSize,
+                               uint8_t* output, uint64_t outputLength);
+
+    /**
+     * @brief Size in bytes of the run length encoded units for a data codec.
+     *        Formats with less than 8 bits per pixel are encoded bytewise.
+     */
+    static uint16_t pixelSize(DataCodec* dataCodec);
+    static uint16_t pixelSize(uint16_t bpp);
 };
 
 }
@@ -3,19 +3,71 @@
 #include <stdint.h>
 #include <iostream>
 
+#include "shendk/types/image.h"
 #include "shendk/files/image/pvr/pixel_codec.h"
+#include "shendk/files/image/pvr/palette.h"
 
 namespace shendk {
 namespace pvr {
 
+/**
+ * @brief Destination rows of a decode, rows are stride bytes apart (negative strides flip).
+ */
+struct PixelView {
+    PixelView(uint8_t* data, int64_t stride, uint16_t width, uint16_t height, bool bgra = false);
+
+    /**
+     * @brief View of an image's RGBA storage, bottom up when flipped.
+     */
+    static PixelView of(Image& image, bool flipVertical = false);
+
+    inline uint8_t* row(uint32_t y) const { return data + static_cast<int64_t>(y) * stride; }
+
+    uint8_t* data;
+    int64_t stride;
+    uint16_t width;
+    uint16_t height;
+    bool bgra; // keep the codecs' BGRA order instead of converting to RGBA
+};
+
 struct DataCodec {
 
     virtual ~DataCodec();
-    virtual uint16_t bpp() = 0;
-    virtual uint16_t paletteEntries(uint16_t);
-    virtual bool needsExternalPalette();
-    virtual bool hasMipmaps();
-    virtual bool vq();
+    virtual uint16_t bpp();
+    virtual uint16_t paletteEntries(uint16_t) const;
+    virtual bool needsExternalPalette() const;
+    virtual bool hasMipmaps() const;
+    virtual bool vq() const;
+
+    /**
+     * @brief Bits per pixel of the stored data with a pixel codec.
+     */
+    uint16_t bpp(PixelCodec* codec) const;
+
+    /**
+     * @brief Decodes a texture level straight into destination rows.
+     *        Doesn't touch the codec's state, the BGRA palette (paletteEntries) is passed in.
+     */
+    virtual void decodeInto(const uint8_t* src, uint16_t width, uint16_t height, PixelCodec* codec,
+                            const uint8_t* palette, const PixelView& dst) const = 0;
+
+    /**
+     * @brief Encodes a texture level into dst (dataSize bytes). src holds linear BGRA8888 rows,
+     *        or one palette index per texel (per 2x2 block for VQ) for formats with a palette.
+     */
+    virtual void encodeInto(const uint8_t* src, uint16_t width, uint16_t height, PixelCodec* codec, uint8_t* dst) const = 0;
+
+    /**
+     * @brief Encodes a texture level of linear BGRA8888 rows as the indices of their nearest
+     *        palette entries, for formats with an external palette (throws for others).
+     */
+    virtual void encodeIndexed(const uint8_t* bgra, uint16_t width, uint16_t height, const PaletteSearch& palette,
+                               uint8_t* dst, unsigned threads = 0) const;
+
+    /**
+     * @brief Size in bytes of an encoded texture level.
+     */
+    uint64_t dataSize(uint16_t width, uint16_t height, PixelCodec* codec) const;
 
     uint8_t* decode(std::istream& stream, uint16_t width, uint16_t height, PixelCodec* codec);
     uint8_t* decode(uint8_t* src, uint16_t width, uint16_t height, PixelCodec* codec);
@@ -26,81 +78,97 @@ struct DataCodec {
 
     static DataCodec* getDataCodec(DataFormat format);
 
-    PixelCodec* pixelCodec;
+    /**
+     * @brief Shared instance of a data format (nullptr if unsupported), only use its const interface.
+     */
+    static const DataCodec* get(DataFormat format);
+
+    PixelCodec* pixelCodec = nullptr;
 
 protected:
-    virtual uint8_t* decode(uint8_t* src, uint64_t srcIndex, uint16_t width, uint16_t height) = 0;
-    virtual uint8_t* encode(uint8_t* src, uint64_t srcIndex, uint16_t width, uint16_t height) = 0;
+    virtual uint16_t dataBpp() const; // 0 if the pixel codec defines the size
+    virtual uint8_t* decode(uint8_t* src, uint64_t srcIndex, uint16_t width, uint16_t height);
+    virtual uint8_t* encode(uint8_t* src, uint64_t srcIndex, uint16_t width, uint16_t height);
 
-    uint8_t* m_palette;
+    uint8_t* m_palette = nullptr;
 };
 
 
 struct SquareTwiddled : public DataCodec {
-    virtual uint16_t bpp();
-    virtual uint8_t* decode(uint8_t* src, uint64_t srcIndex, uint16_t width, uint16_t height);
-    virtual uint8_t* encode(uint8_t* src, uint64_t srcIndex, uint16_t width, uint16_t height);
+    virtual void decodeInto(const uint8_t* src, uint16_t width, uint16_t height, PixelCodec* codec,
+                            const uint8_t* palette, const PixelView& dst) const;
+    virtual void encodeInto(const uint8_t* src, uint16_t width, uint16_t height, PixelCodec* codec, uint8_t* dst) const;
 };
 
 struct SquareTwiddledMipmaps : public SquareTwiddled {
-    virtual bool hasMipmaps();
+    virtual bool hasMipmaps() const;
 };
 
 struct VQ : public DataCodec {
-    virtual bool vq();
-    virtual uint16_t bpp();
-    virtual uint16_t paletteEntries(uint16_t);
-    virtual uint8_t* decode(uint8_t* src, uint64_t srcIndex, uint16_t width, uint16_t height);
-    virtual uint8_t* encode(uint8_t* src, uint64_t srcIndex, uint16_t width, uint16_t height);
+    virtual bool vq() const;
+    virtual uint16_t paletteEntries(uint16_t) const;
+    virtual void decodeInto(const uint8_t* src, uint16_t width, uint16_t height, PixelCodec* codec,
+                            const uint8_t* palette, const PixelView& dst) const;
+    virtual void encodeInto(const uint8_t* src, uint16_t width, uint16_t height, PixelCodec* codec, uint8_t* dst) const;
+protected:
+    virtual uint16_t dataBpp() const;
 };
 
 struct VQMipmaps : public VQ {
-    virtual bool hasMipmaps();
+    virtual bool hasMipmaps() const;
 };
 
 struct VQSmall : public VQ {
-    virtual uint16_t paletteEntries(uint16_t width);
+    virtual uint16_t paletteEntries(uint16_t width) const;
 };
 
 struct VQSmallMipmaps : public VQSmall {
-    virtual bool hasMipmaps();
+    virtual bool hasMipmaps() const;
 };
 
 struct Index4 : public DataCodec {
-    virtual uint16_t bpp();
-    virtual uint16_t paletteEntries(uint16_t);
-    virtual bool needsExternalPalette();
-    virtual uint8_t* decode(uint8_t* src, uint64_t srcIndex, uint16_t width, uint16_t height);
-    virtual uint8_t* encode(uint8_t* src, uint64_t srcIndex, uint16_t width, uint16_t height);
+    virtual uint16_t paletteEntries(uint16_t) const;
+    virtual bool needsExternalPalette() const;
+    virtual void decodeInto(const uint8_t* src, uint16_t width, uint16_t height, PixelCodec* codec,
+                            const uint8_t* palette, const PixelView& dst) const;
+    virtual void encodeInto(const uint8_t* src, uint16_t width, uint16_t height, PixelCodec* codec, uint8_t* dst) const;
+    virtual void encodeIndexed(const uint8_t* bgra, uint16_t width, uint16_t height, const PaletteSearch& palette,
+                               uint8_t* dst, unsigned threads = 0) const;
+protected:
+    virtual uint16_t dataBpp() const;
 };
 
 struct Index4Mipmap : public Index4 {
-    virtual bool hasMipmaps();
+    virtual bool hasMipmaps() const;
 };
 
 struct Index8 : public DataCodec {
-    virtual uint16_t bpp();
-    virtual uint16_t paletteEntries(uint16_t);
-    virtual bool needsExternalPalette();
-    virtual uint8_t* decode(uint8_t* src, uint64_t srcIndex, uint16_t width, uint16_t height);
-    virtual uint8_t* encode(uint8_t* src, uint64_t srcIndex, uint16_t width, uint16_t height);
+    virtual uint16_t paletteEntries(uint16_t) const;
+    virtual bool needsExternalPalette() const;
+    virtual void decodeInto(const uint8_t* src, uint16_t width, uint16_t height, PixelCodec* codec,
+                            const uint8_t* palette, const PixelView& dst) const;
+    virtual void encodeInto(const uint8_t* src, uint16_t width, uint16_t height, PixelCodec* codec, uint8_t* dst) const;
+    virtual void encodeIndexed(const uint8_t* bgra, uint16_t width, uint16_t height, const PaletteSearch& palette,
+                               uint8_t* dst, unsigned threads = 0) const;
+protected:
+    virtual uint16_t dataBpp() const;
 };
 
 struct Index8Mipmap : public Index8 {
-    virtual bool hasMipmaps();
+    virtual bool hasMipmaps() const;
 };
 
 struct Rectangle : public DataCodec {
-    virtual uint16_t bpp();
-    uint8_t* decode(uint8_t* src, uint64_t srcIndex, uint16_t width, uint16_t height);
-    uint8_t* encode(uint8_t* src, uint64_t srcIndex, uint16_t width, uint16_t height);
+    virtual void decodeInto(const uint8_t* src, uint16_t width, uint16_t height, PixelCodec* codec,
+                            const uint8_t* palette, const PixelView& dst) const;
+    virtual void encodeInto(const uint8_t* src, uint16_t width, uint16_t height, PixelCodec* codec, uint8_t* dst) const;
 };
 
 struct RectangleTwiddled : public DataCodec {
     bool canEncode();
-    uint16_t bpp();
-    uint8_t* decode(uint8_t* src, uint64_t srcIndex, uint16_t width, uint16_t height);
-    uint8_t* encode(uint8_t* src, uint64_t srcIndex, uint16_t width, uint16_t height);
+    virtual void decodeInto(const uint8_t* src, uint16_t width, uint16_t height, PixelCodec* codec,
+                            const uint8_t* palette, const PixelView& dst) const;
+    virtual void encodeInto(const uint8_t* src, uint16_t width, uint16_t height, PixelCodec* codec, uint8_t* dst) const;
 };
 
 }
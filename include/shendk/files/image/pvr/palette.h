@@ -0,0 +1,48 @@
+#pragma once
+
+#include <stdint.h>
+#include <vector>
+
+#include "shendk/files/image/pvr/code_book_search.h"
+#include "shendk/files/image/pvr/vector_quantizer.h"
+
+namespace shendk {
+namespace pvr {
+
+/**
+ * @brief Settings of createPalette.
+ */
+struct PaletteOptions {
+    uint32_t iterations = 8;        // k-means iterations refining the median cut palette (0 = none)
+    uint8_t transparentAlpha = 0;   // texels with an alpha up to this are fully transparent, their color is ignored
+    unsigned threads = 0;           // 0 uses all cores
+};
+
+/**
+ * @brief Creates a BGRA8888 palette of size entries for the texels of 1x1 blocks.
+ *        Textures with up to size distinct colors keep them exactly, others are reduced by a
+ *        median cut on the weighted colors, refined by k-means. Transparent texels share one
+ *        reserved entry.
+ */
+std::vector<uint8_t> createPalette(const VQBlocks& colors, uint32_t size, const PaletteOptions& options = PaletteOptions());
+
+/**
+ * @brief Nearest palette entry of BGRA8888 texels, transparent texels (see PaletteOptions)
+ *        map to the palette's most transparent entry if that one is transparent as well.
+ */
+struct PaletteSearch {
+
+    PaletteSearch(const std::vector<uint8_t>& bgraPalette, uint8_t transparentAlpha = 0);
+
+    uint8_t index(const uint8_t* bgra) const;
+
+    inline uint32_t size() const { return m_search.size(); }
+
+private:
+    CodeBookSearch m_search;
+    uint8_t m_transparentAlpha;
+    int32_t m_transparentIndex = -1;
+};
+
+}
+}
@@ -13,52 +13,88 @@ struct PixelCodec {
     virtual void decodePixel(uint8_t* src, uint64_t srcIndex, uint8_t* dst, uint64_t dstIndex) = 0;
     virtual void encodePixel(uint8_t* src, uint64_t srcIndex, uint8_t* dst, uint64_t dstIndex) = 0;
 
+    /**
+     * @brief Decodes count pixels stored one after another to BGRA8888.
+     */
+    virtual void decodeRow(const uint8_t* src, uint8_t* dst, uint64_t count);
+
+    /**
+     * @brief Encodes count BGRA8888 pixels, stored one after another.
+     */
+    virtual void encodeRow(const uint8_t* src, uint8_t* dst, uint64_t count);
+
     uint8_t* decodePalette(uint8_t* src, uint64_t srcIndex, uint32_t numEntries);
     uint8_t* encodePalette(uint8_t* palette, uint32_t numEntries);
 
     static PixelCodec* getPixelCodec(PixelFormat format);
+
+    /**
+     * @brief Shared instance of a pixel format (nullptr if unsupported), the codecs are stateless.
+     */
+    static PixelCodec* get(PixelFormat format);
 };
 
 struct ARGB1555 : public PixelCodec {
     virtual uint16_t bpp();
     virtual void decodePixel(uint8_t* src, uint64_t srcIndex, uint8_t* dst, uint64_t dstIndex);
     virtual void encodePixel(uint8_t* src, uint64_t srcIndex, uint8_t* dst, uint64_t dstIndex);
+    virtual void decodeRow(const uint8_t* src, uint8_t* dst, uint64_t count);
+    virtual void encodeRow(const uint8_t* src, uint8_t* dst, uint64_t count);
 };
 
 struct RGB565 : public PixelCodec {
     virtual uint16_t bpp();
     virtual void decodePixel(uint8_t* src, uint64_t srcIndex, uint8_t* dst, uint64_t dstIndex);
     virtual void encodePixel(uint8_t* src, uint64_t srcIndex, uint8_t* dst, uint64_t dstIndex);
+    virtual void decodeRow(const uint8_t* src, uint8_t* dst, uint64_t count);
+    virtual void encodeRow(const uint8_t* src, uint8_t* dst, uint64_t count);
 };
 
 struct ARGB4444 : public PixelCodec {
     virtual uint16_t bpp();
     virtual void decodePixel(uint8_t* src, uint64_t srcIndex, uint8_t* dst, uint64_t dstIndex);
     virtual void encodePixel(uint8_t* src, uint64_t srcIndex, uint8_t* dst, uint64_t dstIndex);
+    virtual void decodeRow(const uint8_t* src, uint8_t* dst, uint64_t count);
+    virtual void encodeRow(const uint8_t* src, uint8_t* dst, uint64_t count);
 };
 
+/**
+ * @brief YUV422, every pair of pixels shares its chroma (U Y0 V Y1).
+ *        decodePixel/encodePixel convert a whole pair.
+ */
 struct YUV422 : public PixelCodec {
     virtual uint16_t bpp();
     virtual void decodePixel(uint8_t* src, uint64_t srcIndex, uint8_t* dst, uint64_t dstIndex);
     virtual void encodePixel(uint8_t* src, uint64_t srcIndex, uint8_t* dst, uint64_t dstIndex);
+    virtual void decodeRow(const uint8_t* src, uint8_t* dst, uint64_t count);
+    virtual void encodeRow(const uint8_t* src, uint8_t* dst, uint64_t count);
 };
 
+/**
+ * @brief Bump map storing the normal as two angles (rotation R and elevation S).
+ */
 struct BUMP88 : public PixelCodec {
     virtual uint16_t bpp();
     virtual void decodePixel(uint8_t* src, uint64_t srcIndex, uint8_t* dst, uint64_t dstIndex);
     virtual void encodePixel(uint8_t* src, uint64_t srcIndex, uint8_t* dst, uint64_t dstIndex);
+    virtual void decodeRow(const uint8_t* src, uint8_t* dst, uint64_t count);
+    virtual void encodeRow(const uint8_t* src, uint8_t* dst, uint64_t count);
 };
 
 struct RGB555 : public PixelCodec {
     virtual uint16_t bpp();
     virtual void decodePixel(uint8_t* src, uint64_t srcIndex, uint8_t* dst, uint64_t dstIndex);
     virtual void encodePixel(uint8_t* src, uint64_t srcIndex, uint8_t* dst, uint64_t dstIndex);
+    virtual void decodeRow(const uint8_t* src, uint8_t* dst, uint64_t count);
+    virtual void encodeRow(const uint8_t* src, uint8_t* dst, uint64_t count);
 };
 
 struct ARGB8888 : public PixelCodec {
     virtual uint16_t bpp();
     virtual void decodePixel(uint8_t* src, uint64_t srcIndex, uint8_t* dst, uint64_t dstIndex);
     virtual void encodePixel(uint8_t* src, uint64_t srcIndex, uint8_t* dst, uint64_t dstIndex);
+    virtual void decodeRow(const uint8_t* src, uint8_t* dst, uint64_t count);
+    virtual void encodeRow(const uint8_t* src, uint8_t* dst, uint64_t count);
 };
 
 }
@@ -1,19 +1,220 @@
 #pragma once
 
 #include <stdint.h>
+#include <array>
+#include <cstring>
+#include <algorithm>
+
+#if defined(__BMI2__)
+    #include <immintrin.h>
+#endif
 
 namespace shendk {
 namespace pvr {
 
-static inline uint64_t* createTwiddleMap(uint64_t size) {
-    uint64_t* twiddleMap = new uint64_t[size];
-    for (uint64_t i = 0; i < size; i++) {
-        twiddleMap[i] = 0;
-        for (uint64_t j = 0, k = 1; k <= i; j++, k <<= 1) {
-            twiddleMap[i] |= (i & k) << j;
+/**
+ * Twiddled (Morton order) textures store pixel (x, y) at ((bits of x) << 1) | (bits of y),
+ * with the bits of each coordinate spread to every other bit position.
+ */
+
+constexpr uint32_t twiddleTableSize = 1024;
+constexpr uint32_t twiddleTileSize = 8; // 8x8 pixels are contiguous in twiddled order
+
+namespace detail {
+
+constexpr std::array<uint32_t, twiddleTableSize> createTwiddleTable() {
+    std::array<uint32_t, twiddleTableSize> table = {};
+    for (uint32_t i = 0; i < twiddleTableSize; i++) {
+        uint32_t value = 0;
+        for (uint32_t bit = 0; (1u << bit) <= i; bit++) {
+            value |= ((i >> bit) & 1) << (bit * 2);
+        }
+        table[i] = value;
+    }
+    return table;
+}
+
+constexpr std::array<uint8_t, twiddleTileSize * twiddleTileSize> createTileTable() {
+    std::array<uint8_t, twiddleTileSize * twiddleTileSize> table = {};
+    std::array<uint32_t, twiddleTableSize> bits = createTwiddleTable();
+    for (uint32_t y = 0; y < twiddleTileSize; y++) {
+        for (uint32_t x = 0; x < twiddleTileSize; x++) {
+            table[y * twiddleTileSize + x] = static_cast<uint8_t>((bits[x] << 1) | bits[y]);
+        }
+    }
+    return table;
+}
+
+}
+
+inline constexpr std::array<uint32_t, twiddleTableSize> twiddleTable = detail::createTwiddleTable();
+
+// twiddled offset of every pixel of a tile in row major order
+inline constexpr std::array<uint8_t, twiddleTileSize * twiddleTileSize> twiddleTileTable = detail::createTileTable();
+
+/**
+ * @brief Spreads the bits of a coordinate to the even bit positions.
+ */
+inline uint32_t twiddleBits(uint32_t value) {
+    if (value < twiddleTableSize) return twiddleTable[value];
+#if defined(__BMI2__)
+    return _pdep_u32(value, 0x55555555);
+#else
+    value &= 0xFFFF;
+    value = (value | (value << 8)) & 0x00FF00FF;
+    value = (value | (value << 4)) & 0x0F0F0F0F;
+    value = (value | (value << 2)) & 0x33333333;
+    value = (value | (value << 1)) & 0x55555555;
+    return value;
+#endif
+}
+
+/**
+ * @brief Twiddled pixel index of (x, y).
+ */
+inline uint32_t twiddleIndex(uint32_t x, uint32_t y) {
+    return (twiddleBits(x) << 1) | twiddleBits(y);
+}
+
+/**
+ * @brief Converts rows [y, y + rows) of a twiddled square of size x size pixels to rows of
+ *        dstStride bytes, dst points to the first converted row. Squares of 8 pixels and more
+ *        are copied in 8x8 tiles, which are contiguous in the source; y and rows must be
+ *        multiples of 8 then.
+ */
+template<uint32_t BytesPerPixel>
+inline void detwiddleRows(const uint8_t* src, uint8_t* dst, int64_t dstStride, uint32_t size, uint32_t y, uint32_t rows) {
+    if (size < twiddleTileSize) {
+        for (uint32_t row = 0; row < rows; row++) {
+            for (uint32_t x = 0; x < size; x++) {
+                memcpy(dst + row * dstStride + x * BytesPerPixel, src + twiddleIndex(x, y + row) * BytesPerPixel, BytesPerPixel);
+            }
+        }
+        return;
+    }
+    const uint32_t tiles = size / twiddleTileSize;
+    const uint32_t tilePixels = twiddleTileSize * twiddleTileSize;
+    for (uint32_t tileY = y / twiddleTileSize; tileY < (y + rows) / twiddleTileSize; tileY++) {
+        uint8_t* band = dst + static_cast<int64_t>(tileY * twiddleTileSize - y) * dstStride;
+        for (uint32_t tileX = 0; tileX < tiles; tileX++) {
+            const uint8_t* tile = src + static_cast<uint64_t>(twiddleIndex(tileX, tileY)) * tilePixels * BytesPerPixel;
+            uint8_t* row = band + (tileX * twiddleTileSize) * BytesPerPixel;
+            for (uint32_t i = 0; i < tilePixels; i++) {
+                uint8_t* pixel = row + static_cast<int64_t>(i / twiddleTileSize) * dstStride + (i % twiddleTileSize) * BytesPerPixel;
+                memcpy(pixel, tile + twiddleTileTable[i] * BytesPerPixel, BytesPerPixel);
+            }
+        }
+    }
+}
+
+/**
+ * @brief Converts a twiddled square of size x size pixels to rows of dstStride bytes.
+ */
+template<uint32_t BytesPerPixel>
+inline void detwiddle(const uint8_t* src, uint8_t* dst, int64_t dstStride, uint32_t size) {
+    detwiddleRows<BytesPerPixel>(src, dst, dstStride, size, 0, size);
+}
+
+/**
+ * @brief Converts rows of srcStride bytes to a twiddled square of size x size pixels.
+ */
+template<uint32_t BytesPerPixel>
+inline void twiddle(const uint8_t* src, uint64_t srcStride, uint8_t* dst, uint32_t size) {
+    if (size < twiddleTileSize) {
+        for (uint32_t y = 0; y < size; y++) {
+            for (uint32_t x = 0; x < size; x++) {
+                memcpy(dst + twiddleIndex(x, y) * BytesPerPixel, src + y * srcStride + x * BytesPerPixel, BytesPerPixel);
+            }
+        }
+        return;
+    }
+    const uint32_t tiles = size / twiddleTileSize;
+    const uint32_t tilePixels = twiddleTileSize * twiddleTileSize;
+    for (uint32_t tileY = 0; tileY < tiles; tileY++) {
+        for (uint32_t tileX = 0; tileX < tiles; tileX++) {
+            uint8_t* tile = dst + static_cast<uint64_t>(twiddleIndex(tileX, tileY)) * tilePixels * BytesPerPixel;
+            const uint8_t* row = src + (tileY * twiddleTileSize) * srcStride + (tileX * twiddleTileSize) * BytesPerPixel;
+            for (uint32_t i = 0; i < tilePixels; i++) {
+                const uint8_t* pixel = row + (i / twiddleTileSize) * srcStride + (i % twiddleTileSize) * BytesPerPixel;
+                memcpy(tile + twiddleTileTable[i] * BytesPerPixel, pixel, BytesPerPixel);
+            }
+        }
+    }
+}
+
+/**
+ * @brief Converts rows [y, y + rows) of a texture made of twiddled squares of min(width, height)
+ *        pixels, stored one after another. The rows must lie within one row of squares,
+ *        see detwiddleRows for the alignment.
+ */
+inline void detwiddleRectangleRows(const uint8_t* src, uint8_t* dst, int64_t dstStride, uint32_t width, uint32_t height,
+                                   uint32_t y, uint32_t rows, uint32_t bytesPerPixel) {
+    uint32_t size = std::min(width, height);
+    uint64_t squareSize = static_cast<uint64_t>(size) * size * bytesPerPixel;
+    uint32_t squaresWide = width / size;
+    src += (y / size) * squaresWide * squareSize;
+    y %= size;
+    for (uint32_t x = 0; x < squaresWide; x++, src += squareSize) {
+        uint8_t* square = dst + x * size * bytesPerPixel;
+        switch (bytesPerPixel) {
+        case 1: detwiddleRows<1>(src, square, dstStride, size, y, rows); break;
+        case 2: detwiddleRows<2>(src, square, dstStride, size, y, rows); break;
+        case 4: detwiddleRows<4>(src, square, dstStride, size, y, rows); break;
+        case 8: detwiddleRows<8>(src, square, dstStride, size, y, rows); break;
+        default:
+            for (uint32_t row = 0; row < rows; row++) {
+                for (uint32_t x2 = 0; x2 < size; x2++) {
+                    memcpy(square + row * dstStride + x2 * bytesPerPixel, src + twiddleIndex(x2, y + row) * bytesPerPixel, bytesPerPixel);
+                }
+            }
+        }
+    }
+}
+
+/**
+ * @brief Converts a texture made of twiddled squares of min(width, height) pixels,
+ *        stored one after another, to linear rows.
+ */
+inline void detwiddleRectangle(const uint8_t* src, uint8_t* dst, uint32_t width, uint32_t height, uint32_t bytesPerPixel) {
+    uint32_t size = std::min(width, height);
+    int64_t stride = static_cast<int64_t>(width) * bytesPerPixel;
+    for (uint32_t y = 0; y < height; y += size) {
+        detwiddleRectangleRows(src, dst + y * stride, stride, width, height, y, size, bytesPerPixel);
+    }
+}
+
+/**
+ * @brief Number of rows detwiddleRectangleRows converts at once for a texture size.
+ */
+inline uint32_t detwiddleBandRows(uint32_t width, uint32_t height) {
+    return std::min(std::min(width, height), twiddleTileSize);
+}
+
+/**
+ * @brief Converts linear rows to twiddled squares of min(width, height) pixels.
+ */
+inline void twiddleRectangle(const uint8_t* src, uint8_t* dst, uint32_t width, uint32_t height, uint32_t bytesPerPixel) {
+    uint32_t size = std::min(width, height);
+    uint64_t stride = static_cast<uint64_t>(width) * bytesPerPixel;
+    uint64_t squareSize = static_cast<uint64_t>(size) * size * bytesPerPixel;
+    for (uint32_t y = 0; y < height; y += size) {
+        for (uint32_t x = 0; x < width; x += size) {
+            const uint8_t* square = src + y * stride + x * bytesPerPixel;
+            switch (bytesPerPixel) {
+            case 1: twiddle<1>(square, stride, dst, size); break;
+            case 2: twiddle<2>(square, stride, dst, size); break;
+            case 4: twiddle<4>(square, stride, dst, size); break;
+            case 8: twiddle<8>(square, stride, dst, size); break;
+            default:
+                for (uint32_t y2 = 0; y2 < size; y2++) {
+                    for (uint32_t x2 = 0; x2 < size; x2++) {
+                        memcpy(dst + twiddleIndex(x2, y2) * bytesPerPixel, square + y2 * stride + x2 * bytesPerPixel, bytesPerPixel);
+                    }
+                }
+            }
+            dst += squareSize;
         }
     }
-    return twiddleMap;
 }
 
 }
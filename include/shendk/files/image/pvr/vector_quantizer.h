@@ -3,22 +3,52 @@
 #include <stdint.h>
 #include <vector>
 
-#include "shendk/types/image.h"
-
 namespace shendk {
 namespace pvr {
 
-// TODO: cleanup parameter mess (blockWidth, blockHeight)
-// TODO: add dynamic pixel format (RGBA, RGB)
+/**
+ * @brief Blocks of blockWidth x blockHeight BGRA8888 texels (row major) taken from linear images,
+ *        the input of the vector quantizer. Images smaller than a block repeat their edge texels.
+ */
+struct VQBlocks {
+
+    VQBlocks(uint8_t blockWidth = 2, uint8_t blockHeight = 2);
+
+    /**
+     * @brief Appends the blocks of an image with linear BGRA8888 rows, row by row.
+     */
+    void add(const uint8_t* bgra, uint32_t width, uint32_t height);
+
+    inline uint32_t blockSize() const { return blockWidth * blockHeight * 4; }
+    inline uint64_t count() const { return texels.size() / blockSize(); }
+    inline const uint8_t* block(uint64_t index) const { return texels.data() + index * blockSize(); }
+
+    uint8_t blockWidth;
+    uint8_t blockHeight;
+    std::vector<uint8_t> texels;
+};
+
+/**
+ * @brief k-means settings of createCodeBook.
+ */
+struct VQOptions {
+    uint32_t maxIterations = 32;    // Lloyd iterations after seeding
+    float tolerance = 1e-4f;        // stop once the error improves by less than this fraction
+    uint64_t sampleSize = 1 << 16;  // blocks the code book is trained on, evenly spread (0 = all)
+    uint32_t seed = 0x5EED;         // seeding is reproducible for a seed
+    unsigned threads = 0;           // 0 uses all cores
+};
 
-struct VQBlock;
+/**
+ * @brief Clusters the blocks to a code book of codeBookSize blocks
+ *        (k-means++ seeding and Lloyd iterations on the squared error).
+ */
+std::vector<uint8_t> createCodeBook(const VQBlocks& blocks, uint32_t codeBookSize, const VQOptions& options = VQOptions());
 
-static int nearest(const VQBlock& block, VQBlock* cluster, int clusterSize, double& nearestDistance);
-static std::vector<VQBlock> createBlocks(Image& image, int blockWidth = 2, int blockHeight = 2);
-static std::vector<VQBlock> initializeCodeBook(std::vector<VQBlock> imageBlocks, int codeBookSize, bool fastInitialization = false);
-static std::vector<VQBlock> createCodebook(Image& image, int codeBookSize, int blockWidth = 2, int blockHeight = 2);
-static uint8_t* quantizeImage(Image& image, std::vector<VQBlock> codeBook, uint8_t blockSize);
-static uint8_t* quantizeImage(Image& image, uint32_t codeBookSize, uint8_t blockSize, uint8_t pixelSize);
+/**
+ * @brief Index of the nearest code book entry (up to 256) for every block.
+ */
+std::vector<uint8_t> quantize(const VQBlocks& blocks, const std::vector<uint8_t>& codeBook, unsigned threads = 0);
 
 }
 }
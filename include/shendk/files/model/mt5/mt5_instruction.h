@@ -5,6 +5,7 @@
 #include <vector>
 
 #include "shendk/types/model.h"
+#include "shendk/utils/binary_reader.h"
 
 namespace shendk {
 namespace mt5 {
@@ -44,25 +45,25 @@ struct Instruction {
 
     Instruction();
     Instruction(InstructionType t);
-    Instruction(std::istream& stream);
+    Instruction(BinaryReader& reader);
     virtual ~Instruction();
 
-    void read(std::istream& stream);
+    void read(BinaryReader& reader);
     void write(std::ostream& stream);
 
 protected:
-    virtual void _read(std::istream&) = 0;
+    virtual void _read(BinaryReader&) = 0;
     virtual void _write(std::ostream&) = 0;
     InstructionType type;
 };
 
 struct InBasic : public Instruction {
     InBasic();
-    InBasic(std::istream& stream);
+    InBasic(BinaryReader& reader);
     virtual ~InBasic();
 
 protected:
-    virtual void _read(std::istream& stream);
+    virtual void _read(BinaryReader& reader);
     virtual void _write(std::ostream& stream);
 };
 
@@ -70,7 +71,7 @@ protected:
 struct InAttributes : public Instruction {
 
     InAttributes();
-    InAttributes(std::istream& stream);
+    InAttributes(BinaryReader& reader);
     virtual ~InAttributes();
 
     bool isUVH();
@@ -78,7 +79,7 @@ struct InAttributes : public Instruction {
     bool mirrorV();
 
 protected:
-    virtual void _read(std::istream& stream);
+    virtual void _read(BinaryReader& reader);
     virtual void _write(std::ostream& stream);
 
     uint16_t size = 0;
@@ -88,39 +89,39 @@ protected:
 struct InUnknown1 : public Instruction {
 
     InUnknown1();
-    InUnknown1(std::istream& stream);
+    InUnknown1(BinaryReader& reader);
     virtual ~InUnknown1();
 
     uint16_t value = 0;
 
 protected:
-    virtual void _read(std::istream& stream);
+    virtual void _read(BinaryReader& reader);
     virtual void _write(std::ostream& stream);
 };
 
 struct InTexture : public Instruction {
 
     InTexture();
-    InTexture(std::istream& stream);
+    InTexture(BinaryReader& reader);
     virtual ~InTexture();
 
     uint16_t textureIndex = 0;
 
 protected:
-    virtual void _read(std::istream& stream);
+    virtual void _read(BinaryReader& reader);
     virtual void _write(std::ostream& stream);
 };
 
 struct InUvSize : public Instruction {
 
     InUvSize();
-    InUvSize(std::istream& stream);
+    InUvSize(BinaryReader& reader);
     virtual ~InUvSize();
 
     uint16_t uvSize = 0;
 
 protected:
-    virtual void _read(std::istream& stream);
+    virtual void _read(BinaryReader& reader);
     virtual void _write(std::ostream& stream);
 };
 
@@ -131,13 +132,13 @@ struct InUnknown2 : public Instruction {
     };
 
     InUnknown2();
-    InUnknown2(std::istream& stream);
+    InUnknown2(BinaryReader& reader);
     virtual ~InUnknown2();
 
     InUnknown2::Data data;
 
 protected:
-    virtual void _read(std::istream& stream);
+    virtual void _read(BinaryReader& reader);
     virtual void _write(std::ostream& stream);
 };
 
@@ -152,7 +153,7 @@ struct State {
 struct InStrip : public Instruction {
 
     InStrip();
-    InStrip(std::istream& stream, MT5Mesh* mesh);
+    InStrip(BinaryReader& reader, MT5Mesh* mesh);
     virtual ~InStrip();
 
     uint16_t unknown;
@@ -160,7 +161,7 @@ struct InStrip : public Instruction {
     std::vector<MeshSurface> surfaces;
 
 protected:
-    virtual void _read(std::istream& stream);
+    virtual void _read(BinaryReader& reader);
     virtual void _write(std::ostream& stream);
 
 private:
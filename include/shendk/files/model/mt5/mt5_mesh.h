@@ -20,10 +20,10 @@ struct MT5Mesh : public NodeMesh {
     };
 
     MT5Mesh(MT5Node* node);
-    MT5Mesh(MT5Node* node, std::istream& stream);
+    MT5Mesh(MT5Node* node, BinaryReader& reader);
     ~MT5Mesh();
 
-    void read(std::istream& stream);
+    void read(BinaryReader& reader);
     void write(std::ostream& stream);
 
     MT5Mesh::Header header;
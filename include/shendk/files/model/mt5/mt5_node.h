@@ -1,6 +1,7 @@
 #pragma once
 
 #include "shendk/types/model.h"
+#include "shendk/utils/binary_reader.h"
 
 namespace shendk {
 namespace mt5 {
@@ -29,10 +30,10 @@ struct MT5Node : public ModelNode {
     };
 
     MT5Node(Model* model, MT5Node* parent = nullptr);
-    MT5Node(Model* model, std::istream& stream, int64_t baseOffset, MT5Node* parent = nullptr);
+    MT5Node(Model* model, BinaryReader& reader, MT5Node* parent = nullptr);
     virtual ~MT5Node();
 
-    void read(std::istream& stream , int64_t baseOffset);
+    void read(BinaryReader& reader);
     void write(std::ostream& stream);
 
     MT5Node::Data data;
@@ -1,6 +1,7 @@
 #pragma once
 
 #include <stdint.h>
+#include <memory>
 #include <vector>
 
 namespace shendk {
@@ -32,6 +33,21 @@ struct RGBA {
     RGBA& operator/=(const RGBA& rhs);
 };
 
+/**
+ * @brief Reconstruction filters of the image resampler.
+ */
+enum class ResampleFilter {
+    Box,        // average of the covered texels, nearest neighbour when upscaling
+    Triangle,   // bilinear, widened when downscaling
+    Lanczos3    // sharpest, may ring at hard edges
+};
+
+struct ResampleOptions {
+    ResampleFilter filter = ResampleFilter::Triangle;
+    bool srgb = false;      // filter the color channels in linear light, alpha stays linear
+    unsigned threads = 0;   // 0 uses all cores
+};
+
 struct Image {
 
     Image(Image& image);
@@ -57,7 +73,18 @@ struct Image {
     void flipHorizontal();
     Image mirrorRepeat();
     void writeImage(Image& src, int srcX, int srcY, int dstX, int dstY, int width, int height);
-    Image* resize(uint32_t width, uint32_t height);
+
+    /**
+     * @brief Resampled copy of the image (separable filter, edges are clamped).
+     */
+    Image* resize(uint32_t width, uint32_t height, const ResampleOptions& options = ResampleOptions()) const;
+
+    /**
+     * @brief Mipmaps below the image down to 1x1, each level half the size of the one before (at least 1).
+     *        Levels are filtered from their predecessor at full precision, only their results are rounded.
+     */
+    std::vector<std::shared_ptr<Image>> buildMipChain(const ResampleOptions& options = ResampleOptions()) const;
+
     std::vector<BGRA> createBGRA8();
 
 protected:
@@ -0,0 +1,156 @@
+#pragma once
+
+#include <stdint.h>
+#include <cstring>
+#include <algorithm>
+#include <string>
+#include <vector>
+#include <istream>
+#include <type_traits>
+
+#include "shendk/utils/memory_view.h"
+
+namespace shendk {
+
+/**
+ * @brief Bounds-checked read cursor over a block of memory.
+ *        Like std::istream a failed read (out of bounds) zero fills the value,
+ *        clears good() and keeps failing until clear() is called.
+ */
+struct BinaryReader {
+
+    BinaryReader() = default;
+
+    BinaryReader(const uint8_t* data, uint64_t size)
+        : m_data(data)
+        , m_size(size)
+    {}
+
+    BinaryReader(MemoryView view)
+        : m_data(reinterpret_cast<const uint8_t*>(view.data))
+        , m_size(view.size)
+    {}
+
+    /**
+     * @brief Creates a reader over at most maxSize bytes of a stream's remaining content.
+     *        Memory backed streams are referenced directly, any other stream
+     *        is read once into the given storage. Reader offsets are relative
+     *        to the current stream position.
+     */
+    static BinaryReader fromStream(std::istream& stream, std::vector<uint8_t>& storage, uint64_t maxSize = UINT64_MAX) {
+        int64_t position = stream.tellg();
+        MemoryView memory = getMemoryView(stream);
+        if (memory && position >= 0) {
+            return BinaryReader(memory.sub(static_cast<uint64_t>(position), maxSize));
+        }
+        stream.seekg(0, std::ios::end);
+        int64_t end = stream.tellg();
+        stream.seekg(position, std::ios::beg);
+        uint64_t remaining = static_cast<uint64_t>(std::max<int64_t>(end - position, 0));
+        storage.resize(static_cast<size_t>(std::min(remaining, maxSize)));
+        stream.read(reinterpret_cast<char*>(storage.data()), storage.size());
+        stream.seekg(position, std::ios::beg);
+        return BinaryReader(storage.data(), storage.size());
+    }
+
+    template<typename T>
+    inline T read() {
+        static_assert(std::is_trivially_copyable<T>::value, "BinaryReader can only read trivially copyable types");
+        T value;
+        readRaw(&value, sizeof(T));
+        return value;
+    }
+
+    template<typename T>
+    inline T peek() const {
+        static_assert(std::is_trivially_copyable<T>::value, "BinaryReader can only read trivially copyable types");
+        T value;
+        if (m_good && sizeof(T) <= m_size - m_position) {
+            std::memcpy(&value, m_data + m_position, sizeof(T));
+        } else {
+            std::memset(&value, 0, sizeof(T));
+        }
+        return value;
+    }
+
+    template<typename T>
+    inline void readArray(T* destination, uint64_t count) {
+        static_assert(std::is_trivially_copyable<T>::value, "BinaryReader can only read trivially copyable types");
+        readRaw(destination, count * sizeof(T));
+    }
+
+    template<typename T>
+    inline std::vector<T> readArray(uint64_t count) {
+        std::vector<T> values(count);
+        readArray(values.data(), count);
+        return values;
+    }
+
+    inline void readRaw(void* destination, uint64_t size) {
+        if (m_good && size <= m_size - m_position) {
+            std::memcpy(destination, m_data + m_position, size);
+            m_position += size;
+        } else {
+            std::memset(destination, 0, size);
+            m_position = m_size;
+            m_good = false;
+        }
+    }
+
+    /**
+     * @brief Reads a null terminated string.
+     */
+    inline std::string readString() {
+        if (!m_good) return std::string();
+        const uint8_t* begin = m_data + m_position;
+        const void* terminator = std::memchr(begin, 0, m_size - m_position);
+        if (!terminator) {
+            std::string str(reinterpret_cast<const char*>(begin), m_size - m_position);
+            m_position = m_size;
+            return str;
+        }
+        uint64_t length = static_cast<const uint8_t*>(terminator) - begin;
+        m_position += length + 1;
+        return std::string(reinterpret_cast<const char*>(begin), length);
+    }
+
+    inline void seek(uint64_t position) {
+        if (position > m_size) {
+            m_position = m_size;
+            m_good = false;
+        } else {
+            m_position = position;
+        }
+    }
+
+    inline void skip(int64_t offset) {
+        seek(m_position + offset);
+    }
+
+    /**
+     * @brief Creates an independent reader over a range of this reader.
+     */
+    inline BinaryReader subReader(uint64_t offset, uint64_t size) const {
+        if (offset > m_size) return BinaryReader();
+        return BinaryReader(m_data + offset, std::min(size, m_size - offset));
+    }
+
+    inline uint64_t tell() const { return m_position; }
+    inline uint64_t size() const { return m_size; }
+    inline uint64_t remaining() const { return m_size - m_position; }
+    inline bool eof() const { return m_position >= m_size; }
+    inline bool good() const { return m_good; }
+    inline void clear() { m_good = true; }
+
+    inline const uint8_t* data() const { return m_data; }
+    inline const uint8_t* current() const { return m_data + m_position; }
+    inline MemoryView view() const { return MemoryView(reinterpret_cast<const char*>(m_data), m_size); }
+
+private:
+    const uint8_t* m_data = nullptr;
+    uint64_t m_size = 0;
+    uint64_t m_position = 0;
+    bool m_good = true;
+};
+
+}
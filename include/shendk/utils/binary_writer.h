@@ -0,0 +1,110 @@
+#pragma once
+
+#include <stdint.h>
+#include <cstring>
+#include <string>
+#include <vector>
+#include <ostream>
+#include <type_traits>
+
+namespace shendk {
+
+/**
+ * @brief Growable write cursor over a memory buffer.
+ *        Seeking beyond the end zero fills the gap on the next write.
+ */
+struct BinaryWriter {
+
+    BinaryWriter() = default;
+
+    BinaryWriter(uint64_t capacity) {
+        m_buffer.reserve(capacity);
+    }
+
+    template<typename T>
+    inline void write(const T& value) {
+        static_assert(std::is_trivially_copyable<T>::value, "BinaryWriter can only write trivially copyable types");
+        writeRaw(&value, sizeof(T));
+    }
+
+    template<typename T>
+    inline void writeArray(const T* values, uint64_t count) {
+        static_assert(std::is_trivially_copyable<T>::value, "BinaryWriter can only write trivially copyable types");
+        writeRaw(values, count * sizeof(T));
+    }
+
+    template<typename T>
+    inline void writeArray(const std::vector<T>& values) {
+        writeArray(values.data(), values.size());
+    }
+
+    inline void writeRaw(const void* source, uint64_t size) {
+        uint64_t end = m_position + size;
+        if (end > m_buffer.size()) {
+            m_buffer.resize(end);
+        }
+        if (size) {
+            std::memcpy(m_buffer.data() + m_position, source, size);
+        }
+        m_position = end;
+    }
+
+    /**
+     * @brief Writes a null terminated string.
+     */
+    inline void writeString(const std::string& str) {
+        writeRaw(str.c_str(), str.size() + 1);
+    }
+
+    /**
+     * @brief Pads the buffer with zeros up to the next multiple of alignment.
+     */
+    inline void align(uint64_t alignment) {
+        uint64_t remainder = m_position % alignment;
+        if (remainder == 0) return;
+        uint64_t padding = alignment - remainder;
+        if (m_position + padding > m_buffer.size()) {
+            m_buffer.resize(m_position + padding);
+        } else {
+            std::memset(m_buffer.data() + m_position, 0, padding);
+        }
+        m_position += padding;
+    }
+
+    inline void seek(uint64_t position) {
+        if (position > m_buffer.size()) {
+            m_buffer.resize(position);
+        }
+        m_position = position;
+    }
+
+    inline void reserve(uint64_t capacity) { m_buffer.reserve(capacity); }
+
+    inline uint64_t tell() const { return m_position; }
+    inline uint64_t size() const { return m_buffer.size(); }
+    inline const uint8_t* data() const { return m_buffer.data(); }
+    inline uint8_t* data() { return m_buffer.data(); }
+
+    /**
+     * @brief Writes the whole buffer to a stream.
+     */
+    inline void flush(std::ostream& stream) const {
+        stream.write(reinterpret_cast<const char*>(m_buffer.data()), m_buffer.size());
+    }
+
+    /**
+     * @brief Hands the buffer over to the caller and resets the writer.
+     */
+    inline std::vector<uint8_t> release() {
+        std::vector<uint8_t> buffer = std::move(m_buffer);
+        m_buffer.clear();
+        m_position = 0;
+        return buffer;
+    }
+
+private:
+    std::vector<uint8_t> m_buffer;
+    uint64_t m_position = 0;
+};
+
+}
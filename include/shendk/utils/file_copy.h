@@ -0,0 +1,42 @@
+#pragma once
+
+#include <stdint.h>
+#include <string>
+
+#include "shendk/utils/memory_view.h"
+
+namespace shendk {
+
+/**
+ * @brief Copies byte ranges of a source file into new files.
+ *        Uses kernel side copies (copy_file_range, sendfile) where available
+ *        and falls back to buffered positional reads. Safe to use from
+ *        multiple threads at once.
+ */
+struct FileCopier {
+
+    FileCopier(const std::string& source);
+    ~FileCopier();
+
+    FileCopier(const FileCopier&) = delete;
+    FileCopier& operator=(const FileCopier&) = delete;
+
+    bool isOpen() const;
+
+    /**
+     * @brief Copies size bytes at offset of the source file to destination.
+     * @return False if the destination couldn't be written completely.
+     */
+    bool copy(uint64_t offset, uint64_t size, const std::string& destination) const;
+
+    /**
+     * @brief Writes a block of memory to a file.
+     */
+    static bool writeFile(const std::string& destination, MemoryView data);
+
+private:
+    std::string m_source;
+    int m_fd = -1;
+};
+
+}
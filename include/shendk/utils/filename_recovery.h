@@ -0,0 +1,78 @@
+#pragma once
+
+#include <stdint.h>
+#include <map>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "shendk/files/container/tad.h"
+
+namespace shendk {
+
+/**
+ * @brief Recovers unknown TAD filenames by hashing generated candidate paths.
+ *
+ * Patterns are literal text with placeholders:
+ *   {name}       every word of the wordlist registered as name
+ *   {0000-0999}  every number in the range, zero padded to the width of the first bound
+ * e.g. "/data/scene/{0001-0099}/{maps}.mt5"
+ */
+struct FilenameRecovery {
+
+    struct Match {
+        uint32_t entryIndex;
+        uint32_t hash1;
+        uint32_t hash2;
+        std::string filepath;
+        bool hash2Confirmed; // the candidate's MurmurHash2::hashFilenameSecond equals hash2, the scheme itself is unconfirmed
+    };
+
+    /**
+     * @param onlyUnknown Only look for entries the HashDB has no name for.
+     */
+    FilenameRecovery(const TAD& tad, bool onlyUnknown = true);
+
+    void addWordlist(const std::string& name, const std::vector<std::string>& words);
+
+    /**
+     * @brief Loads a wordlist with one word per line.
+     */
+    bool loadWordlist(const std::string& name, const std::string& filepath);
+
+    /**
+     * @brief Returns the number of candidates a pattern expands to.
+     */
+    uint64_t candidateCount(const std::string& pattern) const;
+
+    /**
+     * @brief Hashes all candidates of a pattern on all cores and returns the matching entries.
+     */
+    std::vector<Match> search(const std::string& pattern, unsigned threads = 0) const;
+    std::vector<Match> search(const std::vector<std::string>& candidates, unsigned threads = 0) const;
+
+    size_t targetCount() const;
+
+    bool toLower = true;
+
+private:
+    struct Segment {
+        std::string literal;
+        const std::vector<std::string>* words = nullptr;
+        uint64_t rangeBegin = 0;
+        uint64_t rangeSize = 0;
+        size_t width = 0;
+
+        uint64_t size() const;
+        void append(std::string& output, uint64_t index) const;
+    };
+
+    std::vector<Segment> parse(const std::string& pattern) const;
+    void check(const std::string_view* candidates, const uint32_t* hashes, size_t count, std::vector<Match>& matches) const;
+
+    const TAD& m_tad;
+    std::unordered_map<uint32_t, std::vector<uint32_t>> m_targets; // hash1 -> entry indices
+    std::map<std::string, std::vector<std::string>> m_wordlists;
+};
+
+}
@@ -0,0 +1,86 @@
+#pragma once
+
+#include <istream>
+#include <memory>
+#include <streambuf>
+#include <vector>
+
+#include "shendk/utils/zstream_pool.h"
+
+namespace shendk { struct GZIndex; }
+
+
+/**
+ * @brief Input stream buffer that inflates gzip data from another stream in fixed size windows.
+ *        Positions are relative to the start of the decompressed data. Forward seeks inflate
+ *        and discard, backward seeks outside the current window restart from the beginning.
+ *        With a GZIndex, seeks start inflating at the closest checkpoint instead.
+ */
+class gz_istreambuf : public std::streambuf
+{
+public:
+
+    /**
+     * @param source Stream holding the compressed data, must outlive the buffer.
+     * @param offset Offset of the gzip data in the source, -1 uses the current position.
+     * @param windowSize Size of the compressed and decompressed windows.
+     * @param index Optional checkpoint index of the data, must outlive the buffer.
+     */
+    gz_istreambuf(std::istream& source, std::streamoff offset = -1, size_t windowSize = 1 << 16,
+                  const shendk::GZIndex* index = nullptr);
+    ~gz_istreambuf();
+
+    gz_istreambuf(const gz_istreambuf&) = delete;
+    gz_istreambuf& operator=(const gz_istreambuf&) = delete;
+
+    /**
+     * @brief Returns false if the data couldn't be inflated.
+     */
+    bool isValid() const;
+
+    /**
+     * @brief Number of times the stream had to restart to serve a backward seek.
+     */
+    size_t restarts() const;
+
+protected:
+    int_type underflow();
+    pos_type seekoff(off_type off, std::ios_base::seekdir dir,
+                     std::ios_base::openmode mode = std::ios_base::in | std::ios_base::out);
+    pos_type seekpos(pos_type pos, std::ios_base::openmode mode = std::ios_base::in | std::ios_base::out);
+
+private:
+    bool restart();
+    bool jump(uint64_t position);
+    bool nextMember();
+    bool fill();
+    pos_type seekTo(uint64_t position);
+
+    std::istream& m_source;
+    std::streamoff m_offset;
+    shendk::ZStreamPool::Lease m_context; // pooled z_stream and windows
+    size_t m_windowSize;
+    const shendk::GZIndex* m_index;
+    bool m_raw = false; // inflating raw deflate data after jumping to a checkpoint
+    uint64_t m_windowPosition = 0; // decompressed offset of the current window
+    bool m_end = false;
+    bool m_good = false;
+    size_t m_restarts = 0;
+};
+
+
+/**
+ * @brief Input stream reading gzip data through gz_istreambuf.
+ */
+struct igzstream
+    : virtual gz_istreambuf
+    , std::istream
+{
+    igzstream(std::istream& source, std::streamoff offset = -1, size_t windowSize = 1 << 16,
+              const shendk::GZIndex* index = nullptr)
+        : gz_istreambuf(source, offset, windowSize, index)
+        , std::istream(static_cast<gz_istreambuf*>(this))
+    {
+        if (!gz_istreambuf::isValid()) setstate(std::ios::badbit);
+    }
+};
@@ -1,16 +1,27 @@
 #pragma once
 
 #include <stdint.h>
+#include <atomic>
 #include <fstream>
 #include <iostream>
+#include <memory>
 #include <mutex>
+#include <string>
+#include <string_view>
 #include <vector>
 
 #include "shendk/utils/singleton.h"
 
 namespace shendk {
 
+/**
+ * @brief Maps TAD hashes to file paths.
+ *        Lookups go through an immutable open addressing index and need no lock.
+ *        The index can be saved as a compiled database that is loaded by mapping it.
+ */
 struct HashDB : public Singleton<HashDB> {
+    const static uint32_t signature = 0x42444853; // "SHDB"
+    const static uint32_t version = 1;
 
     struct Entry {
         uint32_t hash1;
@@ -19,14 +30,37 @@ struct HashDB : public Singleton<HashDB> {
     };
 
     HashDB();
+    ~HashDB();
 
+    /**
+     * @brief Loads a json database or a compiled database (detected by its signature).
+     */
     bool initialize(const std::string& filepath);
-    std::string getFilepath(uint32_t hash1, uint32_t hash2 = 0);
+    bool initialize(const std::vector<HashDB::Entry>& entries);
+
+    /**
+     * @brief Writes the loaded entries as a compiled database.
+     */
+    bool compile(const std::string& filepath) const;
+
+    std::string getFilepath(uint32_t hash1, uint32_t hash2 = 0) const;
+
+    /**
+     * @brief Same as getFilepath without copying the path. Stays valid as long as the database.
+     */
+    std::string_view findFilepath(uint32_t hash1, uint32_t hash2 = 0) const;
+
+    size_t size() const;
+    bool isInitialized() const;
 
 private:
-    std::mutex m_mutex;
-    std::vector<HashDB::Entry> m_entries;
-    bool m_initialized;
+    struct Index;
+
+    void publish(std::unique_ptr<Index> index);
+
+    std::atomic<const Index*> m_index;
+    std::mutex m_mutex; // only serializes initialization
+    std::vector<std::unique_ptr<Index>> m_indices; // replaced indices stay alive for running readers
 };
 
 
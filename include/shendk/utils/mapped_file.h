@@ -0,0 +1,39 @@
+#pragma once
+
+#include <stdint.h>
+#include <string>
+
+#include "shendk/utils/memory_view.h"
+
+namespace shendk {
+
+/**
+ * @brief Read-only memory mapping of a file.
+ */
+struct MappedFile {
+
+    MappedFile();
+    MappedFile(const std::string& filepath);
+    ~MappedFile();
+
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    bool open(const std::string& filepath);
+    void close();
+
+    bool isOpen() const;
+    const char* data() const;
+    uint64_t size() const;
+    MemoryView view() const;
+
+private:
+    const char* m_data = nullptr;
+    uint64_t m_size = 0;
+#if defined(_WIN32)
+    void* m_file = nullptr;
+    void* m_mapping = nullptr;
+#endif
+};
+
+}
@@ -0,0 +1,52 @@
+#pragma once
+
+#include <stdint.h>
+#include <istream>
+#include <algorithm>
+
+#include "shendk/utils/memstream.h"
+
+namespace shendk {
+
+/**
+ * @brief Non-owning view of a contiguous block of memory.
+ */
+struct MemoryView {
+
+    MemoryView() = default;
+    MemoryView(const char* _data, uint64_t _size)
+        : data(_data)
+        , size(_size)
+    {}
+
+    const char* begin() const { return data; }
+    const char* end() const { return data + size; }
+    bool empty() const { return data == nullptr; }
+    explicit operator bool() const { return data != nullptr; }
+
+    bool contains(const MemoryView& other) const {
+        return data && other.data >= begin() && other.end() <= end();
+    }
+
+    MemoryView sub(uint64_t offset, uint64_t length) const {
+        if (!data || offset > size) return MemoryView();
+        return MemoryView(data + offset, std::min(length, size - offset));
+    }
+
+    const char* data = nullptr;
+    uint64_t size = 0;
+};
+
+/**
+ * @brief Returns the memory backing an in-memory stream.
+ *        Returns an empty view for any other stream type.
+ */
+static inline MemoryView getMemoryView(std::istream& stream) {
+    mstreambuf* buffer = dynamic_cast<mstreambuf*>(stream.rdbuf());
+    if (!buffer) return MemoryView();
+    size_t bufferSize = 0;
+    char* data = buffer->getInputBuffer(bufferSize);
+    return MemoryView(data, bufferSize);
+}
+
+}
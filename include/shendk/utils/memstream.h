@@ -6,12 +6,17 @@
 
 #include <iostream>
 
+#include <algorithm>
+#include <climits>
 #include <cstring>
+#include <memory>
+#include <vector>
 
 
 /**
  * @brief Memory stream buffer that is based on the standard library stream buffer.
- *        Allocates memory dynamically when needed.
+ *        Allocates memory dynamically when needed, growing geometrically without
+ *        zero filling. Seeking the output position beyond the end zero fills the gap.
  */
 template<typename CharT = char, typename traits_type = std::char_traits<CharT>>
 class basic_mstreambuf : public std::basic_streambuf<CharT>
@@ -23,142 +28,190 @@ public:
     using pos_type = typename Base::pos_type;
     using off_type = typename Base::off_type;
 
-    basic_mstreambuf() {
+    static constexpr size_t minimumCapacity = 64;
+
+    basic_mstreambuf()
+        : basic_mstreambuf(static_cast<size_t>(0))
+    {}
+
+    /**
+     * @brief Creates an empty owning buffer.
+     * @param capacity Number of characters to reserve up front.
+     */
+    explicit basic_mstreambuf(size_t capacity) {
         m_bufferOwner = true;
-        m_buffer = new char_type[4];
-        m_bufferSize = 4;
-        std::memset(m_buffer, 0, 4);
+        m_buffer = nullptr;
+        m_bufferSize = 0;
+        m_size = 0;
+        reserve(capacity);
         setOut(m_buffer, m_buffer, m_buffer + m_bufferSize);
-        setIn(m_buffer, m_buffer, m_buffer + m_bufferSize);
+        setIn(m_buffer, m_buffer, m_buffer);
     }
 
+    /**
+     * @brief Wraps existing memory without taking ownership. The buffer can't grow.
+     */
     basic_mstreambuf(char_type* buffer, size_t size) {
-        m_bufferOwner = false; // TODO: take ownership of memory?
+        m_bufferOwner = false;
         m_buffer = buffer;
         m_bufferSize = size;
-        setOut(m_buffer, m_buffer + m_bufferSize, m_buffer + m_bufferSize);
-        setIn(m_buffer, m_buffer, m_buffer + m_bufferSize);
+        m_size = size;
+        setOut(m_buffer, m_buffer, m_buffer + m_bufferSize);
+        setIn(m_buffer, m_buffer, m_buffer + m_size);
     }
 
+    basic_mstreambuf(const basic_mstreambuf&) = delete;
+    basic_mstreambuf& operator=(const basic_mstreambuf&) = delete;
+
     ~basic_mstreambuf() {
         if (m_bufferOwner) {
             delete[] m_buffer;
         }
     }
 
-    int overflow( int c = EOF )
+    /**
+     * @brief Makes sure the buffer can hold at least capacity characters.
+     */
+    void reserve(size_t capacity) {
+        if (capacity <= m_bufferSize || !m_bufferOwner) return;
+        syncSize();
+        size_t inCurOffset = static_cast<size_t>(in_cur() - in_beg());
+        size_t outCurOffset = static_cast<size_t>(out_cur() - out_beg());
+        char_type* temp = new char_type[capacity];
+        if (m_size) {
+            std::memcpy(temp, m_buffer, m_size * sizeof(char_type));
+        }
+        delete[] m_buffer;
+        m_buffer = temp;
+        m_bufferSize = capacity;
+        setOut(m_buffer, m_buffer + outCurOffset, m_buffer + m_bufferSize);
+        setIn(m_buffer, m_buffer + inCurOffset, m_buffer + m_size);
+    }
+
+    int_type overflow(int_type c = traits_type::eof())
     {
-        if (out_cur() >= out_beg() + m_bufferSize) {
-            size_t oldSize = m_bufferSize;
-            m_bufferSize = m_bufferSize << 1;
-            if (m_bufferSize >= SIZE_MAX) {
-                return Base::overflow(c);
-            } else {
-                // allocate more memory
-                CharT* temp = new CharT[m_bufferSize];
-                memcpy(temp, m_buffer, oldSize);
-                delete[] m_buffer;
-                m_buffer = temp;
-                setOut(m_buffer, m_buffer + oldSize, m_buffer + m_bufferSize);
-                int inCurOffset = static_cast<int>(in_cur() - in_beg());
-                setIn(m_buffer, m_buffer + inCurOffset, m_buffer + m_bufferSize);
-                std::memset(m_buffer + oldSize, 0, m_bufferSize - oldSize);
+        if (traits_type::eq_int_type(c, traits_type::eof())) {
+            return traits_type::not_eof(c);
+        }
+        if (out_cur() >= out_end()) {
+            if (!grow(static_cast<size_t>(out_cur() - out_beg()) + 1)) {
+                return traits_type::eof();
             }
-        } else {
-            setIn(in_beg(), in_cur(), in_end() + 1);
-            setOut(out_beg(), out_cur(), out_end() + 1);
         }
 
         // write character
-        *out_cur() = static_cast<char_type>(c);
+        *out_cur() = traits_type::to_char_type(c);
         Base::pbump(1);
         return c;
     }
 
-    int underflow() {
+    std::streamsize xsputn(const char_type* s, std::streamsize n) {
+        if (n <= 0) return 0;
+        size_t position = static_cast<size_t>(out_cur() - out_beg());
+        size_t count = static_cast<size_t>(n);
+        if (position + count > m_bufferSize && !grow(position + count)) {
+            count = m_bufferSize - position;
+        }
+        std::memcpy(out_cur(), s, count * sizeof(char_type));
+        setOut(out_beg(), out_cur() + count, out_end());
+        return static_cast<std::streamsize>(count);
+    }
+
+    int_type underflow() {
+        syncSize();
+        if (in_cur() < m_buffer + m_size) {
+            setIn(m_buffer, in_cur(), m_buffer + m_size);
+            return traits_type::to_int_type(*in_cur());
+        }
         return traits_type::eof();
     }
 
     pos_type seekoff(off_type off, std::ios_base::seekdir dir,
                      std::ios_base::openmode mode = std::ios_base::in | std::ios_base::out)
     {
-        if (dir == std::ios_base::beg) {
-            if (in_beg() + off > in_end() ||
-                in_beg() + off < in_beg()) {
-                return -1;
-            }
-            if (mode == std::ios_base::in) {
-                setIn(in_beg(), in_beg() + off, in_end());
-                return in_cur() - in_beg();
-            }
-            if (mode == std::ios_base::out) {
-                setOut(out_beg(), out_beg() + off, out_end());
-                return out_cur() - out_beg();
-            }
-        } else if (dir == std::ios_base::cur) {
-            if (mode == std::ios_base::in) {
-                if (in_cur() + off > in_end() ||
-                    in_cur() + off < in_beg()) {
-                    return -1;
-                }
-                setIn(in_beg(), in_cur() + off, in_end());
-                return in_cur() - in_beg();
-            }
-            if (mode == std::ios_base::out) {
-                if (out_cur() + off > out_end() ||
-                    out_cur() + off < out_beg()) {
-                    return -1;
-                }
-                setOut(out_beg(), out_cur() + off, out_end());
-                return out_cur() - out_beg();
-            }
+        syncSize();
+        off_type base = 0;
+        if (dir == std::ios_base::cur) {
+            base = (mode & std::ios_base::in) ? in_cur() - in_beg() : out_cur() - out_beg();
         } else if (dir == std::ios_base::end) {
-            if (in_end() - off > in_end() ||
-                in_end() - off < in_beg()) {
-				return -1;
-			}
-            if (mode == std::ios_base::in) {
-                setIn(in_beg(), in_end() - off, in_end());
-                return in_cur() - in_beg();
-            }
-            if (mode == std::ios_base::out) {
-                setOut(out_beg(), out_end() - off, out_end());
-                return out_cur() - out_beg();
-            }
+            base = static_cast<off_type>(m_size);
         }
-        return 0;
+        return seekpos(pos_type(base + off), mode);
     }
 
     pos_type seekpos(pos_type pos, std::ios_base::openmode mode = std::ios_base::in | std::ios_base::out) {
-        if (in_beg() + pos > in_end() ||
-            in_beg() + pos < in_beg()) {
-            return -1;
+        syncSize();
+        off_type offset = off_type(pos);
+        if (offset < 0) {
+            return pos_type(off_type(-1));
         }
-        if (mode == std::ios_base::in) {
-            setIn(in_beg(), in_beg() + pos, in_end());
-            return in_cur() - in_beg();
+        size_t position = static_cast<size_t>(offset);
+        if (mode & std::ios_base::in) {
+            if (position > m_size) {
+                return pos_type(off_type(-1));
+            }
+            setIn(m_buffer, m_buffer + position, m_buffer + m_size);
         }
-        if (mode == std::ios_base::out) {
-            setOut(out_beg(), out_beg() + pos, out_end());
-            return out_cur() - out_beg();
+        if (mode & std::ios_base::out) {
+            if (position > m_bufferSize && !grow(position)) {
+                return pos_type(off_type(-1));
+            }
+            if (position > m_size) {
+                std::memset(m_buffer + m_size, 0, (position - m_size) * sizeof(char_type));
+            }
+            setOut(m_buffer, m_buffer + position, m_buffer + m_bufferSize);
         }
-        return 0;
+        return pos;
     }
 
     int sync()
     {
+        syncSize();
         return 0;
     }
 
     std::streamsize showmanyc() {
-        return in_end() - in_cur();
+        syncSize();
+        return static_cast<std::streamsize>(m_buffer + m_size - in_cur());
     }
 
     char_type* getBuffer(size_t& bufferSize) {
-        bufferSize = static_cast<size_t>(out_cur() - out_beg());
+        syncSize();
+        bufferSize = m_size;
         return m_buffer;
     }
 
+    char_type* getInputBuffer(size_t& bufferSize) {
+        return getBuffer(bufferSize);
+    }
+
+    /**
+     * @brief Hands the written data over to the caller and resets the buffer.
+     *        Returns nullptr if the buffer doesn't own its memory.
+     */
+    std::unique_ptr<char_type[]> release(size_t& bufferSize) {
+        if (!m_bufferOwner) {
+            bufferSize = 0;
+            return nullptr;
+        }
+        syncSize();
+        bufferSize = m_size;
+        std::unique_ptr<char_type[]> buffer(m_buffer);
+        m_buffer = nullptr;
+        m_bufferSize = 0;
+        m_size = 0;
+        setOut(m_buffer, m_buffer, m_buffer);
+        setIn(m_buffer, m_buffer, m_buffer);
+        return buffer;
+    }
+
+    size_t size() {
+        syncSize();
+        return m_size;
+    }
+
+    size_t capacity() const { return m_bufferSize; }
+
 private:
 
     char_type* in_beg() { return Base::eback(); }
@@ -175,11 +228,30 @@ private:
 
     void setOut(char_type* beg, char_type* cur, char_type* end) {
         Base::setp(beg, end);
-        Base::pbump(static_cast<int>(cur - beg));
+        // pbump only takes an int, advance in steps for large buffers
+        size_t offset = static_cast<size_t>(cur - beg);
+        while (offset > static_cast<size_t>(INT_MAX)) {
+            Base::pbump(INT_MAX);
+            offset -= INT_MAX;
+        }
+        Base::pbump(static_cast<int>(offset));
+    }
+
+    bool grow(size_t required) {
+        if (!m_bufferOwner) return false;
+        size_t capacity = std::max(std::max(required, m_bufferSize + (m_bufferSize >> 1)), minimumCapacity);
+        reserve(capacity);
+        return true;
+    }
+
+    void syncSize() {
+        size_t written = static_cast<size_t>(out_cur() - out_beg());
+        if (written > m_size) m_size = written;
     }
 
     char_type* m_buffer;
     size_t m_bufferSize;
+    size_t m_size;
     bool m_bufferOwner;
 
 };
@@ -187,6 +259,159 @@ private:
 typedef basic_mstreambuf<char> mstreambuf;
 
 
+/**
+ * @brief Output only memory stream buffer made of fixed size chunks.
+ *        Growing never copies already written data, at the cost of one
+ *        copy when the result is needed as a single contiguous block.
+ */
+template<typename CharT = char, typename traits_type = std::char_traits<CharT>>
+class basic_chunked_mstreambuf : public std::basic_streambuf<CharT>
+{
+public:
+    using Base = std::basic_streambuf<CharT>;
+    using char_type = typename Base::char_type;
+    using int_type = typename Base::int_type;
+    using pos_type = typename Base::pos_type;
+    using off_type = typename Base::off_type;
+
+    explicit basic_chunked_mstreambuf(size_t chunkSize = 1 << 20)
+        : m_chunkSize(std::max<size_t>(chunkSize, 1))
+    {
+        selectChunk(0);
+    }
+
+    basic_chunked_mstreambuf(const basic_chunked_mstreambuf&) = delete;
+    basic_chunked_mstreambuf& operator=(const basic_chunked_mstreambuf&) = delete;
+
+    int_type overflow(int_type c = traits_type::eof()) {
+        if (traits_type::eq_int_type(c, traits_type::eof())) {
+            return traits_type::not_eof(c);
+        }
+        syncSize();
+        selectChunk(m_chunk + 1);
+        *Base::pptr() = traits_type::to_char_type(c);
+        Base::pbump(1);
+        return c;
+    }
+
+    std::streamsize xsputn(const char_type* s, std::streamsize n) {
+        std::streamsize written = 0;
+        while (written < n) {
+            if (Base::pptr() == Base::epptr()) {
+                syncSize();
+                selectChunk(m_chunk + 1);
+            }
+            std::streamsize count = std::min<std::streamsize>(n - written, Base::epptr() - Base::pptr());
+            std::memcpy(Base::pptr(), s + written, static_cast<size_t>(count) * sizeof(char_type));
+            Base::pbump(static_cast<int>(count));
+            written += count;
+        }
+        return written;
+    }
+
+    pos_type seekoff(off_type off, std::ios_base::seekdir dir,
+                     std::ios_base::openmode mode = std::ios_base::in | std::ios_base::out)
+    {
+        syncSize();
+        off_type base = 0;
+        if (dir == std::ios_base::cur) {
+            base = static_cast<off_type>(position());
+        } else if (dir == std::ios_base::end) {
+            base = static_cast<off_type>(m_size);
+        }
+        return seekpos(pos_type(base + off), mode);
+    }
+
+    pos_type seekpos(pos_type pos, std::ios_base::openmode mode = std::ios_base::in | std::ios_base::out) {
+        syncSize();
+        off_type offset = off_type(pos);
+        if (offset < 0 || !(mode & std::ios_base::out)) {
+            return pos_type(off_type(-1));
+        }
+        size_t target = static_cast<size_t>(offset);
+
+        // zero fill the gap when seeking beyond the end
+        for (size_t gap = m_size; gap < target;) {
+            selectChunk(gap / m_chunkSize);
+            size_t chunkOffset = gap % m_chunkSize;
+            size_t count = std::min(m_chunkSize - chunkOffset, target - gap);
+            std::memset(m_chunks[m_chunk].get() + chunkOffset, 0, count * sizeof(char_type));
+            gap += count;
+        }
+
+        selectChunk(target / m_chunkSize, target % m_chunkSize);
+        return pos;
+    }
+
+    int sync() {
+        syncSize();
+        return 0;
+    }
+
+    size_t size() {
+        syncSize();
+        return m_size;
+    }
+
+    /**
+     * @brief Writes all chunks to a stream.
+     */
+    void writeTo(std::basic_ostream<CharT>& stream) {
+        syncSize();
+        for (size_t i = 0, remaining = m_size; remaining > 0; i++) {
+            size_t count = std::min(remaining, m_chunkSize);
+            stream.write(m_chunks[i].get(), static_cast<std::streamsize>(count));
+            remaining -= count;
+        }
+    }
+
+    /**
+     * @brief Joins all chunks into one buffer owned by the caller.
+     */
+    std::unique_ptr<char_type[]> release(size_t& bufferSize) {
+        syncSize();
+        bufferSize = m_size;
+        std::unique_ptr<char_type[]> buffer(new char_type[std::max<size_t>(m_size, 1)]);
+        for (size_t i = 0, offset = 0; offset < m_size; i++) {
+            size_t count = std::min(m_size - offset, m_chunkSize);
+            std::memcpy(buffer.get() + offset, m_chunks[i].get(), count * sizeof(char_type));
+            offset += count;
+        }
+        m_chunks.clear();
+        m_size = 0;
+        selectChunk(0);
+        return buffer;
+    }
+
+private:
+
+    size_t position() {
+        return m_chunk * m_chunkSize + static_cast<size_t>(Base::pptr() - Base::pbase());
+    }
+
+    void syncSize() {
+        m_size = std::max(m_size, position());
+    }
+
+    void selectChunk(size_t index, size_t offset = 0) {
+        while (m_chunks.size() <= index) {
+            m_chunks.emplace_back(new char_type[m_chunkSize]);
+        }
+        m_chunk = index;
+        char_type* chunk = m_chunks[index].get();
+        Base::setp(chunk, chunk + m_chunkSize);
+        Base::pbump(static_cast<int>(offset));
+    }
+
+    std::vector<std::unique_ptr<char_type[]>> m_chunks;
+    size_t m_chunkSize;
+    size_t m_chunk = 0;
+    size_t m_size = 0;
+};
+
+typedef basic_chunked_mstreambuf<char> chunked_mstreambuf;
+
+
 /**
  * @brief Output stream using the dynamic memory stream buffer.
  */
@@ -199,6 +424,14 @@ struct omstream
         , std::ostream(static_cast<mstreambuf*>(this))
     {}
 
+    /**
+     * @param reserveHint Expected output size, avoids reallocations while writing.
+     */
+    explicit omstream(size_t reserveHint)
+        : mstreambuf(reserveHint)
+        , std::ostream(static_cast<mstreambuf*>(this))
+    {}
+
     omstream(char* mem, size_t size)
         : mstreambuf(mem, size)
         , std::ostream(static_cast<mstreambuf*>(this))
@@ -212,6 +445,28 @@ struct omstream
         mstreambuf* buf = dynamic_cast<mstreambuf*>(rdbuf());
         return buf->getBuffer(bufferSize);
     }
+
+    std::unique_ptr<char[]> release(size_t& bufferSize) {
+        mstreambuf* buf = dynamic_cast<mstreambuf*>(rdbuf());
+        return buf->release(bufferSize);
+    }
+};
+
+/**
+ * @brief Output stream using the chunked memory stream buffer.
+ */
+struct ocmstream
+    : virtual chunked_mstreambuf
+    , std::ostream
+{
+    explicit ocmstream(size_t chunkSize = 1 << 20)
+        : chunked_mstreambuf(chunkSize)
+        , std::ostream(static_cast<chunked_mstreambuf*>(this))
+    {}
+
+    std::unique_ptr<char[]> release(size_t& bufferSize) {
+        return chunked_mstreambuf::release(bufferSize);
+    }
 };
 
 /**
@@ -2,6 +2,8 @@
 
 #include <stdint.h>
 #include <string>
+#include <string_view>
+#include <vector>
 
 namespace shendk {
 
@@ -10,6 +12,26 @@ struct MurmurHash2 {
     static uint32_t hashData(const uint8_t* data, uint32_t length);
     static uint32_t hashFilenamePlain(std::string filename, bool toLower);
 
+    /**
+     * @brief Assumed second TAD hash of a filename: the filename followed by its first hash
+     *        as 8 lowercase hex digits. Not yet confirmed against game data.
+     * @param buffer Scratch space, reused between calls to avoid allocations.
+     */
+    static uint32_t hashFilenameSecond(std::string_view filename, uint32_t firstHash, bool toLower, std::string& buffer);
+
+    /**
+     * @brief Hashes many strings at once. The strings are processed in interleaved
+     *        lanes so the mixing steps vectorize, lowercasing happens while loading.
+     *        Gives the same results as hashFilenamePlain.
+     */
+    static void hashBatch(const std::string_view* inputs, size_t count, uint32_t* hashes, bool toLower);
+
+    /**
+     * @brief Hashes many strings using multiple threads.
+     * @param threads Number of worker threads, 0 uses all cores.
+     */
+    static std::vector<uint32_t> hashBatch(const std::vector<std::string>& inputs, bool toLower, unsigned threads = 0);
+
 private:
     static const uint32_t m_initializationSeed = 0x066EE5D0;
     static const uint32_t m_multiplier = 0x5BD1E995;
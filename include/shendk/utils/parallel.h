@@ -0,0 +1,60 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <exception>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace shendk {
+
+/**
+ * @brief Returns the number of worker threads to use for the given hint (0 = all cores).
+ */
+inline unsigned workerCount(unsigned threads = 0) {
+    if (threads == 0) threads = std::thread::hardware_concurrency();
+    return std::max(threads, 1u);
+}
+
+/**
+ * @brief Calls func(i) for every i in [0, count) on a pool of worker threads.
+ *        Items are handed out one by one, so uneven work sizes balance out.
+ *        The first exception thrown by func is rethrown after all workers finished.
+ */
+inline void parallelFor(size_t count, const std::function<void(size_t)>& func, unsigned threads = 0) {
+    threads = static_cast<unsigned>(std::min<size_t>(workerCount(threads), count));
+    if (threads <= 1) {
+        for (size_t i = 0; i < count; i++) func(i);
+        return;
+    }
+
+    std::atomic<size_t> next(0);
+    std::exception_ptr error;
+    std::mutex errorMutex;
+    auto worker = [&]() {
+        for (size_t i = next++; i < count; i = next++) {
+            try {
+                func(i);
+            } catch (...) {
+                std::lock_guard<std::mutex> lock(errorMutex);
+                if (!error) error = std::current_exception();
+                next = count;
+            }
+        }
+    };
+
+    std::vector<std::thread> pool;
+    pool.reserve(threads - 1);
+    for (unsigned i = 1; i < threads; i++) {
+        pool.emplace_back(worker);
+    }
+    worker();
+    for (auto& thread : pool) {
+        thread.join();
+    }
+    if (error) std::rethrow_exception(error);
+}
+
+}
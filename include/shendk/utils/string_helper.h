@@ -13,4 +13,28 @@ static inline std::string toHex(T value, int padding) {
     return ss.str();
 }
 
+/**
+ * @brief Matches a string against a glob pattern.
+ *        '*' matches any sequence (including '/'), '?' matches a single character.
+ */
+static inline bool globMatch(const std::string& pattern, const std::string& str) {
+    size_t p = 0, s = 0, star = std::string::npos, match = 0;
+    while (s < str.size()) {
+        if (p < pattern.size() && (pattern[p] == '?' || pattern[p] == str[s])) {
+            p++;
+            s++;
+        } else if (p < pattern.size() && pattern[p] == '*') {
+            star = p++;
+            match = s;
+        } else if (star != std::string::npos) {
+            p = star + 1;
+            s = ++match;
+        } else {
+            return false;
+        }
+    }
+    while (p < pattern.size() && pattern[p] == '*') p++;
+    return p == pattern.size();
+}
+
 }
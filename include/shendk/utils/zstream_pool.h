@@ -0,0 +1,68 @@
+#pragma once
+
+#include <memory>
+#include <mutex>
+#include <vector>
+
+struct z_stream_s;
+
+namespace shendk {
+
+/**
+ * @brief Pool of initialized zlib streams with scratch buffers, shared by all threads.
+ *        Streams are reset instead of being initialized again for every use, and
+ *        outlive the short lived workers of parallelFor.
+ */
+struct ZStreamPool {
+
+    struct Context {
+        Context(bool deflate, int level, int strategy);
+        ~Context();
+
+        Context(const Context&) = delete;
+        Context& operator=(const Context&) = delete;
+
+        std::unique_ptr<z_stream_s> stream;
+        std::vector<char> input;
+        std::vector<char> output;
+        bool deflate;
+        int level;
+        int strategy;
+        bool valid;
+    };
+
+    /**
+     * @brief Hands a context back to the pool when destroyed.
+     */
+    struct Lease {
+        Lease() = default;
+        Lease(std::unique_ptr<Context> context);
+        Lease(Lease&& other) = default;
+        Lease& operator=(Lease&& other);
+        ~Lease();
+
+        Context* get() const { return m_context.get(); }
+        Context* operator->() const { return m_context.get(); }
+        z_stream_s* stream() const { return m_context ? m_context->stream.get() : nullptr; }
+        explicit operator bool() const { return m_context && m_context->valid; }
+
+    private:
+        std::unique_ptr<Context> m_context;
+    };
+
+    /**
+     * @brief Returns a reset inflater for gzip data.
+     */
+    static Lease acquireInflater();
+
+    /**
+     * @brief Returns a reset gzip deflater with the given zlib level and strategy.
+     */
+    static Lease acquireDeflater(int level, int strategy);
+
+private:
+    static std::vector<std::unique_ptr<Context>>& contexts();
+    static std::mutex& mutex();
+};
+
+}
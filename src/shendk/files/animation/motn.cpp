@@ -2,7 +2,7 @@
 
 #include <set>
 
-#include "shendk/utils/stream_helper.h"
+#include "shendk/utils/binary_reader.h"
 #include "shendk/utils/math.h"
 #include "shendk/types/model.h"
 
@@ -15,39 +15,43 @@ namespace shendk {
 
 	void MOTN::_read(std::istream& stream) {
 		stream.read(reinterpret_cast<char*>(&header), sizeof(MOTN::Header));
+		stream.seekg(baseOffset, std::ios::beg);
+
+		std::vector<uint8_t> storage;
+		BinaryReader reader = BinaryReader::fromStream(stream, storage, header.fileSize);
 
 		// read sequence names
 		int64_t offset = 0;
-		stream.seekg(baseOffset + header.nameTableOffset, std::ios::beg);
+		reader.seek(header.nameTableOffset);
 		for (int i = 0; i < header.animationCount(); i++) {
 			Sequence seq;
-			uint32_t stringOffset = sread<uint32_t>(stream);
-			offset = stream.tellg();
-			stream.seekg(baseOffset + stringOffset);
-			seq.name = sreadstr(stream);
+			uint32_t stringOffset = reader.read<uint32_t>();
+			offset = reader.tell();
+			reader.seek(stringOffset);
+			seq.name = reader.readString();
 			sequences.push_back(seq);
-			stream.seekg(baseOffset + offset);
+			reader.seek(offset);
 		}
 
 		// read sequence data offsets
-		stream.seekg(baseOffset + header.dataTableOffset, std::ios::beg);
+		reader.seek(header.dataTableOffset);
 
 		for (auto& seq : sequences) {
-			seq.offsets = sread<Sequence::Offsets>(stream);
+			seq.offsets = reader.read<Sequence::Offsets>();
 		}
 
 		// read sequence data
 		for (auto& seq : sequences) {
 
 			// read extra data
-			int64_t extraDataOffset = baseOffset + seq.offsets.extraDataOffset;
-			stream.seekg(extraDataOffset, std::ios::beg);
-			seq.extraData = sread<Sequence::ExtraData>(stream);
+			int64_t extraDataOffset = seq.offsets.extraDataOffset;
+			reader.seek(extraDataOffset);
+			seq.extraData = reader.read<Sequence::ExtraData>();
 
 			// read data
-			int64_t dataOffset = baseOffset + header.dataOffset + seq.offsets.dataOffset;
-			stream.seekg(dataOffset, std::ios::beg);
-			seq.data.header = sread<Sequence::Data::Header>(stream);
+			int64_t dataOffset = header.dataOffset + seq.offsets.dataOffset;
+			reader.seek(dataOffset);
+			seq.data.header = reader.read<Sequence::Data::Header>();
 
 			if (dataOffset == 817312) {
 				std::cout << "FIRST IN RUNTIME" << std::endl;
@@ -73,33 +77,33 @@ namespace shendk {
 			auto readData = [&](FrameType type) -> void {
 				int16_t block2Value;
 				if (block2EntryHalfSize) {
-					stream.seekg(block2Offset, std::ios::beg);
-					block2Value = sread<int8_t>(stream);
+					reader.seek(block2Offset);
+					block2Value = reader.read<int8_t>();
 					block2Offset += sizeof(uint8_t);
 				}
 				else {
-					stream.seekg(block2Offset, std::ios::beg);
-					block2Value = sread<int16_t>(stream);
+					reader.seek(block2Offset);
+					block2Value = reader.read<int16_t>();
 					block2Offset += sizeof(uint16_t);
 				}
 
 				// Block 3 contains the keyframe times.
 				// TODO: Find out how to map those to the actual float data.
 				if (block3EntryHalfSize) {
-					stream.seekg(block3Offset, std::ios::beg);
-					block3Value = sread<uint8_t>(stream);
+					reader.seek(block3Offset);
+					block3Value = reader.read<uint8_t>();
 					block3Offset += block2Value;
 				}
 				else {
-					stream.seekg(block3Offset, std::ios::beg);
-					block3Value = sread<uint16_t>(stream);
+					reader.seek(block3Offset);
+					block3Value = reader.read<uint16_t>();
 					block3Offset += block2Value * 2;
 				}
 
 				float block3Val = static_cast<float>(block3Value) * 0.033333335f; // ~0.033 = 30fps
 				std::cout << "    B3: " << std::to_string(block3Value) << " (" << std::to_string(block3Val) << ")" << std::endl;
 
-				stream.seekg(block4Offset, std::ios::beg);
+				reader.seek(block4Offset);
 				int8_t firstCount = (block2Value + 2) >> 2;
 				if ((block2Value + 2) & 3) {
 					firstCount++;
@@ -112,12 +116,12 @@ namespace shendk {
 					/*uint32_t block3Value = 0;
 					if (block2Value) {
 						if (block3EntryHalfSize) {
-							stream.seekg(block3Offset, std::ios::beg);
-							block3Value = sread<uint8_t>(stream);
+							reader.seek(block3Offset);
+							block3Value = reader.read<uint8_t>();
 							block3Offset += sizeof(uint8_t);
 						} else {
-							stream.seekg(block3Offset, std::ios::beg);
-							block3Value = sread<uint16_t>(stream);
+							reader.seek(block3Offset);
+							block3Value = reader.read<uint16_t>();
 							block3Offset += sizeof(uint16_t);
 						}
 					}
@@ -134,24 +138,24 @@ namespace shendk {
 					keyframe.time = block3Val;
 					keyframe.nodeID = index;
 
-					stream.seekg(block4Offset, std::ios::beg);
-					uint8_t secondCountIndex = sread<uint8_t>(stream);
+					reader.seek(block4Offset);
+					uint8_t secondCountIndex = reader.read<uint8_t>();
 					uint8_t secondCount = countLookupTable[secondCountIndex];
 
 					Vector3f translation = Vector3f(), rotation = Vector3f();
 
 					if (secondCountIndex & 0xFF) {
-						stream.seekg(block5Offset, std::ios::beg);
+						reader.seek(block5Offset);
 						std::cout << "      ";
 						if (secondCountIndex & 0x80) {
-							int16_t val = sread<int16_t>(stream);
-							val = sread<int16_t>(stream);
+							int16_t val = reader.read<int16_t>();
+							val = reader.read<int16_t>();
 						}
 						if (secondCountIndex & 0x40) {
-							int16_t val = sread<int16_t>(stream);
+							int16_t val = reader.read<int16_t>();
 							float valFloat = 0.f;
 
-							//printf("currPos = 0x%X \tcurrVal = 0x%X\n", (int)stream.tellg() - 2, val);
+							//printf("currPos = 0x%X \tcurrVal = 0x%X\n", (int)reader.tell() - 2, val);
 							if (type == RotX || type == RotY || type == RotZ) {
 								//std::cout << "Raw Val: " << std::to_string(val) << std::endl;
 								valFloat = radiansToDegrees(fromHalf(val));
@@ -180,14 +184,14 @@ namespace shendk {
 							//keyframe._40.push_back(valFloat);
 						}
 						if (secondCountIndex & 0x20) {
-							int16_t val = sread<int16_t>(stream);
-							val = sread<int16_t>(stream);
+							int16_t val = reader.read<int16_t>();
+							val = reader.read<int16_t>();
 						}
 						if (secondCountIndex & 0x10) {
-							int16_t val = sread<int16_t>(stream);
+							int16_t val = reader.read<int16_t>();
 
 							float valFloat = 0.f;
-							//printf("currPos = 0x%X \tcurrVal = 0x%X\n", (int)stream.tellg() - 2, val);
+							//printf("currPos = 0x%X \tcurrVal = 0x%X\n", (int)reader.tell() - 2, val);
 							if (type == RotX || type == RotY || type == RotZ) {
 								//std::cout << "Raw Val: " << std::to_string(val) << std::endl;
 								valFloat = radiansToDegrees(fromHalf(val));
@@ -216,13 +220,13 @@ namespace shendk {
 							//keyframe._10.push_back(valFloat);
 						}
 						if (secondCountIndex & 0x08) {
-							int16_t val = sread<int16_t>(stream);
-							val = sread<int16_t>(stream);
+							int16_t val = reader.read<int16_t>();
+							val = reader.read<int16_t>();
 						}
 						if (secondCountIndex & 0x04) {
-							int16_t val = sread<int16_t>(stream);
+							int16_t val = reader.read<int16_t>();
 							float valFloat = 0.f;
-							//printf("currPos = 0x%X \tcurrVal = 0x%X\n", (int)stream.tellg() - 2, val);
+							//printf("currPos = 0x%X \tcurrVal = 0x%X\n", (int)reader.tell() - 2, val);
 							if (type == RotX || type == RotY || type == RotZ) {
 								//std::cout << "Raw Val: " << std::to_string(val) << std::endl;
 								valFloat = radiansToDegrees(fromHalf(val));
@@ -251,13 +255,13 @@ namespace shendk {
 							//keyframe._04.push_back(valFloat);
 						}
 						if (secondCountIndex & 0x02) {
-							int16_t val = sread<int16_t>(stream);
-							val = sread<int16_t>(stream);
+							int16_t val = reader.read<int16_t>();
+							val = reader.read<int16_t>();
 						}
 						if (secondCountIndex & 0x01) {
-							int16_t val = sread<int16_t>(stream);
+							int16_t val = reader.read<int16_t>();
 							float valFloat = 0.f;
-							//printf("currPos = 0x%X \tcurrVal = 0x%X\n", (int)stream.tellg() - 2, val);
+							//printf("currPos = 0x%X \tcurrVal = 0x%X\n", (int)reader.tell() - 2, val);
 							if (type == RotX || type == RotY || type == RotZ) {
 								//std::cout << "Raw Val: " << std::to_string(val) << std::endl;
 								valFloat = radiansToDegrees(fromHalf(val));
@@ -293,7 +297,7 @@ namespace shendk {
 
 					std::cout << "        [" << std::to_string(keyframe.time) << "]\n";
 
-					int64_t newBlock5Offset = stream.tellg();
+					int64_t newBlock5Offset = reader.tell();
 					block5Offset += 2 * secondCount;
 
 					firstCount--;
@@ -312,7 +316,7 @@ namespace shendk {
 			shendk::Animation anim;
 
 			//uint16_t index = 0;
-			int16_t instruction = sread<int16_t>(stream);
+			int16_t instruction = reader.read<int16_t>();
 			while (index < 127) {
 				if (instruction == 0) break;
 				if (index == (instruction >> 9)) {
@@ -356,17 +360,17 @@ namespace shendk {
 					anim.sequences.insert({ index, newSeq });
 
 					block1Offset += sizeof(uint16_t);
-					stream.seekg(block1Offset, std::ios::beg);
-					instruction = sread<uint16_t>(stream);
+					reader.seek(block1Offset);
+					instruction = reader.read<uint16_t>();
 				}
 				index++;
 			}
 
 			animations.push_back(anim);
-			if (!stream.good()) {
+			if (!reader.good()) {
 				// TODO: haven't investigated why some sequences go beyond the stream yet
 				std::cout << "Stream Broke!" << std::endl;
-				stream.clear();
+				reader.clear();
 			}
 		}
 
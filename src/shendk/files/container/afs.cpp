@@ -1,24 +1,153 @@
 #include "shendk/files/container/afs.h"
 
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstring>
+#include <set>
+
+#include "shendk/utils/file_copy.h"
+#include "shendk/utils/parallel.h"
+
 namespace shendk {
 
 AFS::AFS() = default;
 AFS::AFS(const std::string& filepath) { read(filepath); }
+AFS::AFS(const std::string& filepath, ReadMode mode) {
+    readMode = mode;
+    read(filepath);
+}
 AFS::AFS(std::istream& stream) { read(stream); }
 
 AFS::~AFS() {}
 
 void AFS::unpack(const std::string& folder) {
+    unpack(folder, nullptr);
+}
+
+AFS::UnpackStats AFS::unpack(const std::string& folder, IDX* idx, unsigned threads) {
+    auto start = std::chrono::steady_clock::now();
     fs::create_directories(folder);
+
+    // resolve unique output paths up front, workers only write
+    std::vector<std::string> paths(entries.size());
+    std::set<std::string> used;
+    bool needsSource = false;
+    for (size_t i = 0; i < entries.size(); i++) {
+        std::string filename = getEntryFilename(i, idx);
+        if (!used.insert(filename).second) {
+            filename = std::to_string(i) + "_" + filename;
+            used.insert(filename);
+        }
+        paths[i] = (fs::path(folder) / filename).string();
+        needsSource |= !entries[i].isLoaded();
+    }
+
+    std::unique_ptr<FileCopier> copier;
+    if (needsSource) {
+        copier.reset(new FileCopier(sourcePath));
+        if (!copier->isOpen())
+            throw new std::runtime_error("Couldn't open file: " + sourcePath + "\n");
+    }
+
+    UnpackStats stats;
+    std::atomic<uint64_t> bytes(0);
+    parallelFor(entries.size(), [&](size_t i) {
+        AFS::Entry& entry = entries[i];
+        bool success = entry.isLoaded()
+                ? FileCopier::writeFile(paths[i], entry.getView())
+                : copier->copy(sourceOffset + entry.offset.fileOffset, entry.offset.fileSize, paths[i]);
+        if (!success)
+            throw new std::runtime_error("Couldn't write file: " + paths[i] + "\n");
+        bytes += entry.offset.fileSize;
+    }, threads);
+
+    stats.files = entries.size();
+    stats.bytes = bytes;
+    stats.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    return stats;
 }
 
 void AFS::mapIdxFilenames(IDX& idx) {
-    for (int i = 0; i < entries.size(); i++) {
+    for (uint32_t i = 0; i < entries.size(); i++) {
         entries[i].idxFilename = idx.getFilename(i);
     }
 }
 
+std::string AFS::getEntryFilename(size_t index, IDX* idx) const {
+    std::string filename;
+    if (idx) filename = idx->getFilename(static_cast<uint32_t>(index));
+    if (filename.empty()) filename = entries[index].idxFilename;
+    if (filename.empty()) {
+        const char* name = entries[index].meta.filename;
+        filename.assign(name, strnlen(name, sizeof(entries[index].meta.filename)));
+    }
+
+    // keep names inside the output folder
+    filename.erase(std::remove_if(filename.begin(), filename.end(), [](char c) {
+        return c == '/' || c == '\\' || c == ':' || static_cast<unsigned char>(c) < 0x20;
+    }), filename.end());
+    if (filename.empty() || filename == "." || filename == "..") {
+        filename = std::to_string(index) + ".bin";
+    }
+    return filename;
+}
+
+void AFS::loadEntry(AFS::Entry& entry) {
+    if (entry.isLoaded()) return;
+    std::ifstream fstream(sourcePath, std::ios::binary);
+    if (!fstream.is_open())
+        throw new std::runtime_error("Couldn't open file: " + sourcePath + "\n");
+    loadEntry(entry, fstream);
+}
+
+void AFS::loadEntry(AFS::Entry& entry, std::istream& stream) {
+    if (entry.isLoaded()) return;
+    stream.seekg(sourceOffset + entry.offset.fileOffset, std::ios::beg);
+    entry.readData(stream);
+    if (!stream.good())
+        throw new std::runtime_error("Couldn't read AFS entry data!\n");
+}
+
+void AFS::loadAll() {
+    auto skipped = std::find_if(entries.begin(), entries.end(), [](const AFS::Entry& entry) {
+        return !entry.isLoaded();
+    });
+    if (skipped == entries.end()) return;
+    std::ifstream fstream(sourcePath, std::ios::binary);
+    if (!fstream.is_open())
+        throw new std::runtime_error("Couldn't open file: " + sourcePath + "\n");
+    for (auto& entry : entries) {
+        loadEntry(entry, fstream);
+    }
+}
+
+void AFS::write(const std::string& filepath) {
+    loadAll();
+
+    // views into a mapping of the output file would be truncated with it
+    std::error_code error;
+    if (mappedFile && !sourcePath.empty() && fs::equivalent(filepath, sourcePath, error)) {
+        for (auto& entry : entries) {
+            std::vector<char> data = entry.getData();
+            entry.setData(data);
+        }
+        mappedFile.reset();
+    }
+    File::write(filepath);
+}
+
+MemoryView AFS::getEntryView(size_t index) {
+    AFS::Entry& entry = entries.at(index);
+    loadEntry(entry);
+    return entry.getView();
+}
+
 void AFS::_read(std::istream& stream) {
+    entries.clear();
+    sourcePath = filepath;
+    sourceOffset = baseOffset;
+
     // read header
     stream.read(reinterpret_cast<char*>(&header), sizeof(AFS::Header));
 
@@ -67,14 +196,24 @@ void AFS::_read(std::istream& stream) {
         }
     }
 
-    // read entry data
+    // read entry data (or reference it when reading from a mapping)
     for (auto& entry : entries) {
+        MemoryView view = mappedView(stream, baseOffset + entry.offset.fileOffset, entry.offset.fileSize);
+        if (view) {
+            entry.setView(view);
+            continue;
+        }
+        if (readMode == ReadMode::IndexOnly) continue;
         stream.seekg(baseOffset + entry.offset.fileOffset, std::ios::beg);
         entry.readData(stream);
     }
 }
 
 void AFS::_write(std::ostream& stream) {
+    // entries skipped in index-only mode are read from the source file,
+    // write(filepath) does so before the output is opened
+    loadAll();
+
     // calculate entry data start offset
     uint32_t fileCount = static_cast<uint32_t>(entries.size());
     uint32_t startOffset = sizeof(AFS::Header) + fileCount * sizeof(AFS::OffsetEntry);
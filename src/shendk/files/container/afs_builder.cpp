@@ -0,0 +1,152 @@
+#include "shendk/files/container/afs_builder.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <ctime>
+
+#include "shendk/utils/memstream.h"
+
+namespace shendk {
+
+void AFSBuilder::addFile(const std::string& filepath) {
+    addFile(filepath, fs::path(filepath).filename().string());
+}
+
+void AFSBuilder::addFile(const std::string& filepath, const std::string& name) {
+    if (!fs::exists(filepath))
+        throw new std::runtime_error("Couldn't open file: " + filepath + "\n");
+    uint32_t size = static_cast<uint32_t>(fs::file_size(filepath));
+    AFS::MetaEntry meta = makeMeta(name, size);
+
+    // convert the last write time to calendar time
+    auto fileTime = fs::last_write_time(filepath);
+    auto systemTime = std::chrono::time_point_cast<std::chrono::system_clock::duration>(
+                fileTime - fs::file_time_type::clock::now() + std::chrono::system_clock::now());
+    std::time_t time = std::chrono::system_clock::to_time_t(systemTime);
+    if (std::tm* tm = std::localtime(&time)) {
+        meta.year = static_cast<uint16_t>(tm->tm_year + 1900);
+        meta.month = static_cast<uint16_t>(tm->tm_mon + 1);
+        meta.day = static_cast<uint16_t>(tm->tm_mday);
+        meta.hour = static_cast<uint16_t>(tm->tm_hour);
+        meta.minute = static_cast<uint16_t>(tm->tm_min);
+        meta.second = static_cast<uint16_t>(tm->tm_sec);
+    }
+
+    addStream(meta, size, [filepath]() -> std::unique_ptr<std::istream> {
+        return std::unique_ptr<std::istream>(new std::ifstream(filepath, std::ios::binary));
+    });
+}
+
+void AFSBuilder::addStream(const std::string& name, uint32_t size, Opener open) {
+    addStream(makeMeta(name, size), size, open);
+}
+
+void AFSBuilder::addStream(const AFS::MetaEntry& meta, uint32_t size, Opener open) {
+    sources.push_back({ meta, size, open });
+}
+
+void AFSBuilder::addEntries(AFS& afs) {
+    for (size_t i = 0; i < afs.entries.size(); i++) {
+        AFS::Entry& entry = afs.entries[i];
+        AFS::MetaEntry meta = entry.meta;
+        meta.fileSize = entry.offset.fileSize;
+        addStream(meta, entry.offset.fileSize, [&afs, i]() -> std::unique_ptr<std::istream> {
+            AFS::Entry& entry = afs.entries[i];
+            if (entry.isLoaded()) {
+                MemoryView view = entry.getView();
+                return std::unique_ptr<std::istream>(new imstream(const_cast<char*>(view.data), view.size));
+            }
+            // read skipped entries straight from the source file without caching them
+            std::unique_ptr<std::istream> input(new std::ifstream(afs.sourcePath, std::ios::binary));
+            input->seekg(afs.sourceOffset + entry.offset.fileOffset, std::ios::beg);
+            return input;
+        });
+    }
+}
+
+void AFSBuilder::build(const std::string& filepath) {
+    std::ofstream fstream(filepath, std::ios::binary);
+    if (!fstream.is_open())
+        throw new std::runtime_error("Couldn't open file: " + filepath + "\n");
+    build(fstream);
+}
+
+void AFSBuilder::build(std::ostream& stream) {
+    const uint32_t padding = AFS::padding;
+
+    // calculate entry data start offset (same layout as AFS::_write)
+    uint32_t fileCount = static_cast<uint32_t>(sources.size());
+    uint32_t startOffset = sizeof(AFS::Header) + fileCount * sizeof(AFS::OffsetEntry);
+    startOffset = startOffset + padding - (startOffset % padding);
+    if (fileCount > AFS::fileCountMagic) {
+        startOffset = AFS::maxPadding;
+    }
+
+    // calculate entry data offsets
+    std::vector<AFS::OffsetEntry> offsets;
+    offsets.reserve(fileCount);
+    uint32_t offset = startOffset;
+    for (auto& source : sources) {
+        offsets.push_back({ offset, source.size });
+        offset += source.size;
+        offset += padding - (offset % padding); //sector padding
+    }
+    uint32_t metaOffset = offset;
+    uint32_t metaSize = fileCount * sizeof(AFS::MetaEntry);
+
+    std::vector<char> buffer(std::max<uint32_t>(padding, 0x10000));
+    auto writeZeros = [&](uint64_t count) {
+        std::fill(buffer.begin(), buffer.end(), 0);
+        while (count > 0) {
+            uint64_t chunk = std::min<uint64_t>(count, buffer.size());
+            stream.write(buffer.data(), chunk);
+            count -= chunk;
+        }
+    };
+
+    // write header, offset table and the meta table location in front of the data
+    AFS::Header header = { AFS::signature, fileCount };
+    stream.write(reinterpret_cast<char*>(&header), sizeof(AFS::Header));
+    stream.write(reinterpret_cast<char*>(offsets.data()), offsets.size() * sizeof(AFS::OffsetEntry));
+    uint64_t position = sizeof(AFS::Header) + offsets.size() * sizeof(AFS::OffsetEntry);
+    if (position + 8 > startOffset)
+        throw new std::runtime_error("Too many entries for AFS file!\n");
+    writeZeros(startOffset - 8 - position);
+    stream.write(reinterpret_cast<char*>(&metaOffset), sizeof(uint32_t));
+    stream.write(reinterpret_cast<char*>(&metaSize), sizeof(uint32_t));
+    position = startOffset;
+
+    // stream entry data
+    for (size_t i = 0; i < sources.size(); i++) {
+        writeZeros(offsets[i].fileOffset - position);
+        position = offsets[i].fileOffset;
+
+        std::unique_ptr<std::istream> input = sources[i].open();
+        uint64_t remaining = sources[i].size;
+        while (remaining > 0 && input && input->good()) {
+            uint64_t chunk = std::min<uint64_t>(remaining, buffer.size());
+            input->read(buffer.data(), chunk);
+            stream.write(buffer.data(), input->gcount());
+            remaining -= input->gcount();
+        }
+        if (remaining > 0)
+            throw new std::runtime_error("AFS source is smaller than its declared size!\n");
+        position += sources[i].size;
+    }
+    writeZeros(metaOffset - position);
+
+    // write meta entries
+    for (auto& source : sources) {
+        stream.write(reinterpret_cast<char*>(&source.meta), sizeof(AFS::MetaEntry));
+    }
+}
+
+AFS::MetaEntry AFSBuilder::makeMeta(const std::string& name, uint32_t size) {
+    AFS::MetaEntry meta = {};
+    std::memcpy(meta.filename, name.c_str(), std::min(name.size(), sizeof(meta.filename)));
+    meta.fileSize = size;
+    return meta;
+}
+
+}
@@ -1,5 +1,13 @@
 #include "shendk/files/container/gz.h"
+#include <algorithm>
+#include <atomic>
 #include <cstring>
+#include <iterator>
+
+#include "shendk/utils/gzstream.h"
+#include "shendk/utils/memstream.h"
+#include "shendk/utils/parallel.h"
+#include "shendk/utils/zstream_pool.h"
 
 #if defined(_WIN32)
     #define ZLIB_WINAPI
@@ -16,130 +24,130 @@ GZ::GZ(std::istream& stream) { read(stream); }
 GZ::~GZ() {}
 
 bool GZ::testGzip(std::istream& stream) {
-
-    uint16_t signature;
-    stream.read(reinterpret_cast<char*>(&signature), 2);
-    stream.seekg(0, std::ios::beg);
-    if (signature != 35615) return false;
-
-    uint8_t* buffer = new uint8_t[2];
-    stream.read(reinterpret_cast<char*>(buffer), 2);
-    stream.seekg(0, std::ios::beg);
-
-    z_stream d_stream;
-    d_stream.zalloc = static_cast<alloc_func>(nullptr);
-    d_stream.zfree = static_cast<free_func>(nullptr);
-    d_stream.opaque = static_cast<voidpf>(nullptr);
-    d_stream.next_in  = buffer;
-    d_stream.avail_in = 0;
-
-    int err;
-    err = inflateInit2(&d_stream, 16 + MAX_WBITS);
-    delete[] buffer;
-    if (err != Z_OK) {
-        return false;
-    }
-    return true;
+    std::streampos position = stream.tellg();
+    uint8_t magic[3] = {};
+    stream.read(reinterpret_cast<char*>(magic), 3);
+    bool gzip = stream.gcount() == 3 && magic[0] == 0x1F && magic[1] == 0x8B && magic[2] == Z_DEFLATED;
+    stream.clear();
+    stream.seekg(position, std::ios::beg);
+    return gzip;
 }
 
 char* GZ::inflateStream(std::istream& inStream, uint64_t& bufferSize) {
+    gz_istreambuf inflater(inStream);
+    if (!inflater.isValid()) return nullptr;
+
+    // copy window by window into a geometrically growing buffer
+    omstream output;
+    output << &inflater;
+    if (!inflater.isValid()) return nullptr;
+
+    size_t size = 0;
+    std::unique_ptr<char[]> buffer = output.release(size);
+    bufferSize = size;
+    return buffer.release();
+}
 
-    // retrieve input stream size
-    inStream.seekg(0, std::ios::end);
-    uint32_t inBufferSize = static_cast<uint32_t>(inStream.tellg());
-    uint32_t outBufferSize = inBufferSize;
-    inStream.seekg(0, std::ios::beg);
-
-    // initialzie buffers
-    uint8_t* inBuffer = new uint8_t[inBufferSize];
-    uint8_t* outBuffer = new uint8_t[inBufferSize];
-    inStream.read(reinterpret_cast<char*>(inBuffer), inBufferSize);
-
-    // initialize decompression stream
-    z_stream d_stream;
-    d_stream.zalloc = static_cast<alloc_func>(nullptr);
-    d_stream.zfree = static_cast<free_func>(nullptr);
-    d_stream.opaque = static_cast<voidpf>(nullptr);
-    d_stream.next_in  = inBuffer;
-    d_stream.next_out  = outBuffer;
-    d_stream.avail_in  = inBufferSize;
-    d_stream.avail_out = outBufferSize;
-
-    uint32_t ibuflen = inBufferSize;
-    uint32_t occupied, newSize;
-    int32_t err, flush;
-
-    // initialize and check if input stream is a zlib compatible file
-    err = inflateInit2(&d_stream, 16 + MAX_WBITS);
-    if (err != Z_OK) {
-        return nullptr;
-    }
+bool GZ::deflateStream(const char* data, uint64_t size, std::ostream& outStream) {
+    return deflateStream(data, size, outStream, GZ::Options());
+}
 
-    // decompress stream
-    do {
-        d_stream.avail_in = ibuflen;
-        ibuflen -= d_stream.avail_in;
-        flush = ibuflen == 0 ? Z_FINISH : Z_NO_FLUSH;
-        do {
-
-            // calculate decompressed bytes
-            occupied = static_cast<uint32_t>(d_stream.next_out - outBuffer);
-
-            // increase output buffer size if the end was reached by 2
-            if (outBufferSize == occupied) {
-                if (outBufferSize == UINT_MAX) return nullptr;
-                if (outBufferSize <= (UINT_MAX >> 1)) {
-                    newSize = outBufferSize << 1;
-                } else {
-                    newSize = UINT_MAX;
-                }
-                uint8_t* temp = new uint8_t[newSize];
-                memcpy(temp, outBuffer, outBufferSize);
-                delete[] outBuffer;
-                outBuffer = temp;
-                if (outBuffer == nullptr) return nullptr;
-                outBufferSize = newSize;
+bool GZ::deflateStream(const char* data, uint64_t size, std::ostream& outStream, const GZ::Options& options) {
+    uint64_t blockSize = std::max<uint32_t>(options.blockSize, 1);
+    size_t blockCount = static_cast<size_t>(std::max<uint64_t>((size + blockSize - 1) / blockSize, 1));
+    unsigned threads = workerCount(options.threads);
+
+    // deflate a group of blocks in parallel, then write them in order
+    size_t groupSize = threads * 2;
+    std::vector<std::vector<char>> members(std::min(groupSize, blockCount));
+    std::atomic<bool> success(true);
+    for (size_t group = 0; group < blockCount; group += groupSize) {
+        size_t count = std::min(groupSize, blockCount - group);
+        parallelFor(count, [&](size_t i) {
+            uint64_t offset = (group + i) * blockSize;
+            uint64_t length = std::min(blockSize, size - std::min(offset, size));
+            std::vector<char>& member = members[i];
+
+            ZStreamPool::Lease deflater = ZStreamPool::acquireDeflater(options.level, options.strategy);
+            if (!deflater) {
+                success = false;
+                return;
             }
-            d_stream.avail_out = static_cast<uint32_t>(outBufferSize - occupied);
-            d_stream.next_out = outBuffer + occupied;
-
-            // inflate next bytes
-            err = inflate(&d_stream, flush);
-            switch (err) {
-            case Z_OK:
-            case Z_BUF_ERROR:
-            case Z_STREAM_END:
-                break;
-            case Z_MEM_ERROR:
-                inflateEnd(&d_stream);
-                return nullptr;
-            default:
-                inflateEnd(&d_stream);
-                return nullptr;
+            z_stream* d_stream = deflater.stream();
+            member.resize(deflateBound(d_stream, static_cast<uLong>(length)));
+            d_stream->next_in = reinterpret_cast<Bytef*>(const_cast<char*>(data + offset));
+            d_stream->avail_in = static_cast<uInt>(length);
+            d_stream->next_out = reinterpret_cast<Bytef*>(member.data());
+            d_stream->avail_out = static_cast<uInt>(member.size());
+            if (deflate(d_stream, Z_FINISH) != Z_STREAM_END) {
+                success = false;
             }
-        } while (d_stream.avail_out == 0);
-
-    } while (err != Z_STREAM_END && ibuflen != 0);
+            member.resize(d_stream->total_out);
+        }, threads);
 
-    // cleanup decompression
-    bufferSize = d_stream.total_out;
-    inflateEnd(&d_stream);
-    delete[] inBuffer;
+        if (!success) return false;
+        for (size_t i = 0; i < count; i++) {
+            outStream.write(members[i].data(), members[i].size());
+        }
+    }
+    return outStream.good();
+}
 
-    // allocate new memory that fits the output data
-    char* decompressedBuffer = new char[bufferSize];
-    memcpy(decompressedBuffer, outBuffer, bufferSize);
-    delete[] outBuffer;
+bool GZ::inflateMemory(MemoryView input, std::vector<char>& output) {
+    output.clear();
+    ZStreamPool::Lease inflater = ZStreamPool::acquireInflater();
+    if (!inflater) return false;
+    z_stream* d_stream = inflater.stream();
+    d_stream->next_in = reinterpret_cast<Bytef*>(const_cast<char*>(input.data));
+    d_stream->avail_in = static_cast<uInt>(input.size);
+
+    size_t produced = 0;
+    while (true) {
+        // grow the output geometrically, compressed assets usually inflate 2-4x
+        if (produced == output.size()) {
+            output.resize(std::max<size_t>(output.size() * 2, std::max<size_t>(input.size * 3, 0x10000)));
+        }
+        d_stream->next_out = reinterpret_cast<Bytef*>(output.data() + produced);
+        d_stream->avail_out = static_cast<uInt>(output.size() - produced);
+        int err = inflate(d_stream, Z_NO_FLUSH);
+        produced = output.size() - d_stream->avail_out;
+        if (err == Z_STREAM_END) {
+            // continue with the next gzip member if one follows
+            if (d_stream->avail_in >= 2 && d_stream->next_in[0] == 0x1F && d_stream->next_in[1] == 0x8B) {
+                inflateReset(d_stream);
+                continue;
+            }
+            break;
+        }
+        if (err != Z_OK && !(err == Z_BUF_ERROR && d_stream->avail_out == 0)) {
+            output.clear();
+            return false;
+        }
+    }
+    output.resize(produced);
+    return true;
+}
 
-    return reinterpret_cast<char*>(decompressedBuffer);
+std::vector<std::vector<char>> GZ::inflateBatch(const std::vector<MemoryView>& payloads, unsigned threads) {
+    std::vector<std::vector<char>> outputs(payloads.size());
+    parallelFor(payloads.size(), [&](size_t i) {
+        inflateMemory(payloads[i], outputs[i]);
+    }, threads);
+    return outputs;
 }
 
 void GZ::_read(std::istream& stream) {
-
+    if (!testGzip(stream))
+        throw new std::runtime_error("Invalid signature for GZ file!\n");
+    gz_istreambuf inflater(stream, baseOffset);
+    data.assign(std::istreambuf_iterator<char>(&inflater), std::istreambuf_iterator<char>());
+    if (!inflater.isValid())
+        throw new std::runtime_error("Couldn't inflate GZ file!\n");
 }
 
 void GZ::_write(std::ostream& stream) {
-
+    if (!deflateStream(data.data(), data.size(), stream, options))
+        throw new std::runtime_error("Couldn't deflate GZ file!\n");
 }
 
 bool GZ::_isValid(uint32_t signature) {
@@ -0,0 +1,172 @@
+#include "shendk/files/container/gz_index.h"
+
+#include <algorithm>
+#include <cstring>
+
+#include "shendk/utils/zstream_pool.h"
+
+#if defined(_WIN32)
+    #define ZLIB_WINAPI
+#endif
+
+#include "zlib.h"
+
+namespace shendk {
+
+GZIndex::GZIndex() = default;
+GZIndex::GZIndex(const std::string& filepath) { read(filepath); }
+GZIndex::~GZIndex() {}
+
+bool GZIndex::build(std::istream& stream, uint64_t _span) {
+    checkpoints.clear();
+    span = std::max<uint64_t>(_span, windowSize);
+
+    ZStreamPool::Lease inflater = ZStreamPool::acquireInflater();
+    if (!inflater) return false;
+    z_stream* d_stream = inflater.stream();
+    std::vector<char>& input = inflater->input;
+    if (input.size() < 0x10000) input.resize(0x10000);
+    std::vector<uint8_t> window(windowSize, 0); // circular output window
+
+    uint64_t totalIn = 0, totalOut = 0, last = 0;
+    d_stream->avail_out = 0;
+    bool end = false;
+    while (!end) {
+        if (d_stream->avail_in == 0) {
+            stream.read(input.data(), input.size());
+            if (stream.gcount() <= 0) return false; // truncated
+            d_stream->next_in = reinterpret_cast<Bytef*>(input.data());
+            d_stream->avail_in = static_cast<uInt>(stream.gcount());
+        }
+        if (d_stream->avail_out == 0) {
+            d_stream->next_out = window.data();
+            d_stream->avail_out = windowSize;
+        }
+
+        // inflate until the end of the next deflate block
+        uInt availIn = d_stream->avail_in, availOut = d_stream->avail_out;
+        int err = inflate(d_stream, Z_BLOCK);
+        totalIn += availIn - d_stream->avail_in;
+        totalOut += availOut - d_stream->avail_out;
+
+        if (err == Z_STREAM_END) {
+            // continue with the next gzip member if one follows
+            if (d_stream->avail_in < 2 && stream.peek() != std::char_traits<char>::eof()) {
+                std::memmove(input.data(), d_stream->next_in, d_stream->avail_in);
+                stream.read(input.data() + d_stream->avail_in, input.size() - d_stream->avail_in);
+                d_stream->next_in = reinterpret_cast<Bytef*>(input.data());
+                d_stream->avail_in += static_cast<uInt>(stream.gcount());
+            }
+            if (d_stream->avail_in >= 2 && d_stream->next_in[0] == 0x1F && d_stream->next_in[1] == 0x8B) {
+                inflateReset(d_stream);
+                continue;
+            }
+            end = true;
+        } else if (err != Z_OK && err != Z_BUF_ERROR) {
+            return false;
+        }
+
+        // block boundary (not the last block): add a checkpoint
+        if (!end && (d_stream->data_type & 128) && !(d_stream->data_type & 64) &&
+                (checkpoints.empty() || totalOut - last >= span)) {
+            Checkpoint checkpoint;
+            checkpoint.in = totalIn;
+            checkpoint.out = totalOut;
+            checkpoint.bits = static_cast<uint8_t>(d_stream->data_type & 7);
+            checkpoint.window.resize(windowSize);
+            uInt left = d_stream->avail_out;
+            if (left) std::memcpy(checkpoint.window.data(), window.data() + windowSize - left, left);
+            if (left < windowSize) std::memcpy(checkpoint.window.data() + left, window.data(), windowSize - left);
+            checkpoints.push_back(std::move(checkpoint));
+            last = totalOut;
+        }
+    }
+
+    compressedSize = totalIn;
+    uncompressedSize = totalOut;
+    return true;
+}
+
+bool GZIndex::loadOrBuild(const std::string& gzFilepath, uint64_t _span) {
+    if (!fs::exists(gzFilepath)) return false;
+    uint64_t fileSize = fs::file_size(gzFilepath);
+    int64_t fileTime = static_cast<int64_t>(fs::last_write_time(gzFilepath).time_since_epoch().count());
+    std::string cachePath = gzFilepath + ".gzi";
+
+    if (fs::exists(cachePath)) {
+        try {
+            read(cachePath);
+            if (sourceSize == fileSize && sourceTime == fileTime && span == std::max<uint64_t>(_span, windowSize)) return true;
+        } catch (std::runtime_error* e) {
+            delete e; // invalid cache, rebuild it
+        }
+    }
+
+    std::ifstream stream(gzFilepath, std::ios::binary);
+    if (!stream.is_open() || !build(stream, _span)) return false;
+    sourceSize = fileSize;
+    sourceTime = fileTime;
+    try {
+        write(cachePath);
+    } catch (std::runtime_error* e) {
+        delete e; // the index is still usable without a cache
+    }
+    return true;
+}
+
+const GZIndex::Checkpoint* GZIndex::find(uint64_t offset) const {
+    auto it = std::upper_bound(checkpoints.begin(), checkpoints.end(), offset, [](uint64_t value, const Checkpoint& checkpoint) {
+        return value < checkpoint.out;
+    });
+    if (it == checkpoints.begin()) return nullptr;
+    return &*(it - 1);
+}
+
+void GZIndex::_read(std::istream& stream) {
+    GZIndex::Header header;
+    stream.read(reinterpret_cast<char*>(&header), sizeof(GZIndex::Header));
+    if (!isValid(header.signature) || header.version != version || header.windowSize != windowSize)
+        throw new std::runtime_error("Invalid signature for GZ index file!\n");
+
+    sourceSize = header.sourceSize;
+    sourceTime = header.sourceTime;
+    compressedSize = header.compressedSize;
+    uncompressedSize = header.uncompressedSize;
+    span = header.span;
+    checkpoints.resize(header.checkpointCount);
+    for (auto& checkpoint : checkpoints) {
+        stream.read(reinterpret_cast<char*>(&checkpoint.in), sizeof(uint64_t));
+        stream.read(reinterpret_cast<char*>(&checkpoint.out), sizeof(uint64_t));
+        stream.read(reinterpret_cast<char*>(&checkpoint.bits), sizeof(uint8_t));
+        checkpoint.window.resize(windowSize);
+        stream.read(reinterpret_cast<char*>(checkpoint.window.data()), windowSize);
+    }
+    if (!stream.good())
+        throw new std::runtime_error("Truncated GZ index file!\n");
+}
+
+void GZIndex::_write(std::ostream& stream) {
+    GZIndex::Header header;
+    header.signature = signature;
+    header.version = version;
+    header.sourceSize = sourceSize;
+    header.sourceTime = sourceTime;
+    header.compressedSize = compressedSize;
+    header.uncompressedSize = uncompressedSize;
+    header.span = span;
+    header.checkpointCount = static_cast<uint32_t>(checkpoints.size());
+    header.windowSize = windowSize;
+    stream.write(reinterpret_cast<char*>(&header), sizeof(GZIndex::Header));
+    for (auto& checkpoint : checkpoints) {
+        stream.write(reinterpret_cast<const char*>(&checkpoint.in), sizeof(uint64_t));
+        stream.write(reinterpret_cast<const char*>(&checkpoint.out), sizeof(uint64_t));
+        stream.write(reinterpret_cast<const char*>(&checkpoint.bits), sizeof(uint8_t));
+        stream.write(reinterpret_cast<const char*>(checkpoint.window.data()), windowSize);
+    }
+}
+
+bool GZIndex::_isValid(uint32_t _signature) {
+    return _signature == GZIndex::signature;
+}
+
+}
@@ -1,5 +1,7 @@
 #include "shendk/files/container/idx.h"
 
+#include "shendk/utils/binary_reader.h"
+
 namespace shendk {
 
 IDX::IDX() = default;
@@ -7,8 +9,9 @@ IDX::IDX(const std::string& filepath) { read(filepath); }
 IDX::IDX(std::istream& stream) { read(stream); }
 IDX::~IDX() {}
 
-std::string IDX::getFilename(uint32_t index) {
-    if (index >= entries.size()) return "";
+const std::string& IDX::getFilename(uint32_t index) const {
+    static const std::string empty;
+    if (index >= entries.size()) return empty;
     return entries[index];
 }
 
@@ -21,50 +24,48 @@ IDX::Type IDX::getType(uint32_t signature) {
 }
 
 void IDX::_read(std::istream& stream) {
-    uint32_t signature;
-    stream.read(reinterpret_cast<char*>(&signature), sizeof(uint32_t));
+    std::vector<uint8_t> storage;
+    BinaryReader reader = BinaryReader::fromStream(stream, storage);
+
+    uint32_t signature = reader.read<uint32_t>();
 
     uint16_t entryCount;
     IDX::Type type = getType(signature);
     if (type == IDX::Type::HUMANS) {
-        stream.seekg(baseOffset, std::ios::beg);
-        stream.read(reinterpret_cast<char*>(&entryCount), sizeof(uint16_t));
-        stream.seekg(2, std::ios::cur);
+        reader.seek(0);
+        entryCount = reader.read<uint16_t>();
+        reader.skip(2);
     } else if (type == IDX::Type::IDXB || type == IDX::Type::IDXC || type == IDX::Type::IDXD) {
-        stream.seekg(6, std::ios::cur);
-        stream.read(reinterpret_cast<char*>(&entryCount), sizeof(uint16_t));
-        stream.seekg(12, std::ios::cur); // skip TABL
+        reader.skip(6);
+        entryCount = reader.read<uint16_t>();
+        reader.skip(12); // skip TABL
     } else {
-        stream.seekg(2, std::ios::cur);
-        stream.read(reinterpret_cast<char*>(&entryCount), sizeof(uint16_t));
-        stream.seekg(12, std::ios::cur); // skip TABL
+        reader.skip(2);
+        entryCount = reader.read<uint16_t>();
+        reader.skip(12); // skip TABL
     }
 
+    entries.reserve(type == IDX::Type::HUMANS ? entryCount * 2 : entryCount);
     for (int i = 0; i < entryCount; i++) {
         if (type == IDX::Type::IDX0) {
-            IDX::IDX0_Entry IDX0entry;
-            stream.read(reinterpret_cast<char*>(&IDX0entry), sizeof(IDX::IDX0_Entry));
-            entries.push_back(std::string(IDX0entry.name, 12));
+            IDX::IDX0_Entry IDX0entry = reader.read<IDX::IDX0_Entry>();
+            entries.emplace_back(IDX0entry.name, 12);
         } else if (type == IDX::Type::IDXB) {
-            IDX::IDXB_Entry IDXBentry;
-            stream.read(reinterpret_cast<char*>(&IDXBentry), sizeof(IDX::IDXB_Entry));
-            entries.push_back(std::string(IDXBentry.name, 4));
+            IDX::IDXB_Entry IDXBentry = reader.read<IDX::IDXB_Entry>();
+            entries.emplace_back(IDXBentry.name, 4);
         } else if (type == IDX::Type::IDXC) {
-            IDX::IDXC_Entry IDXCentry;
-            stream.read(reinterpret_cast<char*>(&IDXCentry), sizeof(IDX::IDXC_Entry));
-            entries.push_back(std::string(IDXCentry.name, 4));
+            IDX::IDXC_Entry IDXCentry = reader.read<IDX::IDXC_Entry>();
+            entries.emplace_back(IDXCentry.name, 4);
         } else if (type == IDX::Type::IDXD) {
-            IDX::IDXD_Entry IDXDentry;
-            stream.read(reinterpret_cast<char*>(&IDXDentry), sizeof(IDX::IDXD_Entry));
-            entries.push_back(std::string(IDXDentry.name, 4));
+            IDX::IDXD_Entry IDXDentry = reader.read<IDX::IDXD_Entry>();
+            entries.emplace_back(IDXDentry.name, 4);
         } else if (type == IDX::Type::HUMANS) {
-            IDX::HUMANS_Entry HUMANSentry;
-            int size = sizeof(IDX::HUMANS_Entry);
-            stream.read(reinterpret_cast<char*>(&HUMANSentry), sizeof(IDX::HUMANS_Entry));
+            IDX::HUMANS_Entry HUMANSentry = reader.read<IDX::HUMANS_Entry>();
             entries.push_back(std::string(HUMANSentry.name, 4) + ".PKF");
             entries.push_back(std::string(HUMANSentry.name, 4) + ".PKS");
         }
     }
+    stream.seekg(baseOffset + reader.tell(), std::ios::beg);
 }
 
 void IDX::_write(std::ostream& stream) {
@@ -23,8 +23,13 @@ void IPAC::_read(std::istream& stream) {
         entries.push_back(IPAC::Entry(entry));
     }
 
-    // read entry data
+    // read entry data (or reference it when reading from a mapping)
     for (auto& entry : entries) {
+        MemoryView view = mappedView(stream, baseOffset + entry.meta.fileOffset, entry.meta.fileSize);
+        if (view) {
+            entry.setView(view);
+            continue;
+        }
         stream.seekg(baseOffset + entry.meta.fileOffset, std::ios::beg);
         entry.readData(stream);
     }
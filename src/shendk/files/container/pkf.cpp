@@ -1,7 +1,10 @@
 #include "shendk/files/container/pkf.h"
 
+#include <memory>
+
 #include "shendk/files/container/gz.h"
 #include "shendk/node/dumy.h"
+#include "shendk/utils/gzstream.h"
 #include "shendk/utils/memstream.h"
 
 namespace shendk {
@@ -14,16 +17,18 @@ PKF::~PKF() {}
 
 void PKF::_read(std::istream& stream) {
     std::istream* _stream = &stream;
+    int64_t dataOffset = baseOffset;
 
-    // decompress if necessary
+    // inflate on the fly if necessary, offsets are relative to the decompressed data
+    std::unique_ptr<igzstream> inflated;
     if (GZ::testGzip(stream)) {
-        uint64_t bufferSize;
-        char* decompressed = GZ::inflateStream(stream, bufferSize);
-        if (decompressed == nullptr) {
+        inflated.reset(new igzstream(stream, baseOffset));
+        if (!inflated->good()) {
             return;
         }
-        _stream = new imstream(decompressed, bufferSize);
-	    Compressed = true;
+        _stream = inflated.get();
+        dataOffset = 0;
+        Compressed = true;
     } else {
         _stream->seekg(baseOffset, std::ios::beg);
     }
@@ -36,7 +41,7 @@ void PKF::_read(std::istream& stream) {
     // check for DUMY entry
     Node::Header dummyEntry;
     _stream->read(reinterpret_cast<char*>(&dummyEntry), sizeof(Node::Header));
-    _stream->seekg(baseOffset + sizeof(PKF::Header), std::ios::beg);
+    _stream->seekg(dataOffset + sizeof(PKF::Header), std::ios::beg);
     if (dummyEntry.signature == 0x594D5544) {
         DUMY dumy(*_stream);
     }
@@ -50,14 +55,34 @@ void PKF::_read(std::istream& stream) {
     }
 
     // read ipac if necessary
-    _stream->seekg(baseOffset + header.contentSize, std::ios::beg);
-    if (!stream.eof()) {
+    _stream->seekg(dataOffset + header.contentSize, std::ios::beg);
+    if (_stream->good() && _stream->peek() != std::char_traits<char>::eof()) {
         ipac = new IPAC();
+        ipac->mappedFile = mappedFile;
         ipac->read(*_stream);
     }
 }
 
 void PKF::_write(std::ostream& stream) {
+    if (!Compressed) {
+        writeContent(stream);
+        return;
+    }
+
+    // write uncompressed content to memory, then deflate it in parallel
+    int64_t outerOffset = baseOffset;
+    omstream content;
+    baseOffset = 0;
+    writeContent(content);
+    baseOffset = outerOffset;
+
+    size_t contentSize = 0;
+    char* buffer = content.getBuffer(contentSize);
+    if (!GZ::deflateStream(buffer, contentSize, stream, compression))
+        throw new std::runtime_error("Couldn't compress PKF file!\n");
+}
+
+void PKF::writeContent(std::ostream& stream) {
     // skip header
     stream.seekp(sizeof(PKF::Header), std::ios::cur);
 
@@ -1,6 +1,9 @@
 #include "shendk/files/container/pks.h"
 
+#include <memory>
+
 #include "shendk/files/container/gz.h"
+#include "shendk/utils/gzstream.h"
 #include "shendk/utils/memstream.h"
 
 namespace shendk {
@@ -13,13 +16,15 @@ PKS::~PKS() {}
 void PKS::_read(std::istream& stream) {
     std::istream* _stream = &stream;
 
+    // inflate on the fly if necessary
+    std::unique_ptr<igzstream> inflated;
     if (GZ::testGzip(stream)) {
-        uint64_t bufferSize;
-        char* decompressed = GZ::inflateStream(stream, bufferSize);
-        if (decompressed == nullptr) {
+        inflated.reset(new igzstream(stream, baseOffset));
+        if (!inflated->good()) {
             return;
         }
-        _stream = new imstream(decompressed, bufferSize);
+        _stream = inflated.get();
+        Compressed = true;
     } else {
         _stream->seekg(baseOffset, std::ios::beg);
     }
@@ -28,10 +33,26 @@ void PKS::_read(std::istream& stream) {
     if (!isValid(header.signature))
         throw new std::runtime_error("Invalid signature for PKS file!\n");
 
+    ipac.mappedFile = mappedFile;
     ipac.read(*_stream);
 }
 
 void PKS::_write(std::ostream& stream) {
+    if (!Compressed) {
+        writeContent(stream);
+        return;
+    }
+
+    // write uncompressed content to memory, then deflate it in parallel
+    omstream content;
+    writeContent(content);
+    size_t contentSize = 0;
+    char* buffer = content.getBuffer(contentSize);
+    if (!GZ::deflateStream(buffer, contentSize, stream, compression))
+        throw new std::runtime_error("Couldn't compress PKS file!\n");
+}
+
+void PKS::writeContent(std::ostream& stream) {
     stream.write(reinterpret_cast<char*>(&header), sizeof(PKS::Header));
     ipac.write(stream);
 }
@@ -1,7 +1,15 @@
 #include "shendk/files/container/tad.h"
 
+#include <algorithm>
+#include <atomic>
+#include <set>
+
 #include "shendk/utils/murmurhash2.h"
 #include "shendk/utils/hash_db.h"
+#include "shendk/utils/file_copy.h"
+#include "shendk/utils/memstream.h"
+#include "shendk/utils/parallel.h"
+#include "shendk/utils/string_helper.h"
 
 namespace shendk {
 
@@ -13,35 +21,120 @@ TAD::TAD(const std::string& filepath) {
 
 TAD::~TAD() {}
 
-bool TAD::extract(const std::string& tacFilepath, const std::string& outputFolder) {
+bool TAD::extract(const std::string& tacFilepath, const std::string& outputFolder,
+                  const std::string& filter, unsigned threads) {
     if (!fs::exists(tacFilepath)) return false;
     fs::path dir(outputFolder);
     fs::create_directories(dir);
 
-    std::ifstream inStream;
-    std::ofstream outStream;
-    inStream.open(tacFilepath, std::ios::binary);
+    FileCopier copier(tacFilepath);
+    if (!copier.isOpen()) return false;
+
+    // resolve and filter output paths, then create each directory once
     HashDB& db = HashDB::getInstance();
-    uint32_t idx = 0;
-    for (auto& entry : entries) {
-        std::string filepath = db.getFilepath(entry.hash1, entry.hash2);
+    std::vector<std::pair<const TAD::Entry*, fs::path>> jobs;
+    std::set<fs::path> directories;
+    std::set<fs::path> paths;
+    for (uint32_t idx = 0; idx < entries.size(); idx++) {
+        std::string filepath = db.getFilepath(entries[idx].hash1, entries[idx].hash2);
         if (filepath.empty()) {
             filepath = std::to_string(idx);
         }
+        if (!filter.empty() && !globMatch(filter, filepath)) continue;
         fs::path fullPath(dir);
         fullPath /= fs::path(filepath).make_preferred().relative_path();
-        fs::create_directories(fullPath.parent_path());
-        char* buffer = new char[entry.fileSize]; // TODO: allocation per entry is kinda slow, maybe use shared buffer.
-        outStream.open(fullPath, std::ios::binary);
-        inStream.seekg(entry.fileOffset);
-        inStream.read(buffer, entry.fileSize);
-        outStream.write(buffer, entry.fileSize);
-        outStream.close();
-        delete[] buffer;
-        ++idx;
+        if (!paths.insert(fullPath).second) continue;
+        directories.insert(fullPath.parent_path());
+        jobs.emplace_back(&entries[idx], fullPath);
+    }
+    for (auto& directory : directories) {
+        fs::create_directories(directory);
+    }
+
+    std::atomic<bool> success(true);
+    parallelFor(jobs.size(), [&](size_t i) {
+        const TAD::Entry& entry = *jobs[i].first;
+        if (!copier.copy(entry.fileOffset, entry.fileSize, jobs[i].second.string())) {
+            success = false;
+        }
+    }, threads);
+    return success;
+}
+
+void TAD::patch(const std::string& tacFilepath, const std::vector<TAD::Patch>& patches) {
+    std::fstream tac(tacFilepath, std::ios::binary | std::ios::in | std::ios::out);
+    if (!tac.is_open())
+        throw new std::runtime_error("Couldn't open file: " + tacFilepath + "\n");
+    for (auto& patchFile : patches) {
+        std::ifstream source(patchFile.filepath, std::ios::binary);
+        if (!source.is_open())
+            throw new std::runtime_error("Couldn't open file: " + patchFile.filepath + "\n");
+        uint64_t size = fs::file_size(patchFile.filepath);
+        if (size > UINT32_MAX)
+            throw new std::runtime_error("Patch file too large for TAC: " + patchFile.filepath + "\n");
+        patch(tac, patchFile.hash1, patchFile.hash2, source, static_cast<uint32_t>(size));
+    }
+}
+
+void TAD::patch(const std::string& tacFilepath, uint32_t hash1, uint32_t hash2, const char* data, uint32_t size) {
+    std::fstream tac(tacFilepath, std::ios::binary | std::ios::in | std::ios::out);
+    if (!tac.is_open())
+        throw new std::runtime_error("Couldn't open file: " + tacFilepath + "\n");
+    imstream source(const_cast<char*>(data), size); // input only, never written to
+    patch(tac, hash1, hash2, source, size);
+}
+
+void TAD::patch(std::fstream& tac, uint32_t hash1, uint32_t hash2, std::istream& source, uint32_t size) {
+    tac.seekp(0, std::ios::end);
+    uint64_t tacSize = static_cast<uint64_t>(tac.tellp());
+
+    auto it = std::find_if(entries.begin(), entries.end(), [&](const TAD::Entry& entry) {
+        return entry.hash1 == hash1 && entry.hash2 == hash2;
+    });
+    if (it == entries.end()) {
+        TAD::Entry entry = {};
+        entry.hash1 = hash1;
+        entry.hash2 = hash2;
+        entries.push_back(entry);
+        it = entries.end() - 1;
+    }
+
+    // old slot reaches up to the next entry (or the end of the TAC), shared slots are never reused
+    bool reuse = it->fileSize > 0;
+    uint64_t slotEnd = tacSize;
+    for (auto& entry : entries) {
+        if (&entry == &*it || entry.fileSize == 0) continue;
+        if (entry.fileOffset == it->fileOffset) reuse = false;
+        if (entry.fileOffset > it->fileOffset) slotEnd = std::min<uint64_t>(slotEnd, entry.fileOffset);
+    }
+    uint64_t offset = it->fileOffset;
+    if (!reuse || offset + size > slotEnd) {
+        offset = tacSize + (patchAlignment - tacSize % patchAlignment) % patchAlignment;
+    }
+    if (offset + size > UINT32_MAX)
+        throw new std::runtime_error("TAC exceeds the 4 GB offset range!\n");
+
+    // pad up to the new offset when appending
+    if (offset > tacSize) {
+        const char zeros[0x10] = {};
+        tac.write(zeros, static_cast<std::streamsize>(offset - tacSize));
+    }
+    tac.seekp(static_cast<std::streamoff>(offset), std::ios::beg);
+    std::vector<char> buffer(std::min<uint32_t>(size, 1 << 20));
+    for (uint32_t remaining = size; remaining > 0;) {
+        uint32_t chunk = std::min<uint32_t>(remaining, static_cast<uint32_t>(buffer.size()));
+        source.read(buffer.data(), chunk);
+        if (source.gcount() != chunk)
+            throw new std::runtime_error("Couldn't read patch data!\n");
+        tac.write(buffer.data(), chunk);
+        remaining -= chunk;
     }
-    inStream.close();
-    return true;
+    if (!tac.good())
+        throw new std::runtime_error("Couldn't write TAC file!\n");
+
+    it->fileOffset = static_cast<uint32_t>(offset);
+    it->fileSize = size;
+    header.tacSize = static_cast<uint32_t>(std::max<uint64_t>(tacSize, offset + size));
 }
 
 void TAD::_read(std::istream& stream) {
@@ -1,5 +1,7 @@
 #include "shendk/files/file.h"
 
+#include "shendk/utils/memstream.h"
+
 namespace shendk {
 
 /**
@@ -23,6 +25,31 @@ void File::read(std::istream& stream) {
     _read(stream);
 }
 
+/**
+* @brief Reads a file from memory.
+* @param data Pointer to the file data.
+* @param size Size of the file data in bytes.
+**/
+void File::read(const char* data, uint64_t size) {
+    imstream stream(const_cast<char*>(data), size); // input only, never written to
+    read(stream);
+}
+
+/**
+* @brief Reads a file through a read-only memory mapping.
+* @param filepath Path of the file.
+**/
+void File::readMapped(const std::string& filepath) {
+    if (!fs::exists(filepath)) return;
+    this->filepath = filepath;
+    mappedFile = std::make_shared<MappedFile>();
+    if (!mappedFile->open(filepath)) {
+        mappedFile.reset();
+        throw new std::runtime_error("Couldn't map file: " + filepath + "\n");
+    }
+    read(mappedFile->data(), mappedFile->size());
+}
+
 /**
 * @brief Writes a file.
 * @param filepath Path of the file.
@@ -52,4 +79,19 @@ bool File::isValid(unsigned int signature) {
     return _isValid(signature);
 }
 
+/**
+* @brief Returns a view into the file mapping if the stream reads from it.
+* @param stream Stream the file is read from.
+* @param offset Absolute stream offset of the requested data.
+* @param size Size of the requested data.
+**/
+MemoryView File::mappedView(std::istream& stream, uint64_t offset, uint64_t size) {
+    if (!mappedFile) return MemoryView();
+    MemoryView memory = getMemoryView(stream);
+    if (!mappedFile->view().contains(memory)) return MemoryView();
+    MemoryView view = memory.sub(offset, size);
+    if (view.size != size) return MemoryView();
+    return view;
+}
+
 }
@@ -2,6 +2,7 @@
 
 #include "IL/il.h"
 #include "IL/ilu.h"
+#include "IL/devil_internal_exports.h"
 
 namespace shendk {
 
@@ -89,7 +90,16 @@ void DDS::_write(std::ostream& stream) {
     }
 
     ilTexImage(width, height, 1, 4, IL_RGBA, IL_UNSIGNED_BYTE, bytes);
-    iluBuildMipmaps();
+
+    // box filtered mipmaps, DevIL only stores them
+    ResampleOptions options;
+    options.filter = ResampleFilter::Box;
+    ILimage* level = ilGetCurImage();
+    for (auto& mipmap : img->buildMipChain(options)) {
+        level->Mipmaps = ilNewImage(mipmap->width(), mipmap->height(), 1, 4, 1);
+        level = level->Mipmaps;
+        ilTexImage_(level, mipmap->width(), mipmap->height(), 1, 4, IL_RGBA, IL_UNSIGNED_BYTE, mipmap->getDataPtr());
+    }
 
     ILinfo imageInfo;
     iluGetImageInfo(&imageInfo);
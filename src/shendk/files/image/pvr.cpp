@@ -5,12 +5,83 @@
 #include "shendk/files/image/pvr/data_codec.h"
 #include "shendk/files/image/pvr/pixel_codec.h"
 #include "shendk/files/image/pvr/compression_codec.h"
+#include "shendk/files/image/pvr/palette.h"
 #include "shendk/files/image/pvr/vector_quantizer.h"
 
 #include "shendk/files/image/dds.h"
+#include "shendk/utils/binary_reader.h"
+#include "shendk/utils/memstream.h"
+#include "shendk/utils/memory_view.h"
+#include "shendk/utils/parallel.h"
 
 namespace shendk {
 
+namespace {
+
+inline bool isPowerOfTwo(uint32_t value) {
+    return value != 0 && (value & (value - 1)) == 0;
+}
+
+// offsets of the mipmaps from the largest level on, levels are stored from the smallest to the largest
+int64_t mipmapLayout(const PVR::Header& header, const pvr::DataCodec* dataCodec, pvr::PixelCodec* pixelCodec,
+                     std::vector<int64_t>& mipmapOffsets) {
+    uint16_t bpp = dataCodec->bpp(pixelCodec);
+    mipmapOffsets.clear();
+    if (!dataCodec->hasMipmaps()) {
+        mipmapOffsets.push_back(0);
+        return static_cast<int64_t>(dataCodec->dataSize(header.width, header.height, pixelCodec));
+    }
+    int8_t mipmapCount = static_cast<int8_t>(std::log2(header.width) + 1);
+    mipmapOffsets.resize(mipmapCount);
+    int64_t dataSize = 0;
+    if (header.dataFormat == pvr::DataFormat::SQUARE_TWIDDLED_MIPMAP) {
+        dataSize = bpp >> 3; // A 1x1 mipmap takes up as much space as a 2x1 mipmap
+    } else if (header.dataFormat == pvr::DataFormat::SQUARE_TWIDDLED_MIPMAP_ALT) {
+        dataSize = (3 * bpp) >> 3; // A 1x1 mipmap takes up as much space as a 2x2 mipmap
+    }
+    for (int i = mipmapCount - 1, size = 1; i >= 0; i--, size <<= 1) {
+        mipmapOffsets[i] = dataSize;
+        dataSize += std::max((size * size * bpp) >> 3, 1);
+    }
+    return dataSize;
+}
+
+// BGRA rows of an image in pvr order (bottom up)
+std::vector<uint8_t> toBGRA(const Image& image) {
+    uint32_t width = image.width(), height = image.height();
+    std::vector<uint8_t> result(static_cast<size_t>(width) * height * 4);
+    uint8_t* pixel = result.data();
+    for (uint32_t y = height; y-- > 0;) {
+        const RGBA* row = image.getDataPtr() + static_cast<size_t>(y) * width;
+        for (uint32_t x = 0; x < width; x++, pixel += 4) {
+            pixel[0] = row[x].b;
+            pixel[1] = row[x].g;
+            pixel[2] = row[x].r;
+            pixel[3] = row[x].a;
+        }
+    }
+    return result;
+}
+
+// the 12 byte GBIX chunk, its size always covers just the index
+void writeGlobalIndex(std::ostream& stream, PVR::GBIX& globalIndex) {
+    globalIndex.size = sizeof(PVR::GBIX) - 8;
+    stream.write(reinterpret_cast<char*>(&globalIndex), sizeof(PVR::GBIX));
+}
+
+std::vector<uint8_t> toBGRA(const RGBA* colors, size_t count) {
+    std::vector<uint8_t> result(count * 4);
+    for (size_t i = 0; i < count; i++) {
+        result[i * 4]     = colors[i].b;
+        result[i * 4 + 1] = colors[i].g;
+        result[i * 4 + 2] = colors[i].r;
+        result[i * 4 + 3] = colors[i].a;
+    }
+    return result;
+}
+
+}
+
 PVR::PVR() = default;
 PVR::PVR(const std::string& filepath) { read(filepath); }
 PVR::PVR(std::istream& stream) { read(stream); }
@@ -48,6 +119,8 @@ void PVR::_read(std::istream& stream) {
     if (gbixOffset >= 0) {
         stream.seekg(baseOffset + gbixOffset, std::ios::beg);
         stream.read(reinterpret_cast<char*>(&globalIndex), sizeof(GBIX));
+        // PVRT follows the chunk's size field, sizes below the index field come from older writers
+        pvrtOffset = gbixOffset + 8 + std::max<uint32_t>(globalIndex.size, sizeof(GBIX) - 8);
     }
 
     // read pvrt header
@@ -61,11 +134,15 @@ void PVR::_read(std::istream& stream) {
             mipmaps.push_back(mipmap);
         }
     } else {
-        pvr::PixelCodec* pixelCodec = pvr::PixelCodec::getPixelCodec(header.pixelFormat);
-        pvr::DataCodec* dataCodec = pvr::DataCodec::getDataCodec(header.dataFormat);
-        if (dataCodec != nullptr && pixelCodec != nullptr) {
-            dataCodec->pixelCodec = pixelCodec; // TODO: this is bad lazy initialization
+        pvr::PixelCodec* pixelCodec = pvr::PixelCodec::get(header.pixelFormat);
+        const pvr::DataCodec* dataCodec = pvr::DataCodec::get(header.dataFormat);
+        if (dataCodec == nullptr || pixelCodec == nullptr) {
+            throw new std::runtime_error("Unsupported PVR pixel or data format");
         }
+        if (dataCodec->needsExternalPalette() && palette.size() < dataCodec->paletteEntries(header.width)) {
+            throw new std::runtime_error("PVR texture needs an external palette");
+        }
+        uint16_t bpp = dataCodec->bpp(pixelCodec);
 
         // check for palette
         uint16_t paletteEntries = dataCodec->paletteEntries(header.width);
@@ -79,88 +156,84 @@ void PVR::_read(std::istream& stream) {
             dataOffset = paletteOffset + (paletteEntries * (pixelCodec->bpp() >> 3));
         }
 
-        // check for compression
+        // check for compression (decompressed size in front of the texture)
         pvr::CompressionFormat compressionFormat = pvr::CompressionFormat::NONE;
+        bool prefixed = gbixOffset == 4 || (gbixOffset < 0 && pvrtOffset == 4);
         uint32_t first, second;
         stream.seekg(baseOffset, std::ios::beg);
         stream.read(reinterpret_cast<char*>(&first), sizeof(uint32_t));
         stream.seekg(baseOffset + pvrtOffset + 4, std::ios::beg);
         stream.read(reinterpret_cast<char*>(&second), sizeof(uint32_t));
-        if (first == second - pvrtOffset + dataOffset + 8) {
+        if (prefixed && (first == second - pvrtOffset + dataOffset + 8 || first == second + pvrtOffset + 4)) {
             compressionFormat = pvr::CompressionFormat::RLE;
         }
-        pvr::CompressionCodec* compressionCodec = pvr::CompressionCodec::getCompressionCodec(compressionFormat);
-        if (compressionFormat != pvr::CompressionFormat::NONE && compressionCodec != nullptr) {
-            throw new std::runtime_error("Compression codecs not implemented");
+        if (compressionFormat == pvr::CompressionFormat::RLE) {
+            // decompress the whole texture and read it from memory
+            stream.seekg(baseOffset, std::ios::beg);
+            std::vector<uint8_t> storage;
+            BinaryReader input = BinaryReader::fromStream(stream, storage);
+            std::vector<char> decompressed(pvr::CompressionCodec::decompressedSize(input.data(), input.size()));
+            uint64_t compressedSize = pvr::RLE::decompress(input.data(), input.size(), dataOffset, pvr::RLE::pixelSize(bpp),
+                                                           reinterpret_cast<uint8_t*>(decompressed.data()), decompressed.size());
+            if (compressedSize == 0) {
+                throw new std::runtime_error("Invalid RLE compressed texture");
+            }
+            imstream decompressedStream(decompressed.data(), decompressed.size());
+            _read(decompressedStream);
+            stream.seekg(baseOffset + static_cast<int64_t>(compressedSize), std::ios::beg);
+            return;
         }
-        delete compressionCodec;
 
         // get mipmap offsets
         std::vector<int64_t> mipmapOffsets;
-        if (dataCodec->hasMipmaps()) {
-            int8_t mipmapCount = static_cast<int8_t>(std::log2(header.width) + 1);
-            int64_t mipmapOffset = 0;
-            if (header.dataFormat == pvr::DataFormat::SQUARE_TWIDDLED_MIPMAP) {
-                mipmapOffset = dataCodec->bpp() >> 3; // A 1x1 mipmap takes up as much space as a 2x1 mipmap
-            } else if (header.dataFormat == pvr::DataFormat::SQUARE_TWIDDLED_MIPMAP_ALT) {
-                mipmapOffset = (3 * dataCodec->bpp()) >> 3; // A 1x1 mipmap takes up as much space as a 2x2 mipmap
-            }
-            for (int i = mipmapCount - 1, size = 1; i >= 0; i--, size <<= 1) {
-                mipmapOffsets.push_back(mipmapOffset);
-                mipmapOffset += std::max((size * size * dataCodec->bpp()) >> 3, 1);
-            }
+        int64_t dataSize = mipmapLayout(header, dataCodec, pixelCodec, mipmapOffsets);
+
+        // fetch palette and texture data at once, in place for memory streams
+        int64_t textureOffset = paletteOffset != -1 ? paletteOffset : dataOffset;
+        uint64_t textureSize = static_cast<uint64_t>(dataOffset - textureOffset + dataSize);
+        std::vector<uint8_t> storage;
+        const uint8_t* texture = nullptr;
+        MemoryView memory = getMemoryView(stream).sub(static_cast<uint64_t>(baseOffset + textureOffset), textureSize);
+        if (memory.size == textureSize) {
+            texture = reinterpret_cast<const uint8_t*>(memory.data);
         } else {
-            mipmapOffsets.push_back(0);
+            storage.resize(textureSize);
+            stream.seekg(baseOffset + textureOffset, std::ios::beg);
+            stream.read(reinterpret_cast<char*>(storage.data()), textureSize);
+            if (static_cast<uint64_t>(stream.gcount()) != textureSize) {
+                throw new std::runtime_error("Unexpected end of PVR texture data");
+            }
+            texture = storage.data();
         }
 
         // decode palette if available
+        std::vector<uint8_t> bgraPalette;
         if (paletteOffset != -1) {
-            stream.seekg(baseOffset + paletteOffset, std::ios::beg);
-            dataCodec->setPalette(stream, paletteEntries);
+            bgraPalette.resize(paletteEntries * 4);
+            pixelCodec->decodeRow(texture, bgraPalette.data(), paletteEntries);
+        } else if (dataCodec->needsExternalPalette()) {
+            bgraPalette = toBGRA(palette.data(), palette.size());
         }
 
-        // decode mipmaps
+        // decode mipmaps straight into the (vertically flipped) images
         mipmaps.clear();
+        const uint8_t* data = texture + (dataOffset - textureOffset);
         if (dataCodec->hasMipmaps()) {
             for (uint16_t i = 0, size = header.width; i < mipmapOffsets.size(); i++, size >>= 1) {
-                stream.seekg(baseOffset + dataOffset + mipmapOffsets[i], std::ios::beg);
-                uint8_t* pixels = dataCodec->decode(stream, size, size, pixelCodec);
                 std::shared_ptr<Image> mipmap(new Image(size, size));
-                for (int j = 0; j < size * size; j++) {
-                    mipmap->operator[](j).b = pixels[j * 4];
-                    mipmap->operator[](j).g = pixels[j * 4 + 1];
-                    mipmap->operator[](j).r = pixels[j * 4 + 2];
-                    mipmap->operator[](j).a = pixels[j * 4 + 3];
-                }
-                mipmap->flipVertical();
-                //memcpy(mipmap->getDataPtr(), pixels, mipmap->size());
+                dataCodec->decodeInto(data + mipmapOffsets[i], size, size, pixelCodec, bgraPalette.data(),
+                                      pvr::PixelView::of(*mipmap, true));
                 mipmaps.push_back(mipmap);
-                delete[] pixels;
             }
         } else {
-            stream.seekg(baseOffset + dataOffset + mipmapOffsets[0], std::ios::beg);
-            uint8_t* pixels = dataCodec->decode(stream, header.width, header.height, pixelCodec);
             std::shared_ptr<Image> mipmap(new Image(header.width, header.height));
-            for (int i = 0; i < header.width * header.height; i++) {
-                mipmap->operator[](i).b = pixels[i * 4];
-                mipmap->operator[](i).g = pixels[i * 4 + 1];
-                mipmap->operator[](i).r = pixels[i * 4 + 2];
-                mipmap->operator[](i).a = pixels[i * 4 + 3];
-            }
-            mipmap->flipVertical();
-            //memcpy(mipmap->getDataPtr(), pixels, mipmap->size());
+            dataCodec->decodeInto(data, header.width, header.height, pixelCodec, bgraPalette.data(),
+                                  pvr::PixelView::of(*mipmap, true));
             mipmaps.push_back(mipmap);
-            delete[] pixels;
-        }
-
-        // move stream to end of pvr
-        stream.seekg(baseOffset + header.size, std::ios::beg);
-        if (globalIndex.size != 0) {
-            stream.seekg(sizeof(PVR::GBIX), std::ios::cur);
         }
 
-        delete pixelCodec;
-        delete dataCodec;
+        // move stream to end of pvr (size counts the bytes after the size field)
+        stream.seekg(baseOffset + pvrtOffset + 8 + header.size, std::ios::beg);
     }
 }
 
@@ -173,7 +246,7 @@ void PVR::_write(std::ostream& stream) {
             throw std::runtime_error("Expected DDS RGB24 or RGBA32 color format!");
         }
         if (hasGlobalIndex) {
-            stream.write(reinterpret_cast<char*>(&globalIndex), sizeof(GBIX));
+            writeGlobalIndex(stream, globalIndex);
         }
         int64_t headerOffset = stream.tellp();
         stream.write(reinterpret_cast<char*>(&header), sizeof(Header));
@@ -194,45 +267,138 @@ void PVR::_write(std::ostream& stream) {
 
         stream.seekp(endOffset, std::ios::beg);
     } else {
-
-        throw std::runtime_error("Not implemented yet!");
-
-        pvr::PixelCodec* pixelCodec = pvr::PixelCodec::getPixelCodec(header.pixelFormat);
-        pvr::DataCodec* dataCodec = pvr::DataCodec::getDataCodec(header.dataFormat);
-
+        if (mipmaps.empty()) {
+            throw new std::runtime_error("PVR has no image to write!");
+        }
+        pvr::PixelCodec* pixelCodec = pvr::PixelCodec::get(header.pixelFormat);
+        const pvr::DataCodec* dataCodec = pvr::DataCodec::get(header.dataFormat);
         if (pixelCodec == nullptr) {
             throw new std::runtime_error("Invalid pixel codec!");
         }
         if (dataCodec == nullptr) {
             throw new std::runtime_error("Invalid data codec!");
         }
-        dataCodec->pixelCodec = pixelCodec; // TODO: again lazy initialization
 
-        uint8_t* decodedData = nullptr;
+        header.width = static_cast<uint16_t>(mipmaps.front()->width());
+        header.height = static_cast<uint16_t>(mipmaps.front()->height());
+        bool rectangle = header.dataFormat == pvr::DataFormat::RECTANGLE || header.dataFormat == pvr::DataFormat::RECTANGLE_STRIDE;
+        if (!rectangle && (!isPowerOfTwo(header.width) || !isPowerOfTwo(header.height))) {
+            throw new std::runtime_error("Twiddled PVR textures need power of two sizes!");
+        }
+        if ((dataCodec->hasMipmaps() || dataCodec->vq() || header.dataFormat == pvr::DataFormat::SQUARE_TWIDDLED) &&
+            header.width != header.height) {
+            throw new std::runtime_error("PVR data format needs a square texture!");
+        }
 
-        // TODO: implement
+        // mipmap levels from the largest on, missing ones are box filtered from the largest
+        std::vector<std::shared_ptr<Image>> levels = { mipmaps.front() };
+        if (dataCodec->hasMipmaps()) {
+            std::vector<std::shared_ptr<Image>> chain;
+            for (uint32_t size = header.width >> 1; size > 0; size >>= 1) {
+                size_t i = levels.size();
+                if (i < mipmaps.size() && static_cast<uint32_t>(mipmaps[i]->width()) == size && static_cast<uint32_t>(mipmaps[i]->height()) == size) {
+                    levels.push_back(mipmaps[i]);
+                    continue;
+                }
+                if (chain.empty()) {
+                    ResampleOptions options;
+                    options.filter = ResampleFilter::Box;
+                    chain = mipmaps.front()->buildMipChain(options);
+                }
+                levels.push_back(chain[i - 1]);
+            }
+        }
+        std::vector<int64_t> mipmapOffsets;
+        int64_t dataSize = mipmapLayout(header, dataCodec, pixelCodec, mipmapOffsets);
 
-        // encode palette if necessary
-        if (dataCodec->paletteEntries(header.width) != 0) {
-            if (dataCodec->vq()) {
+        // linear BGRA rows in file order (bottom up)
+        std::vector<std::vector<uint8_t>> pixels(levels.size());
+        parallelFor(levels.size(), [&](size_t i) {
+            pixels[i] = toBGRA(*levels[i]);
+        });
+
+        // code book or palette, VQ levels are encoded from their indices then
+        uint16_t paletteEntries = dataCodec->paletteEntries(header.width);
+        std::vector<uint8_t> bgraPalette;
+        std::vector<uint8_t> indices;
+        std::vector<uint64_t> indexOffsets;
+        if (dataCodec->vq()) {
+            pvr::VQBlocks blocks(2, 2);
+            for (size_t i = 0; i < levels.size(); i++) {
+                indexOffsets.push_back(blocks.count());
+                blocks.add(pixels[i].data(), levels[i]->width(), levels[i]->height());
+            }
+            bgraPalette = pvr::createCodeBook(blocks, paletteEntries / 4);
+            indices = pvr::quantize(blocks, bgraPalette);
 
+            // code book blocks are row major, VQ codewords store their texels in twiddled order
+            for (uint64_t i = 0; i < bgraPalette.size(); i += 16) {
+                std::swap_ranges(bgraPalette.begin() + i + 4, bgraPalette.begin() + i + 8, bgraPalette.begin() + i + 8);
+            }
+        } else if (dataCodec->needsExternalPalette()) {
+            if (palette.empty()) {
+                pvr::VQBlocks colors(1, 1);
+                for (size_t i = 0; i < levels.size(); i++) {
+                    colors.add(pixels[i].data(), levels[i]->width(), levels[i]->height());
+                }
+                bgraPalette = pvr::createPalette(colors, paletteEntries);
+                palette.resize(paletteEntries);
+                for (uint16_t i = 0; i < paletteEntries; i++) {
+                    palette[i] = { bgraPalette[i * 4 + 2], bgraPalette[i * 4 + 1], bgraPalette[i * 4], bgraPalette[i * 4 + 3] };
+                }
             } else {
+                bgraPalette = toBGRA(palette.data(), std::min<size_t>(palette.size(), paletteEntries));
+            }
+        }
 
+        // encode mipmaps, palettized levels are mapped to their indices in parallel by the codec
+        std::vector<uint8_t> data(static_cast<size_t>(dataSize));
+        if (dataCodec->needsExternalPalette()) {
+            pvr::PaletteSearch search(bgraPalette);
+            for (size_t i = 0; i < levels.size(); i++) {
+                dataCodec->encodeIndexed(pixels[i].data(), levels[i]->width(), levels[i]->height(), search,
+                                         data.data() + mipmapOffsets[i]);
             }
+        } else {
+            parallelFor(levels.size(), [&](size_t i) {
+                const uint8_t* src = indices.empty() ? pixels[i].data() : indices.data() + indexOffsets[i];
+                dataCodec->encodeInto(src, levels[i]->width(), levels[i]->height(), pixelCodec, data.data() + mipmapOffsets[i]);
+            });
         }
 
-        delete pixelCodec;
-        delete dataCodec;
+        if (hasGlobalIndex) {
+            writeGlobalIndex(stream, globalIndex);
+        }
+        uint64_t paletteSize = 0;
+        uint8_t* encodedPalette = nullptr;
+        if (dataCodec->vq()) {
+            paletteSize = paletteEntries * (pixelCodec->bpp() >> 3);
+            encodedPalette = pixelCodec->encodePalette(bgraPalette.data(), paletteEntries);
+        }
+        header.size = static_cast<uint32_t>(sizeof(Header) - 8 + paletteSize + data.size());
+        stream.write(reinterpret_cast<char*>(&header), sizeof(Header));
+        if (encodedPalette != nullptr) {
+            stream.write(reinterpret_cast<char*>(encodedPalette), paletteSize);
+            delete[] encodedPalette;
+        }
+        stream.write(reinterpret_cast<char*>(data.data()), data.size());
     }
 }
 
-bool PVR::_isValid(uint32_t signature) {
-    // TODO: implement
-    return false;
+std::vector<uint8_t> PVR::encodePalette() const {
+    pvr::PixelCodec* pixelCodec = pvr::PixelCodec::get(header.pixelFormat);
+    if (pixelCodec == nullptr) {
+        throw new std::runtime_error("Invalid pixel codec!");
+    }
+    std::vector<uint8_t> bgraPalette = toBGRA(palette.data(), palette.size());
+    uint8_t* encoded = pixelCodec->encodePalette(bgraPalette.data(), static_cast<uint32_t>(palette.size()));
+    std::vector<uint8_t> result(encoded, encoded + palette.size() * (pixelCodec->bpp() >> 3));
+    delete[] encoded;
+    return result;
 }
 
-std::vector<char> PVR::bitmapToRawVQ(std::shared_ptr<Image> img, uint16_t codeBookSize, std::vector<char>& palette) {
-    return std::vector<char>();
+bool PVR::_isValid(uint32_t signature) {
+    return signature == gbix || signature == pvrt;
 }
 
 }
@@ -0,0 +1,181 @@
+#include "shendk/files/image/pvr/code_book_search.h"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <numeric>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+    #include <emmintrin.h>
+    #define SHENDK_VQ_SSE2
+#endif
+
+namespace shendk {
+namespace pvr {
+
+namespace {
+
+#if defined(SHENDK_VQ_SSE2)
+inline float horizontalSum(__m128 sum) {
+    sum = _mm_add_ps(sum, _mm_movehl_ps(sum, sum));
+    sum = _mm_add_ss(sum, _mm_shuffle_ps(sum, sum, 1));
+    return _mm_cvtss_f32(sum);
+}
+#endif
+
+/**
+ * @brief Squared error of two blocks, given up (returning a value above limit) once
+ *        the sum of every 8 channels exceeds limit.
+ */
+inline float partialDistance(const float* a, const float* b, uint32_t dimensions, float limit) {
+#if defined(SHENDK_VQ_SSE2)
+    __m128 sum = _mm_setzero_ps();
+    for (uint32_t i = 0; i < dimensions; i += 4) {
+        __m128 difference = _mm_sub_ps(_mm_loadu_ps(a + i), _mm_loadu_ps(b + i));
+        sum = _mm_add_ps(sum, _mm_mul_ps(difference, difference));
+        if ((i & 4) && i + 4 < dimensions) {
+            float partial = horizontalSum(sum);
+            if (partial > limit) return partial;
+        }
+    }
+    return horizontalSum(sum);
+#else
+    float sum = 0.0f;
+    for (uint32_t i = 0; i < dimensions; i++) {
+        float difference = a[i] - b[i];
+        sum += difference * difference;
+        if ((i & 7) == 7 && sum > limit) return sum;
+    }
+    return sum;
+#endif
+}
+
+inline float dot(const float* a, const float* b, uint32_t dimensions) {
+    float sum = 0.0f;
+    for (uint32_t i = 0; i < dimensions; i++) {
+        sum += a[i] * b[i];
+    }
+    return sum;
+}
+
+/**
+ * @brief Dominant eigenvector of the entries' covariance (power iteration).
+ */
+std::vector<float> principalAxis(const float* codeBook, uint32_t size, uint32_t dimensions) {
+    std::vector<double> mean(dimensions, 0.0);
+    for (uint32_t i = 0; i < size; i++) {
+        for (uint32_t d = 0; d < dimensions; d++) {
+            mean[d] += codeBook[static_cast<uint64_t>(i) * dimensions + d];
+        }
+    }
+    for (double& value : mean) value /= size;
+
+    std::vector<double> covariance(static_cast<uint64_t>(dimensions) * dimensions, 0.0);
+    std::vector<double> centered(dimensions);
+    for (uint32_t i = 0; i < size; i++) {
+        for (uint32_t d = 0; d < dimensions; d++) {
+            centered[d] = codeBook[static_cast<uint64_t>(i) * dimensions + d] - mean[d];
+        }
+        for (uint32_t r = 0; r < dimensions; r++) {
+            for (uint32_t c = 0; c < dimensions; c++) {
+                covariance[r * dimensions + c] += centered[r] * centered[c];
+            }
+        }
+    }
+
+    std::vector<double> axis(dimensions, 1.0 / std::sqrt(static_cast<double>(dimensions)));
+    std::vector<double> next(dimensions);
+    for (int iteration = 0; iteration < 24; iteration++) {
+        double norm = 0.0;
+        for (uint32_t r = 0; r < dimensions; r++) {
+            next[r] = 0.0;
+            for (uint32_t c = 0; c < dimensions; c++) {
+                next[r] += covariance[r * dimensions + c] * axis[c];
+            }
+            norm += next[r] * next[r];
+        }
+        if (norm <= 0.0) break; // all entries are equal, keep the diagonal
+        norm = std::sqrt(norm);
+        for (uint32_t r = 0; r < dimensions; r++) {
+            axis[r] = next[r] / norm;
+        }
+    }
+    return std::vector<float>(axis.begin(), axis.end());
+}
+
+}
+
+CodeBookSearch::CodeBookSearch(const float* codeBook, uint32_t size, uint32_t dimensions) {
+    build(codeBook, size, dimensions);
+}
+
+CodeBookSearch::CodeBookSearch(const std::vector<uint8_t>& codeBook, uint32_t dimensions) {
+    std::vector<float> entries(codeBook.begin(), codeBook.end());
+    build(entries.data(), static_cast<uint32_t>(codeBook.size() / dimensions), dimensions);
+}
+
+void CodeBookSearch::build(const float* codeBook, uint32_t size, uint32_t dimensions) {
+    m_dimensions = dimensions;
+    m_axis = principalAxis(codeBook, size, dimensions);
+
+    std::vector<float> projections(size);
+    for (uint32_t i = 0; i < size; i++) {
+        projections[i] = dot(codeBook + static_cast<uint64_t>(i) * dimensions, m_axis.data(), dimensions);
+    }
+    m_indices.resize(size);
+    std::iota(m_indices.begin(), m_indices.end(), 0);
+    std::stable_sort(m_indices.begin(), m_indices.end(), [&](uint32_t a, uint32_t b) {
+        return projections[a] < projections[b];
+    });
+
+    m_entries.resize(static_cast<uint64_t>(size) * dimensions);
+    m_projections.resize(size);
+    for (uint32_t i = 0; i < size; i++) {
+        const float* entry = codeBook + static_cast<uint64_t>(m_indices[i]) * dimensions;
+        std::copy(entry, entry + dimensions, m_entries.begin() + static_cast<uint64_t>(i) * dimensions);
+        m_projections[i] = projections[m_indices[i]];
+    }
+}
+
+uint32_t CodeBookSearch::nearest(const float* block, float& distance) const {
+    int64_t count = static_cast<int64_t>(m_indices.size());
+    if (count == 0) {
+        distance = 0.0f;
+        return 0;
+    }
+
+    // start at the entry with the closest projection
+    float projection = dot(block, m_axis.data(), m_dimensions);
+    int64_t start = std::lower_bound(m_projections.begin(), m_projections.end(), projection) - m_projections.begin();
+    start = std::min(start, count - 1);
+    float best = partialDistance(block, m_entries.data() + start * m_dimensions, m_dimensions, std::numeric_limits<float>::infinity());
+    int64_t bestEntry = start;
+
+    // the projection gap is a lower bound of the distance, on both sides it only grows
+    auto visit = [&](int64_t entry) {
+        float gap = m_projections[entry] - projection;
+        if (gap * gap > best) return false;
+        float d = partialDistance(block, m_entries.data() + entry * m_dimensions, m_dimensions, best);
+        if (d < best || (d == best && m_indices[entry] < m_indices[bestEntry])) {
+            best = d;
+            bestEntry = entry;
+        }
+        return true;
+    };
+    int64_t down = start - 1;
+    int64_t up = start + 1;
+    while (down >= 0 || up < count) {
+        if (up < count) {
+            up = visit(up) ? up + 1 : count;
+        }
+        if (down >= 0) {
+            down = visit(down) ? down - 1 : -1;
+        }
+    }
+
+    distance = best;
+    return m_indices[bestEntry];
+}
+
+}
+}
@@ -23,82 +23,127 @@ CompressionCodec* CompressionCodec::getCompressionCodec(CompressionFormat format
     }
 }
 
-// TODO: implement (not needed for shenmue at the moment)
+uint32_t CompressionCodec::decompressedSize(const uint8_t* input, uint64_t inputLength) {
+    if (inputLength < sizeof(uint32_t)) return 0;
+    uint32_t size;
+    memcpy(&size, input, sizeof(uint32_t));
+    return size;
+}
 
-uint8_t* RLE::decompress(uint8_t* input, uint32_t inputLength, uint64_t dataOffset, DataCodec* dataCodec) {
-    /*
-    uint32_t outputLength = *reinterpret_cast<uint32_t*>(input);
-    uint8_t* output     = new uint8_t[outputLength];
-    uint64_t sourcePointer = dataOffset;
-    uint64_t destPointer   = 0x00;
-    uint16_t pixelSize     = (dataCodec->bpp() >> 3);
-
-    if (dataOffset - 4 > 0) {
-        Array.Copy(input, 0x04, output, 0x00, dataOffset - 4);
-        destPointer += (dataOffset - 4);
+namespace {
+
+/**
+ * @brief Counts how often the pixel in front of data repeats, up to limit.
+ *        Pixel sizes that divide 8 are compared 8 bytes (several pixels) at a time.
+ */
+uint32_t repeatCount(const uint8_t* pixel, const uint8_t* data, const uint8_t* end, uint16_t pixelSize, uint32_t limit) {
+    uint64_t available = static_cast<uint64_t>(end - data) / pixelSize;
+    limit = static_cast<uint32_t>(std::min<uint64_t>(limit, available));
+    uint32_t count = 0;
+
+    if (8 % pixelSize == 0) {
+        uint64_t pattern;
+        for (uint16_t i = 0; i < 8; i += pixelSize) {
+            memcpy(reinterpret_cast<uint8_t*>(&pattern) + i, pixel, pixelSize);
+        }
+        const uint32_t pixelsPerWord = 8 / pixelSize;
+        while (count + pixelsPerWord <= limit) {
+            uint64_t word;
+            memcpy(&word, data, sizeof(uint64_t));
+            if (word != pattern) break;
+            data += 8;
+            count += pixelsPerWord;
+        }
     }
 
-    while (sourcePointer < inputLength && destPointer < outputLength) {
-        int amount = input[sourcePointer + pixelSize] + 1;
-        for (int i = 0; i < amount; i++) {
-            Array.Copy(input, sourcePointer, output, destPointer, pixelSize);
-            destPointer += pixelSize;
-        }
-        sourcePointer += pixelSize + 1;
+    while (count < limit && memcmp(data, pixel, pixelSize) == 0) {
+        data += pixelSize;
+        count++;
     }
-    return output;*/
-    return nullptr;
+    return count;
 }
 
-uint8_t* RLE::compress(uint8_t* input, uint32_t inputLength, uint64_t dataOffset, DataCodec* dataCodec) {
-    /*if (dataCodec->bpp() < 8) return input;
-    int sourcePointer   = dataOffset;
-    int destPointer     = dataOffset + 4;
-    int pixelSize = (dataCodec->bpp() >> 3);
+}
 
-    omstream output;
-    Writer.Write(inputLength);
-    Writer.Write(input, 0x00, dataOffset);
-    while (sourcePointer < inputLength)
-    {
-        uint8_t* pixel = new uint8_t[pixelSize];
-        Array.Copy(input, sourcePointer, pixel, 0x00, pixelSize);
-        Writer.Write(pixel);
-        sourcePointer += pixelSize;
-        destPointer   += pixelSize;
-
-        int repeat = 0;
-        while (SourcePointer + PixelSize < inputLength && repeat < 255)
-        {
-            bool match = true;
-
-            for (int i = 0; i < PixelSize && match; i++)
-            {
-                if (input[SourcePointer + i] != pixel[i])
-                {
-                    match = false;
-                    break;
-                }
-            }
+uint16_t RLE::pixelSize(DataCodec* dataCodec) {
+    return pixelSize(dataCodec->bpp());
+}
 
-            if (match)
-            {
-                repeat++;
-                SourcePointer += PixelSize;
+uint16_t RLE::pixelSize(uint16_t bpp) {
+    return std::max<uint16_t>(bpp >> 3, 1);
+}
+
+uint64_t RLE::decompress(const uint8_t* input, uint64_t inputLength, uint64_t dataOffset, uint16_t pixelSize,
+                         uint8_t* output, uint64_t outputLength) {
+    if (pixelSize == 0 || dataOffset < sizeof(uint32_t) || dataOffset > inputLength) return 0;
+
+    // texture header is stored uncompressed
+    uint64_t headerSize = std::min<uint64_t>(dataOffset - sizeof(uint32_t), outputLength);
+    memcpy(output, input + sizeof(uint32_t), headerSize);
+
+    const uint8_t* source = input + dataOffset;
+    const uint8_t* sourceEnd = input + inputLength;
+    uint8_t* destination = output + headerSize;
+    uint8_t* destinationEnd = output + outputLength;
+    while (destination < destinationEnd) {
+        if (static_cast<uint64_t>(sourceEnd - source) < pixelSize + 1u) return 0;
+        uint64_t runSize = (static_cast<uint64_t>(source[pixelSize]) + 1) * pixelSize;
+        runSize = std::min<uint64_t>(runSize, destinationEnd - destination);
+
+        if (pixelSize == 1) {
+            memset(destination, source[0], runSize);
+        } else {
+            // seed one pixel, then double the filled range
+            uint64_t filled = std::min<uint64_t>(pixelSize, runSize);
+            memcpy(destination, source, filled);
+            while (filled < runSize) {
+                uint64_t count = std::min(filled, runSize - filled);
+                memcpy(destination + filled, destination, count);
+                filled += count;
             }
-            else
-                break;
         }
-
-        Writer.Write((byte)repeat);
-        DestPointer++;
+        destination += runSize;
+        source += pixelSize + 1;
     }
+    return static_cast<uint64_t>(source - input);
+}
 
-    Writer.Flush();
+uint8_t* RLE::decompress(uint8_t* input, uint32_t inputLength, uint64_t dataOffset, DataCodec* dataCodec) {
+    uint32_t outputLength = decompressedSize(input, inputLength);
+    uint8_t* output = new uint8_t[outputLength];
+    if (decompress(input, inputLength, dataOffset, pixelSize(dataCodec), output, outputLength) == 0) {
+        delete[] output;
+        return nullptr;
+    }
+    return output;
+}
 
+uint8_t* RLE::compress(uint8_t* input, uint32_t inputLength, uint64_t dataOffset, DataCodec* dataCodec, uint64_t& outputLength) {
+    uint16_t size = pixelSize(dataCodec);
+    dataOffset = std::min<uint64_t>(dataOffset, inputLength);
+
+    // worst case every pixel is followed by a zero repeat count
+    uint64_t pixelCount = (inputLength - dataOffset + size - 1) / size;
+    uint8_t* output = new uint8_t[sizeof(uint32_t) + dataOffset + pixelCount * (size + 1)];
+    memcpy(output, &inputLength, sizeof(uint32_t));
+    memcpy(output + sizeof(uint32_t), input, dataOffset);
+
+    uint8_t* destination = output + sizeof(uint32_t) + dataOffset;
+    const uint8_t* source = input + dataOffset;
+    const uint8_t* end = input + inputLength;
+    while (source < end) {
+        uint16_t available = static_cast<uint16_t>(std::min<uint64_t>(size, end - source));
+        memcpy(destination, source, available);
+        memset(destination + available, 0, size - available);
+        const uint8_t* next = source + available;
+        uint32_t repeat = available == size ? repeatCount(source, next, end, size, 255) : 0;
+        destination[size] = static_cast<uint8_t>(repeat);
+        destination += size + 1;
+        source = next + repeat * size;
+    }
 
-    return output.ToArray();*/
-    return nullptr;
+    outputLength = static_cast<uint64_t>(destination - output);
+    return output;
 }
 
 }
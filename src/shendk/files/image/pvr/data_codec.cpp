@@ -2,31 +2,187 @@
 
 #include <cstring>
 #include <algorithm>
+#include <stdexcept>
+#include <vector>
 #include "shendk/utils/math.h"
 #include "shendk/files/image/pvr/twiddle.h"
+#include "shendk/utils/memory_view.h"
+#include "shendk/utils/parallel.h"
 
 namespace shendk {
 namespace pvr {
 
+namespace {
+
+// per thread scratch memory for partial results (bands of rows, index grids)
+uint8_t* scratch(uint64_t size) {
+    thread_local std::vector<uint8_t> buffer;
+    if (buffer.size() < size) buffer.resize(size);
+    return buffer.data();
+}
+
+// converts a decoded BGRA row to the destination order
+inline void finishRow(uint8_t* row, uint16_t width, bool bgra) {
+    if (bgra) return;
+    for (uint16_t x = 0; x < width; x++) {
+        uint32_t pixel;
+        memcpy(&pixel, row + x * 4, sizeof(uint32_t));
+        pixel = (pixel & 0xFF00FF00) | ((pixel >> 16) & 0xFF) | ((pixel & 0xFF) << 16);
+        memcpy(row + x * 4, &pixel, sizeof(uint32_t));
+    }
+}
+
+void decodeTwiddled(const uint8_t* src, uint16_t width, uint16_t height, PixelCodec* codec, const PixelView& dst) {
+    uint32_t pixelSize = codec->bpp() >> 3;
+    uint32_t bandRows = detwiddleBandRows(width, height);
+    int64_t bandStride = static_cast<int64_t>(width) * pixelSize;
+    uint8_t* band = scratch(bandStride * bandRows);
+    for (uint32_t y = 0; y < height; y += bandRows) {
+        detwiddleRectangleRows(src, band, bandStride, width, height, y, bandRows, pixelSize);
+        for (uint32_t row = 0; row < bandRows; row++) {
+            codec->decodeRow(band + row * bandStride, dst.row(y + row), width);
+            finishRow(dst.row(y + row), width, dst.bgra);
+        }
+    }
+}
+
+/**
+ * @brief Maps linear BGRA rows to palette indices of bits (4 or 8) each, stored in twiddled squares
+ *        of min(width, height) texels. 8x8 tiles are contiguous there, rows of tiles run in parallel.
+ */
+void encodeIndices(const uint8_t* bgra, uint16_t width, uint16_t height, const PaletteSearch& palette,
+                   uint8_t* dst, uint32_t bits, unsigned threads) {
+    uint32_t size = std::min(width, height);
+    uint32_t squaresWide = width / size;
+    uint64_t squareTexels = static_cast<uint64_t>(size) * size;
+    if (size < twiddleTileSize) {
+        memset(dst, 0, std::max<uint64_t>((static_cast<uint64_t>(width) * height * bits) >> 3, 1));
+        for (uint32_t y = 0; y < height; y++) {
+            for (uint32_t x = 0; x < width; x++) {
+                uint64_t texel = ((y / size) * squaresWide + x / size) * squareTexels + twiddleIndex(x % size, y % size);
+                uint8_t index = palette.index(bgra + (static_cast<uint64_t>(y) * width + x) * 4);
+                if (bits == 8) {
+                    dst[texel] = index;
+                } else {
+                    dst[texel >> 1] |= (index & 0xF) << ((texel & 0x1) * 4);
+                }
+            }
+        }
+        return;
+    }
+
+    const uint32_t tilePixels = twiddleTileSize * twiddleTileSize;
+    const uint32_t squareTiles = size / twiddleTileSize;
+    parallelFor(height / twiddleTileSize, [&](size_t tileY) {
+        uint8_t tile[tilePixels];
+        uint64_t squareRow = (tileY / squareTiles) * squaresWide;
+        for (uint32_t tileX = 0; tileX < width / twiddleTileSize; tileX++) {
+            const uint8_t* rows = bgra + (tileY * twiddleTileSize * width + tileX * twiddleTileSize) * 4;
+            uint32_t previous = 0;
+            uint8_t previousIndex = 0;
+            for (uint32_t i = 0; i < tilePixels; i++) {
+                const uint8_t* texel = rows + ((i / twiddleTileSize) * width + (i % twiddleTileSize)) * 4;
+                uint32_t color;
+                memcpy(&color, texel, sizeof(uint32_t));
+                if (i == 0 || color != previous) {
+                    previous = color;
+                    previousIndex = palette.index(texel);
+                }
+                tile[twiddleTileTable[i]] = previousIndex;
+            }
+
+            uint64_t square = squareRow + tileX / squareTiles;
+            uint64_t offset = square * squareTexels +
+                static_cast<uint64_t>(twiddleIndex(tileX % squareTiles, tileY % squareTiles)) * tilePixels;
+            if (bits == 8) {
+                memcpy(dst + offset, tile, tilePixels);
+            } else {
+                for (uint32_t i = 0; i < tilePixels; i += 2) {
+                    dst[(offset + i) >> 1] = static_cast<uint8_t>((tile[i] & 0xF) | (tile[i + 1] << 4));
+                }
+            }
+        }
+    }, threads);
+}
+
+}
+
+PixelView::PixelView(uint8_t* data, int64_t stride, uint16_t width, uint16_t height, bool bgra)
+    : data(data)
+    , stride(stride)
+    , width(width)
+    , height(height)
+    , bgra(bgra)
+{}
+
+PixelView PixelView::of(Image& image, bool flipVertical) {
+    uint8_t* data = reinterpret_cast<uint8_t*>(image.getDataPtr());
+    int64_t stride = static_cast<int64_t>(image.width()) * sizeof(RGBA);
+    if (flipVertical) {
+        return PixelView(data + (image.height() - 1) * stride, -stride, image.width(), image.height());
+    }
+    return PixelView(data, stride, image.width(), image.height());
+}
+
 DataCodec::~DataCodec() { delete[] m_palette; }
 
-uint16_t DataCodec::paletteEntries(uint16_t) { return 0; }
-bool DataCodec::needsExternalPalette() { return false; }
-bool DataCodec::hasMipmaps() { return false; }
-bool DataCodec::vq() { return false; }
+uint16_t DataCodec::bpp() { return bpp(pixelCodec); }
+uint16_t DataCodec::paletteEntries(uint16_t) const { return 0; }
+bool DataCodec::needsExternalPalette() const { return false; }
+bool DataCodec::hasMipmaps() const { return false; }
+bool DataCodec::vq() const { return false; }
+uint16_t DataCodec::dataBpp() const { return 0; }
+
+uint16_t DataCodec::bpp(PixelCodec* codec) const {
+    uint16_t size = dataBpp();
+    return size ? size : codec->bpp();
+}
+
+uint64_t DataCodec::dataSize(uint16_t width, uint16_t height, PixelCodec* codec) const {
+    return std::max<uint64_t>((static_cast<uint64_t>(width) * height * bpp(codec)) >> 3, 1);
+}
+
+void DataCodec::encodeIndexed(const uint8_t*, uint16_t, uint16_t, const PaletteSearch&, uint8_t*, unsigned) const {
+    throw new std::runtime_error("Data format doesn't store palette indices");
+}
+
+uint8_t* DataCodec::encode(uint8_t* src, uint64_t srcIndex, uint16_t width, uint16_t height) {
+    uint8_t* destination = new uint8_t[dataSize(width, height, pixelCodec)];
+    encodeInto(src + srcIndex, width, height, pixelCodec, destination);
+    return destination;
+}
+
+uint8_t* DataCodec::decode(uint8_t* src, uint64_t srcIndex, uint16_t width, uint16_t height) {
+    uint8_t* destination = new uint8_t[width * height * 4];
+    decodeInto(src + srcIndex, width, height, pixelCodec, m_palette, PixelView(destination, width * 4, width, height, true));
+    return destination;
+}
 
 uint8_t* DataCodec::decode(std::istream& stream, uint16_t width, uint16_t height, PixelCodec* codec) {
     pixelCodec = codec;
-    double d = pixelCodec->bpp() / 8.0;
-    uint64_t dataSize = width * height * d;
-    uint8_t* data = new uint8_t[dataSize];
-    stream.read(reinterpret_cast<char*>(data), dataSize);
-    return decode(data, 0, width, height);
+    uint64_t bufferSize = dataSize(width, height, codec);
+
+    // decode straight from memory backed streams
+    MemoryView memory = getMemoryView(stream);
+    if (memory) {
+        uint64_t position = static_cast<uint64_t>(stream.tellg());
+        MemoryView data = memory.sub(position, bufferSize);
+        if (data.size == bufferSize) {
+            stream.seekg(bufferSize, std::ios::cur);
+            return decode(reinterpret_cast<uint8_t*>(const_cast<char*>(data.data)), 0, width, height);
+        }
+    }
+
+    uint8_t* data = new uint8_t[bufferSize];
+    stream.read(reinterpret_cast<char*>(data), bufferSize);
+    uint8_t* result = decode(data, 0, width, height);
+    delete[] data;
+    return result;
 }
 
 uint8_t* DataCodec::decode(uint8_t* src, uint16_t width, uint16_t height, PixelCodec* codec) {
     pixelCodec = codec;
-    return encode(src, 0, width, height);
+    return decode(src, 0, width, height);
 }
 
 uint8_t* DataCodec::encode(uint8_t* src, uint16_t width, uint16_t height, PixelCodec* codec) {
@@ -35,7 +191,20 @@ uint8_t* DataCodec::encode(uint8_t* src, uint16_t width, uint16_t height, PixelC
 }
 
 void DataCodec::setPalette(std::istream& stream, uint32_t numEntries) {
-    uint64_t bufferSize = bpp() * numEntries;
+    uint64_t bufferSize = (pixelCodec->bpp() >> 3) * numEntries;
+
+    // decode straight from memory backed streams
+    MemoryView memory = getMemoryView(stream);
+    if (memory) {
+        uint64_t position = static_cast<uint64_t>(stream.tellg());
+        MemoryView palette = memory.sub(position, bufferSize);
+        if (palette.size == bufferSize) {
+            stream.seekg(bufferSize, std::ios::cur);
+            setPalette(reinterpret_cast<uint8_t*>(const_cast<char*>(palette.data)), 0, numEntries);
+            return;
+        }
+    }
+
     uint8_t* buffer = new uint8_t[bufferSize];
     stream.read(reinterpret_cast<char*>(buffer), bufferSize);
     setPalette(buffer, 0, numEntries);
@@ -80,106 +249,121 @@ DataCodec* DataCodec::getDataCodec(DataFormat format) {
     }
 }
 
+const DataCodec* DataCodec::get(DataFormat format) {
+    static const SquareTwiddled squareTwiddled;
+    static const SquareTwiddledMipmaps squareTwiddledMipmaps;
+    static const VQ vq;
+    static const VQMipmaps vqMipmaps;
+    static const VQSmall vqSmall;
+    static const VQSmallMipmaps vqSmallMipmaps;
+    static const Index4 index4;
+    static const Index4Mipmap index4Mipmap;
+    static const Index8 index8;
+    static const Index8Mipmap index8Mipmap;
+    static const Rectangle rectangle;
+    static const RectangleTwiddled rectangleTwiddled;
+    switch (format)
+    {
+    case DataFormat::SQUARE_TWIDDLED:
+        return &squareTwiddled;
+    case DataFormat::SQUARE_TWIDDLED_MIPMAP:
+    case DataFormat::SQUARE_TWIDDLED_MIPMAP_ALT:
+        return &squareTwiddledMipmaps;
+    case DataFormat::VECTOR_QUANTIZATION:
+        return &vq;
+    case DataFormat::VECTOR_QUANTIZATION_MIPMAP:
+        return &vqMipmaps;
+    case DataFormat::VECTOR_QUANTIZATION_SMALL:
+        return &vqSmall;
+    case DataFormat::VECTOR_QUANTIZATION_SMALL_MIPMAP:
+        return &vqSmallMipmaps;
+    case DataFormat::PALETTIZE_4BIT:
+        return &index4;
+    case DataFormat::PALETTIZE_4BIT_MIPMAP:
+        return &index4Mipmap;
+    case DataFormat::PALETTIZE_8BIT:
+        return &index8;
+    case DataFormat::PALETTIZE_8BIT_MIPMAP:
+        return &index8Mipmap;
+    case DataFormat::RECTANGLE:
+    case DataFormat::RECTANGLE_STRIDE:
+        return &rectangle;
+    case DataFormat::RECTANGLE_TWIDDLED:
+        return &rectangleTwiddled;
+    default:
+        return nullptr;
+    }
+}
+
 
 // SQUARE_TWIDDLED
-uint16_t SquareTwiddled::bpp() { return pixelCodec->bpp(); }
-
-uint8_t* SquareTwiddled::decode(uint8_t* src, uint64_t srcIndex, uint16_t width, uint16_t height) {
-    uint8_t* destination = new uint8_t[width * height * 4];
-    uint64_t destinationIndex = 0;
-    uint64_t* twiddleMap = createTwiddleMap(width);
-    for (int y = 0; y < height; y++) {
-        for (int x = 0; x < width; x++) {
-            pixelCodec->decodePixel(src, srcIndex + (((twiddleMap[x] << 1) | twiddleMap[y]) << (pixelCodec->bpp() >> 4)), destination, destinationIndex);
-            destinationIndex += 4;
-        }
-    }
-    delete[] twiddleMap;
-    return destination;
+void SquareTwiddled::decodeInto(const uint8_t* src, uint16_t width, uint16_t height, PixelCodec* codec,
+                                const uint8_t*, const PixelView& dst) const {
+    decodeTwiddled(src, width, height, codec, dst);
 }
 
-uint8_t* SquareTwiddled::encode(uint8_t* src, uint64_t srcIndex, uint16_t width, uint16_t height) {
-    uint8_t* destination = new uint8_t[width * height * (pixelCodec->bpp() >> 3)];
-    uint64_t* twiddleMap = createTwiddleMap(width);
-    for (int y = 0; y < height; y++) {
-        for (int x = 0; x < width; x++) {
-            pixelCodec->encodePixel(src, srcIndex, destination, ((twiddleMap[x] << 1) | twiddleMap[y]) << (pixelCodec->bpp() >> 4));
-            srcIndex += 4;
-        }
-    }
-    return destination;
+void SquareTwiddled::encodeInto(const uint8_t* src, uint16_t width, uint16_t height, PixelCodec* codec, uint8_t* dst) const {
+    uint16_t pixelSize = codec->bpp() >> 3;
+    uint8_t* linear = scratch(static_cast<uint64_t>(width) * height * pixelSize);
+    codec->encodeRow(src, linear, static_cast<uint64_t>(width) * height);
+    twiddleRectangle(linear, dst, width, height, pixelSize);
 }
 
 
 // SQUARE_TWIDDLED_MIPMAP
-bool SquareTwiddledMipmaps::hasMipmaps() { return true; }
+bool SquareTwiddledMipmaps::hasMipmaps() const { return true; }
 
 
 // VECTOR_QUANTIZATION
-bool VQ::vq() { return true; }
-uint16_t VQ::bpp() { return 2; }
-uint16_t VQ::paletteEntries(uint16_t) { return 1024; } // 256 * 4 texels
-
-uint8_t* VQ::decode(uint8_t* src, uint64_t srcIndex, uint16_t width, uint16_t height) {
-    uint8_t* destination = new uint8_t[width * height * 4];
-    uint64_t destinationIndex;
+bool VQ::vq() const { return true; }
+uint16_t VQ::dataBpp() const { return 2; }
+uint16_t VQ::paletteEntries(uint16_t) const { return 1024; } // 256 * 4 texels
 
+void VQ::decodeInto(const uint8_t* src, uint16_t width, uint16_t height, PixelCodec*,
+                    const uint8_t* palette, const PixelView& dst) const {
     // 1x1 texture (no twiddle)
     if (width == 1 && height == 1) {
-        int index = src[srcIndex] * 4;
-        destinationIndex = 0;
-        for (int i = 0; i < 4; i++) {
-            destination[destinationIndex] = m_palette[index * 4 + i];
-            destinationIndex++;
-        }
-        return destination;
+        memcpy(dst.row(0), palette + src[0] * 16, 4);
+        finishRow(dst.row(0), 1, dst.bgra);
+        return;
     }
 
-    uint64_t* twiddleMap = createTwiddleMap(width);
-    for (int y = 0; y < height; y += 2) {
-        for (int x = 0; x < width; x += 2) {
-            int index = src[srcIndex + ((twiddleMap[x >> 1] << 1) | twiddleMap[y >> 1])] * 4;
-            for (int x2 = 0; x2 < 2; x2++) {
-                for (int y2 = 0; y2 < 2; y2++) {
-                    destinationIndex = ((((y + y2) * width) + (x + x2)) * 4);
-                    for (int i = 0; i < 4; i++) {
-                        destination[destinationIndex] = m_palette[index * 4 + i];
-                        destinationIndex++;
-                    }
-                    index++;
-                }
-            }
+    // every codebook index covers 2x2 texels, stored in twiddled order
+    uint16_t blocksWide = width >> 1;
+    uint16_t blocksHigh = height >> 1;
+    uint8_t* indices = scratch(blocksWide * blocksHigh);
+    detwiddleRectangle(src, indices, blocksWide, blocksHigh, 1);
+    for (int y = 0; y < blocksHigh; y++) {
+        uint8_t* top = dst.row(y * 2);
+        uint8_t* bottom = dst.row(y * 2 + 1);
+        for (int x = 0; x < blocksWide; x++) {
+            const uint8_t* codeword = palette + indices[y * blocksWide + x] * 16;
+            memcpy(top + x * 8, codeword, 4);            // (0, 0)
+            memcpy(bottom + x * 8, codeword + 4, 4);     // (0, 1)
+            memcpy(top + x * 8 + 4, codeword + 8, 4);    // (1, 0)
+            memcpy(bottom + x * 8 + 4, codeword + 12, 4);
         }
+        finishRow(top, width, dst.bgra);
+        finishRow(bottom, width, dst.bgra);
     }
-    delete[] twiddleMap;
-    return destination;
 }
 
-uint8_t* VQ::encode(uint8_t* src, uint64_t srcIndex, uint16_t width, uint16_t height) {
-    uint16_t compressedWidth = width / 2;
-    uint16_t compressedHeight = height / 2;
-    uint8_t* destination = new uint8_t[compressedWidth * compressedHeight];
-    uint64_t destinationIndex = 0;
-    uint16_t size = std::min(compressedWidth, compressedHeight);
-    uint64_t* twiddleMap = createTwiddleMap(size);
-    for (uint16_t y = 0; y < compressedHeight; y++) {
-        for (uint16_t x = 0; x < compressedWidth; x++) {
-            destinationIndex = (twiddleMap[x] << 1) | twiddleMap[y];
-            destination[destinationIndex] = src[srcIndex];
-            srcIndex++;
-        }
+void VQ::encodeInto(const uint8_t* src, uint16_t width, uint16_t height, PixelCodec*, uint8_t* dst) const {
+    // 1x1 texture (no twiddle)
+    if (width == 1 && height == 1) {
+        dst[0] = src[0];
+        return;
     }
-    delete[] twiddleMap;
-    return destination;
+    twiddleRectangle(src, dst, width >> 1, height >> 1, 1);
 }
 
 
 // VECTOR_QUANTIZATION_MIPMAP
-bool VQMipmaps::hasMipmaps() { return true; }
+bool VQMipmaps::hasMipmaps() const { return true; }
 
 
 // VECTOR_QUANTIZATION_SMALL
-uint16_t VQSmall::paletteEntries(uint16_t width) {
+uint16_t VQSmall::paletteEntries(uint16_t width) const {
     if      (width <= 16) { return 64; }
     else if (width <= 32) { return 256; }
     else if (width <= 64) { return 512; }
@@ -188,185 +372,122 @@ uint16_t VQSmall::paletteEntries(uint16_t width) {
 
 
 // VECTOR_QUANTIZATION_SMALL_MIPMAP
-bool VQSmallMipmaps::hasMipmaps() { return true; }
+bool VQSmallMipmaps::hasMipmaps() const { return true; }
 
 
 // PALETTIZE_4BIT
 bool canEncode() { return true; }
-uint16_t Index4::bpp() { return 4; }
-uint16_t Index4::paletteEntries(uint16_t) { return 16; }
-bool Index4::needsExternalPalette() { return true; }
-
-uint8_t* Index4::decode(uint8_t* src, uint64_t srcIndex, uint16_t width, uint16_t height) {
-    uint8_t* destination = new uint8_t[width * height * 4];
-    uint64_t destinationIndex;
-    uint64_t size = std::min(width, height);
-    uint64_t* twiddleMap = createTwiddleMap(size);
-    for (int y = 0; y < height; y += size) {
-        for (int x = 0; x < width; x += size) {
-            for (uint64_t y2 = 0; y2 < size; y2++) {
-                for (uint64_t x2 = 0; x2 < size; x2++) {
-                    uint8_t index = ((src[srcIndex + (((twiddleMap[x2] << 1) | twiddleMap[y2]) >> 1)] >> ((y2 & 0x1) * 4)) & 0xF);
-                    destinationIndex = ((((y + y2) * width) + (x + x2)) * 4);
-                    for (int i = 0; i < 4; i++) {
-                        destination[destinationIndex] = m_palette[index * 4 + i];
-                        destinationIndex++;
-                    }
-                }
+uint16_t Index4::dataBpp() const { return 4; }
+uint16_t Index4::paletteEntries(uint16_t) const { return 16; }
+bool Index4::needsExternalPalette() const { return true; }
+
+void Index4::decodeInto(const uint8_t* src, uint16_t width, uint16_t height, PixelCodec*,
+                        const uint8_t* palette, const PixelView& dst) const {
+    uint32_t size = std::min(width, height);
+    for (uint32_t y = 0; y < height; y++) {
+        uint8_t* row = dst.row(y);
+        const uint8_t* square = src + (((y / size) * (width / size)) * size * size >> 1);
+        uint32_t y2 = y % size;
+        for (uint32_t x = 0; x < width; x += size, square += (size * size) >> 1) {
+            for (uint32_t x2 = 0; x2 < size; x2++) {
+                uint32_t texel = twiddleIndex(x2, y2);
+                uint8_t index = (square[texel >> 1] >> ((texel & 0x1) * 4)) & 0xF;
+                memcpy(row + (x + x2) * 4, palette + index * 4, 4);
             }
-            srcIndex += (size * size) >> 1;
         }
+        finishRow(row, width, dst.bgra);
     }
-    delete[] twiddleMap;
-    return destination;
 }
 
-uint8_t* Index4::encode(uint8_t* src, uint64_t srcIndex, uint16_t width, uint16_t height) {
-    uint8_t* destination = new uint8_t[(width * height) >> 1];
-    uint64_t destinationIndex = 0;
-    uint64_t size = std::min(width, height);
-    uint64_t* twiddleMap = createTwiddleMap(size);
-    for (int y = 0; y < height; y += size) {
-        for (int x = 0; x < width; x += size) {
-            for (uint64_t y2 = 0; y2 < size; y2++) {
-                for (uint64_t x2 = 0; x2 < size; x2++) {
-                    uint8_t index = destination[destinationIndex + (((twiddleMap[x2] << 1) | twiddleMap[y2]) >> 1)];
-                    index |= (src[srcIndex + (((y + y2) * width) + (x + x2))] & 0xF) << ((y2 & 0x1) * 4);
-                    destination[destinationIndex + (((twiddleMap[x2] << 1) | twiddleMap[y2]) >> 1)] = index;
+void Index4::encodeInto(const uint8_t* src, uint16_t width, uint16_t height, PixelCodec*, uint8_t* dst) const {
+    uint32_t size = std::min(width, height);
+    memset(dst, 0, std::max<uint64_t>((static_cast<uint64_t>(width) * height) >> 1, 1));
+    for (uint32_t y = 0; y < height; y += size) {
+        for (uint32_t x = 0; x < width; x += size) {
+            for (uint32_t y2 = 0; y2 < size; y2++) {
+                const uint8_t* row = src + (y + y2) * width + x;
+                for (uint32_t x2 = 0; x2 < size; x2++) {
+                    uint32_t texel = twiddleIndex(x2, y2);
+                    dst[texel >> 1] |= (row[x2] & 0xF) << ((texel & 0x1) * 4);
                 }
             }
-            destinationIndex += (size * size) >> 1;
+            dst += (size * size) >> 1;
         }
     }
-    delete[] twiddleMap;
-    return destination;
+}
+
+void Index4::encodeIndexed(const uint8_t* bgra, uint16_t width, uint16_t height, const PaletteSearch& palette,
+                           uint8_t* dst, unsigned threads) const {
+    encodeIndices(bgra, width, height, palette, dst, 4, threads);
 }
 
 
 // PALETTIZE_4BIT_MIPMAP
-bool Index4Mipmap::hasMipmaps() { return true; }
+bool Index4Mipmap::hasMipmaps() const { return true; }
 
 
 // PALETTIZE_8BIT
-uint16_t Index8::bpp() { return 8; }
-uint16_t Index8::paletteEntries(uint16_t) { return 256; }
-bool Index8::needsExternalPalette() { return true; }
-
-uint8_t* Index8::decode(uint8_t* src, uint64_t srcIndex, uint16_t width, uint16_t height) {
-    uint8_t* destination = new uint8_t[width * height * 4];
-    uint64_t destinationIndex;
-    uint64_t size = std::min(width, height);
-    uint64_t* twiddleMap = createTwiddleMap(size);
-    for (int y = 0; y < height; y += size) {
-        for (int x = 0; x < width; x += size) {
-            for (uint64_t y2 = 0; y2 < size; y2++) {
-                for (uint64_t x2 = 0; x2 < size; x2++) {
-                    uint8_t index = src[srcIndex + ((twiddleMap[x2] << 1) | twiddleMap[y2])];
-                    destinationIndex = ((((y + y2) * width) + (x + x2)) * 4);
-                    for (int i = 0; i < 4; i++) {
-                        destination[destinationIndex] = m_palette[index * 4 + i];
-                        destinationIndex++;
-                    }
-                }
+uint16_t Index8::dataBpp() const { return 8; }
+uint16_t Index8::paletteEntries(uint16_t) const { return 256; }
+bool Index8::needsExternalPalette() const { return true; }
+
+void Index8::decodeInto(const uint8_t* src, uint16_t width, uint16_t height, PixelCodec*,
+                        const uint8_t* palette, const PixelView& dst) const {
+    uint32_t bandRows = detwiddleBandRows(width, height);
+    uint8_t* band = scratch(width * bandRows);
+    for (uint32_t y = 0; y < height; y += bandRows) {
+        detwiddleRectangleRows(src, band, width, width, height, y, bandRows, 1);
+        for (uint32_t row = 0; row < bandRows; row++) {
+            uint8_t* pixels = dst.row(y + row);
+            const uint8_t* indices = band + row * width;
+            for (uint32_t x = 0; x < width; x++) {
+                memcpy(pixels + x * 4, palette + indices[x] * 4, 4);
             }
-            srcIndex += (size * size);
+            finishRow(pixels, width, dst.bgra);
         }
     }
-    delete[] twiddleMap;
-    return destination;
 }
 
-uint8_t* Index8::encode(uint8_t* src, uint64_t srcIndex, uint16_t width, uint16_t height) {
-    uint8_t* destination = new uint8_t[width * height];
-    uint64_t destinationIndex = 0;
-    uint64_t size = std::min(width, height);
-    uint64_t* twiddleMap = createTwiddleMap(size);
-    for (int x = 0; x < width; x += size) {
-        for (int y = 0; y < height; y += size) {
-            for (uint64_t y2 = 0; y2 < size; y2++) {
-                for (uint64_t x2 = 0; x2 < size; x2++) {
-                    destination[destinationIndex + ((twiddleMap[x2] << 1) | twiddleMap[y2])] = src[srcIndex + (((y + y2) * width) + (x + x2))];
-                }
-            }
-            destinationIndex += (size * size);
-        }
-    }
-    return destination;
+void Index8::encodeInto(const uint8_t* src, uint16_t width, uint16_t height, PixelCodec*, uint8_t* dst) const {
+    twiddleRectangle(src, dst, width, height, 1);
+}
+
+void Index8::encodeIndexed(const uint8_t* bgra, uint16_t width, uint16_t height, const PaletteSearch& palette,
+                           uint8_t* dst, unsigned threads) const {
+    encodeIndices(bgra, width, height, palette, dst, 8, threads);
 }
 
 
 // PALETTIZE_8BIT_MIPMAP
-bool Index8Mipmap::hasMipmaps() { return true; }
+bool Index8Mipmap::hasMipmaps() const { return true; }
 
 
 // RECTANGLE, RECTANGLE_STRIDE, RAW
-uint16_t Rectangle::bpp() { return pixelCodec->bpp(); }
-
-uint8_t* Rectangle::decode(uint8_t* src, uint64_t srcIndex, uint16_t width, uint16_t height) {
-    uint8_t* destination = new uint8_t[width * height * 4];
-    uint64_t destinationIndex = 0;
-    for (int y = 0; y < height; y++) {
-        for (int x = 0; x < width; x++) {
-            pixelCodec->decodePixel(src, srcIndex, destination, destinationIndex);
-            srcIndex += (pixelCodec->bpp() >> 3);
-            destinationIndex += 4;
-        }
+void Rectangle::decodeInto(const uint8_t* src, uint16_t width, uint16_t height, PixelCodec* codec,
+                           const uint8_t*, const PixelView& dst) const {
+    uint64_t stride = static_cast<uint64_t>(width) * (codec->bpp() >> 3);
+    for (uint32_t y = 0; y < height; y++) {
+        codec->decodeRow(src + y * stride, dst.row(y), width);
+        finishRow(dst.row(y), width, dst.bgra);
     }
-    return destination;
 }
 
-uint8_t* Rectangle::encode(uint8_t* src, uint64_t srcIndex, uint16_t width, uint16_t height) {
-    uint8_t* destination = new uint8_t[width * height * (pixelCodec->bpp() >> 3)];
-    uint64_t destinationIndex = 0;
-    for (int y = 0; y < height; y++) {
-        for (int x = 0; x < width; x++) {
-            pixelCodec->encodePixel(src, srcIndex, destination, destinationIndex);
-            srcIndex += 4;
-            destinationIndex += (pixelCodec->bpp() >> 3);
-        }
-    }
-    return destination;
+void Rectangle::encodeInto(const uint8_t* src, uint16_t width, uint16_t height, PixelCodec* codec, uint8_t* dst) const {
+    codec->encodeRow(src, dst, static_cast<uint64_t>(width) * height);
 }
 
 
 // RECTANGLE_TWIDDLED
-uint16_t RectangleTwiddled::bpp() { return pixelCodec->bpp(); }
-
-uint8_t* RectangleTwiddled::decode(uint8_t* src, uint64_t srcIndex, uint16_t width, uint16_t height) {
-    uint8_t* destination = new uint8_t[width * height * 4];
-    uint16_t size = std::min(width, height);
-    uint64_t* twiddleMap = createTwiddleMap(size);
-    for (int y = 0; y < height; y += size) {
-        for (int x = 0; x < width; x += size) {
-            for (int y2 = 0; y2 < size; y2++) {
-                for (int x2 = 0; x2 < size; x2++) {
-                    pixelCodec->decodePixel(src, srcIndex + (((twiddleMap[x2] << 1) | twiddleMap[y2]) << (pixelCodec->bpp() >> 4)), destination, ((((y + y2) * width) + (x + x2)) * 4));
-                }
-            }
-            srcIndex += (size * size) * (pixelCodec->bpp() >> 3);
-        }
-    }
-    delete[] twiddleMap;
-    return destination;
+void RectangleTwiddled::decodeInto(const uint8_t* src, uint16_t width, uint16_t height, PixelCodec* codec,
+                                   const uint8_t*, const PixelView& dst) const {
+    decodeTwiddled(src, width, height, codec, dst);
 }
 
-uint8_t* RectangleTwiddled::encode(uint8_t* src, uint64_t srcIndex, uint16_t width, uint16_t height) {
-    uint8_t*  destination = new uint8_t[width * height * (pixelCodec->bpp() >> 3)];
-    uint64_t destinationIndex = 0;
-    uint16_t size = std::min(width, height);
-    uint64_t* twiddleMap = createTwiddleMap(size);
-    for (int y = 0; y < height; y += size) {
-        for (int x = 0; x < width; x += size) {
-            for (int y2 = 0; y2 < size; y2++) {
-                for (int x2 = 0; x2 < size; x2++) {
-                    pixelCodec->encodePixel(src, srcIndex + ((((y + y2) * width) + (x + x2)) * 4), destination, destinationIndex + (((twiddleMap[x2] << 1) | twiddleMap[y2]) << (pixelCodec->bpp() >> 4)));
-                }
-            }
-            destinationIndex += (size * size) * (pixelCodec->bpp() >> 3);
-        }
-    }
-    delete[] twiddleMap;
-    return destination;
+void RectangleTwiddled::encodeInto(const uint8_t* src, uint16_t width, uint16_t height, PixelCodec* codec, uint8_t* dst) const {
+    uint16_t pixelSize = codec->bpp() >> 3;
+    uint8_t* linear = scratch(static_cast<uint64_t>(width) * height * pixelSize);
+    codec->encodeRow(src, linear, static_cast<uint64_t>(width) * height);
+    twiddleRectangle(linear, dst, width, height, pixelSize);
 }
 
 }
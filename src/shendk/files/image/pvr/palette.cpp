@@ -0,0 +1,261 @@
+#include "shendk/files/image/pvr/palette.h"
+
+#include <cstring>
+#include <algorithm>
+#include <array>
+
+#include "shendk/utils/parallel.h"
+
+namespace shendk {
+namespace pvr {
+
+namespace {
+
+constexpr uint64_t chunkSize = 4096; // colors per parallel work item
+
+// a distinct BGRA color and the number of its texels
+struct Color {
+    uint8_t bgra[4];
+    uint32_t count;
+};
+
+// a range of colors becoming one palette entry
+struct Box {
+    uint64_t begin;
+    uint64_t end;
+    double error; // weighted squared error around the mean
+};
+
+/**
+ * @brief Sorts 32 bit values by 8 bit digits, passes where all values share a digit are skipped.
+ */
+void radixSort(std::vector<uint32_t>& values) {
+    std::vector<uint32_t> buffer(values.size());
+    for (uint32_t shift = 0; shift < 32; shift += 8) {
+        std::array<uint64_t, 257> offsets = {};
+        for (uint32_t value : values) {
+            offsets[((value >> shift) & 0xFF) + 1]++;
+        }
+        if (std::find(offsets.begin(), offsets.end(), values.size()) != offsets.end()) continue;
+        for (uint32_t digit = 0; digit < 256; digit++) {
+            offsets[digit + 1] += offsets[digit];
+        }
+        for (uint32_t value : values) {
+            buffer[offsets[(value >> shift) & 0xFF]++] = value;
+        }
+        values.swap(buffer);
+    }
+}
+
+/**
+ * @brief Distinct colors of the texels, transparent texels are merged to transparent black.
+ */
+std::vector<Color> histogram(const VQBlocks& colors, uint8_t transparentAlpha) {
+    std::vector<uint32_t> values(colors.count());
+    for (uint64_t i = 0; i < values.size(); i++) {
+        const uint8_t* texel = colors.block(i);
+        if (texel[3] > transparentAlpha) {
+            memcpy(&values[i], texel, 4);
+        } else {
+            values[i] = 0;
+        }
+    }
+    radixSort(values);
+
+    std::vector<Color> result;
+    for (uint64_t i = 0; i < values.size();) {
+        uint64_t end = i + 1;
+        while (end < values.size() && values[end] == values[i]) end++;
+        Color color;
+        memcpy(color.bgra, &values[i], 4);
+        color.count = static_cast<uint32_t>(end - i);
+        result.push_back(color);
+        i = end;
+    }
+    return result;
+}
+
+void boxStatistics(const std::vector<Color>& colors, const Box& box, double mean[4], double variance[4], double& weight) {
+    double sums[4] = {}, squares[4] = {};
+    weight = 0.0;
+    for (uint64_t i = box.begin; i < box.end; i++) {
+        for (int c = 0; c < 4; c++) {
+            double value = colors[i].bgra[c];
+            sums[c] += value * colors[i].count;
+            squares[c] += value * value * colors[i].count;
+        }
+        weight += colors[i].count;
+    }
+    for (int c = 0; c < 4; c++) {
+        mean[c] = sums[c] / weight;
+        variance[c] = squares[c] - sums[c] * mean[c];
+    }
+}
+
+Box createBox(const std::vector<Color>& colors, uint64_t begin, uint64_t end) {
+    Box box = { begin, end, 0.0 };
+    double mean[4], variance[4], weight;
+    boxStatistics(colors, box, mean, variance, weight);
+    box.error = end - begin > 1 ? variance[0] + variance[1] + variance[2] + variance[3] : 0.0;
+    return box;
+}
+
+/**
+ * @brief Median cut: the box with the largest error is split at the weighted median of its
+ *        widest channel until there are size boxes.
+ */
+std::vector<float> medianCut(std::vector<Color>& colors, uint32_t size) {
+    std::vector<Box> boxes = { createBox(colors, 0, colors.size()) };
+    while (boxes.size() < size) {
+        auto largest = std::max_element(boxes.begin(), boxes.end(), [](const Box& a, const Box& b) {
+            return a.error < b.error;
+        });
+        if (largest->error <= 0.0) break;
+        Box box = *largest;
+
+        double mean[4], variance[4], weight;
+        boxStatistics(colors, box, mean, variance, weight);
+        int channel = static_cast<int>(std::max_element(variance, variance + 4) - variance);
+        std::sort(colors.begin() + box.begin, colors.begin() + box.end, [channel](const Color& a, const Color& b) {
+            return a.bgra[channel] < b.bgra[channel];
+        });
+        uint64_t split = box.begin + 1;
+        double below = colors[box.begin].count;
+        while (split + 1 < box.end && below + colors[split].count <= weight / 2) {
+            below += colors[split++].count;
+        }
+
+        *largest = createBox(colors, box.begin, split);
+        boxes.push_back(createBox(colors, split, box.end));
+    }
+
+    std::vector<float> palette(boxes.size() * 4);
+    for (size_t i = 0; i < boxes.size(); i++) {
+        double mean[4], variance[4], weight;
+        boxStatistics(colors, boxes[i], mean, variance, weight);
+        for (int c = 0; c < 4; c++) {
+            palette[i * 4 + c] = static_cast<float>(mean[c]);
+        }
+    }
+    return palette;
+}
+
+/**
+ * @brief Weighted k-means on the distinct colors, starting from the median cut palette.
+ */
+void refine(const std::vector<Color>& colors, std::vector<float>& palette, const PaletteOptions& options) {
+    uint32_t entries = static_cast<uint32_t>(palette.size() / 4);
+    uint64_t chunks = (colors.size() + chunkSize - 1) / chunkSize;
+    std::vector<double> sums(chunks * entries * 5);
+    std::vector<uint64_t> chunkChanges(chunks);
+    std::vector<uint32_t> assignments(colors.size(), entries);
+    for (uint32_t iteration = 0; iteration < options.iterations; iteration++) {
+        CodeBookSearch search(palette.data(), entries, 4);
+        parallelFor(chunks, [&](size_t chunk) {
+            double* chunkSums = sums.data() + chunk * entries * 5; // weighted channels and weight
+            std::fill(chunkSums, chunkSums + entries * 5, 0.0);
+            uint64_t changes = 0;
+            uint64_t end = std::min<uint64_t>(colors.size(), (chunk + 1) * chunkSize);
+            for (uint64_t i = chunk * chunkSize; i < end; i++) {
+                const Color& color = colors[i];
+                float point[4];
+                std::copy(color.bgra, color.bgra + 4, point);
+                float error;
+                uint32_t entry = search.nearest(point, error);
+                changes += entry != assignments[i];
+                assignments[i] = entry;
+                double* sum = chunkSums + entry * 5;
+                for (int c = 0; c < 4; c++) {
+                    sum[c] += point[c] * static_cast<double>(color.count);
+                }
+                sum[4] += color.count;
+            }
+            chunkChanges[chunk] = changes;
+        }, options.threads);
+
+        uint64_t changes = 0;
+        for (uint64_t chunk = 0; chunk < chunks; chunk++) {
+            changes += chunkChanges[chunk];
+        }
+        if (changes == 0) break;
+
+        // empty entries keep their color
+        for (uint32_t entry = 0; entry < entries; entry++) {
+            double sum[5] = {};
+            for (uint64_t chunk = 0; chunk < chunks; chunk++) {
+                for (int c = 0; c < 5; c++) {
+                    sum[c] += sums[(chunk * entries + entry) * 5 + c];
+                }
+            }
+            if (sum[4] == 0.0) continue;
+            for (int c = 0; c < 4; c++) {
+                palette[entry * 4 + c] = static_cast<float>(sum[c] / sum[4]);
+            }
+        }
+    }
+}
+
+}
+
+std::vector<uint8_t> createPalette(const VQBlocks& colors, uint32_t size, const PaletteOptions& options) {
+    std::vector<uint8_t> result(static_cast<uint64_t>(size) * 4);
+    if (colors.count() == 0 || size == 0) {
+        return result;
+    }
+    std::vector<Color> distinct = histogram(colors, options.transparentAlpha);
+
+    // few enough colors are kept as they are
+    if (distinct.size() <= size) {
+        for (size_t i = 0; i < distinct.size(); i++) {
+            memcpy(result.data() + i * 4, distinct[i].bgra, 4);
+        }
+        return result;
+    }
+
+    // transparent texels get an entry of their own, the other entries cover the visible colors
+    auto transparent = std::find_if(distinct.begin(), distinct.end(), [](const Color& color) {
+        return color.bgra[3] == 0 && color.bgra[0] == 0 && color.bgra[1] == 0 && color.bgra[2] == 0;
+    });
+    bool hasTransparent = transparent != distinct.end();
+    if (hasTransparent) {
+        distinct.erase(transparent);
+    }
+    uint32_t visibleEntries = hasTransparent ? size - 1 : size;
+    if (visibleEntries == 0) {
+        return result;
+    }
+    std::vector<float> palette = medianCut(distinct, visibleEntries);
+    refine(distinct, palette, options);
+
+    for (size_t i = 0; i < palette.size(); i++) {
+        result[i] = static_cast<uint8_t>(std::clamp(palette[i] + 0.5f, 0.0f, 255.0f));
+    }
+    // result's remaining entries are transparent black already, the reserved one included
+    return result;
+}
+
+PaletteSearch::PaletteSearch(const std::vector<uint8_t>& bgraPalette, uint8_t transparentAlpha)
+    : m_search(bgraPalette, 4)
+    , m_transparentAlpha(transparentAlpha)
+{
+    uint32_t entries = static_cast<uint32_t>(bgraPalette.size() / 4);
+    for (uint32_t i = 0; i < entries; i++) {
+        uint8_t alpha = bgraPalette[i * 4 + 3];
+        if (alpha <= transparentAlpha && (m_transparentIndex < 0 || alpha < bgraPalette[m_transparentIndex * 4 + 3])) {
+            m_transparentIndex = static_cast<int32_t>(i);
+        }
+    }
+}
+
+uint8_t PaletteSearch::index(const uint8_t* bgra) const {
+    if (bgra[3] <= m_transparentAlpha && m_transparentIndex >= 0) {
+        return static_cast<uint8_t>(m_transparentIndex);
+    }
+    float texel[4];
+    std::copy(bgra, bgra + 4, texel);
+    float error;
+    return static_cast<uint8_t>(m_search.nearest(texel, error));
+}
+
+}
+}
@@ -3,33 +3,226 @@
 #include <cstring>
 #include <algorithm>
 #include <cmath>
+#include <vector>
 
 #include "shendk/utils/math.h"
 
+#if defined(__AVX2__)
+    #include <immintrin.h>
+    #define SHENDK_PIXEL_SSE2
+#elif defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+    #include <emmintrin.h>
+    #define SHENDK_PIXEL_SSE2
+#endif
+
 namespace shendk {
 namespace pvr {
 
+namespace {
+
+/**
+ * @brief Expands a channel of Bits bits to 8 bits as floor(v * 255 / max),
+ *        computed as mulhi(v * 255, multiplier) >> shift for the SIMD kernels.
+ */
+template<uint32_t Bits> struct Expand;
+template<> struct Expand<1> { static constexpr uint16_t multiplier = 0;     static constexpr int shift = 0; };
+template<> struct Expand<4> { static constexpr uint16_t multiplier = 4370;  static constexpr int shift = 0; };
+template<> struct Expand<5> { static constexpr uint16_t multiplier = 8457;  static constexpr int shift = 2; };
+template<> struct Expand<6> { static constexpr uint16_t multiplier = 16645; static constexpr int shift = 4; };
+
+/**
+ * @brief 16-bit pixel layout with the channels packed A R G B from the high to the low bits.
+ *        Formats without alpha (ABits = 0) decode to opaque pixels.
+ */
+template<uint32_t ABits, uint32_t RBits, uint32_t GBits, uint32_t BBits>
+struct Packed16 {
+    static constexpr uint32_t bShift = 0;
+    static constexpr uint32_t gShift = BBits;
+    static constexpr uint32_t rShift = BBits + GBits;
+    static constexpr uint32_t aShift = BBits + GBits + RBits;
+
+    template<uint32_t Bits>
+    static inline uint8_t expand(uint32_t value) {
+        return static_cast<uint8_t>(value * 0xFF / ((1 << Bits) - 1));
+    }
+
+    static inline void decode(uint16_t pixel, uint8_t* dst) {
+        dst[0] = expand<BBits>((pixel >> bShift) & ((1 << BBits) - 1));
+        dst[1] = expand<GBits>((pixel >> gShift) & ((1 << GBits) - 1));
+        dst[2] = expand<RBits>((pixel >> rShift) & ((1 << RBits) - 1));
+        if constexpr (ABits > 0) {
+            dst[3] = expand<ABits>((pixel >> aShift) & ((1 << ABits) - 1));
+        } else {
+            dst[3] = 0xFF;
+        }
+    }
+
+    static inline uint16_t encode(const uint8_t* src) {
+        uint32_t pixel = 0;
+        pixel |= static_cast<uint32_t>(src[0] >> (8 - BBits)) << bShift;
+        pixel |= static_cast<uint32_t>(src[1] >> (8 - GBits)) << gShift;
+        pixel |= static_cast<uint32_t>(src[2] >> (8 - RBits)) << rShift;
+        if constexpr (ABits > 0) {
+            pixel |= static_cast<uint32_t>(src[3] >> (8 - ABits)) << aShift;
+        }
+        return static_cast<uint16_t>(pixel);
+    }
+
+#if defined(__AVX2__)
+    template<uint32_t Bits, uint32_t Shift>
+    static inline __m256i expandChannel(__m256i pixels) {
+        __m256i value = _mm256_and_si256(_mm256_srli_epi16(pixels, Shift), _mm256_set1_epi16((1 << Bits) - 1));
+        value = _mm256_mullo_epi16(value, _mm256_set1_epi16(0xFF));
+        if constexpr (Bits == 1) return value;
+        return _mm256_srli_epi16(_mm256_mulhi_epu16(value, _mm256_set1_epi16(static_cast<short>(Expand<Bits>::multiplier))), Expand<Bits>::shift);
+    }
+
+    template<uint32_t Bits, uint32_t Offset, uint32_t Shift>
+    static inline __m256i packChannel(__m256i pixels) {
+        __m256i value = _mm256_and_si256(_mm256_srli_epi32(pixels, Offset + 8 - Bits), _mm256_set1_epi32((1 << Bits) - 1));
+        return _mm256_slli_epi32(value, Shift);
+    }
+
+    // 16 pixels per iteration
+    static uint64_t decodeBlocks(const uint8_t* src, uint8_t* dst, uint64_t count) {
+        uint64_t i = 0;
+        for (; i + 16 <= count; i += 16) {
+            __m256i pixels = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(src + i * 2));
+            __m256i b = expandChannel<BBits, bShift>(pixels);
+            __m256i g = expandChannel<GBits, gShift>(pixels);
+            __m256i r = expandChannel<RBits, rShift>(pixels);
+            __m256i a = _mm256_set1_epi16(0xFF);
+            if constexpr (ABits > 0) a = expandChannel<ABits, aShift>(pixels);
+            __m256i bg = _mm256_or_si256(b, _mm256_slli_epi16(g, 8));
+            __m256i ra = _mm256_or_si256(r, _mm256_slli_epi16(a, 8));
+            __m256i low = _mm256_unpacklo_epi16(bg, ra);  // pixels 0-3, 8-11
+            __m256i high = _mm256_unpackhi_epi16(bg, ra); // pixels 4-7, 12-15
+            _mm256_storeu_si256(reinterpret_cast<__m256i*>(dst + i * 4), _mm256_permute2x128_si256(low, high, 0x20));
+            _mm256_storeu_si256(reinterpret_cast<__m256i*>(dst + i * 4 + 32), _mm256_permute2x128_si256(low, high, 0x31));
+        }
+        return i;
+    }
+
+    static inline __m256i encodeVector(__m256i pixels) {
+        __m256i value = _mm256_or_si256(packChannel<BBits, 0, bShift>(pixels), packChannel<GBits, 8, gShift>(pixels));
+        value = _mm256_or_si256(value, packChannel<RBits, 16, rShift>(pixels));
+        if constexpr (ABits > 0) value = _mm256_or_si256(value, packChannel<ABits, 24, aShift>(pixels));
+        return _mm256_srai_epi32(_mm256_slli_epi32(value, 16), 16); // sign extend for packs
+    }
+
+    static uint64_t encodeBlocks(const uint8_t* src, uint8_t* dst, uint64_t count) {
+        uint64_t i = 0;
+        for (; i + 16 <= count; i += 16) {
+            __m256i first = encodeVector(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(src + i * 4)));
+            __m256i second = encodeVector(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(src + i * 4 + 32)));
+            __m256i packed = _mm256_permute4x64_epi64(_mm256_packs_epi32(first, second), 0xD8);
+            _mm256_storeu_si256(reinterpret_cast<__m256i*>(dst + i * 2), packed);
+        }
+        return i;
+    }
+#elif defined(SHENDK_PIXEL_SSE2)
+    template<uint32_t Bits, uint32_t Shift>
+    static inline __m128i expandChannel(__m128i pixels) {
+        __m128i value = _mm_and_si128(_mm_srli_epi16(pixels, Shift), _mm_set1_epi16((1 << Bits) - 1));
+        value = _mm_mullo_epi16(value, _mm_set1_epi16(0xFF));
+        if constexpr (Bits == 1) return value;
+        return _mm_srli_epi16(_mm_mulhi_epu16(value, _mm_set1_epi16(static_cast<short>(Expand<Bits>::multiplier))), Expand<Bits>::shift);
+    }
+
+    template<uint32_t Bits, uint32_t Offset, uint32_t Shift>
+    static inline __m128i packChannel(__m128i pixels) {
+        __m128i value = _mm_and_si128(_mm_srli_epi32(pixels, Offset + 8 - Bits), _mm_set1_epi32((1 << Bits) - 1));
+        return _mm_slli_epi32(value, Shift);
+    }
+
+    // 8 pixels per iteration
+    static uint64_t decodeBlocks(const uint8_t* src, uint8_t* dst, uint64_t count) {
+        uint64_t i = 0;
+        for (; i + 8 <= count; i += 8) {
+            __m128i pixels = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + i * 2));
+            __m128i b = expandChannel<BBits, bShift>(pixels);
+            __m128i g = expandChannel<GBits, gShift>(pixels);
+            __m128i r = expandChannel<RBits, rShift>(pixels);
+            __m128i a = _mm_set1_epi16(0xFF);
+            if constexpr (ABits > 0) a = expandChannel<ABits, aShift>(pixels);
+            __m128i bg = _mm_or_si128(b, _mm_slli_epi16(g, 8));
+            __m128i ra = _mm_or_si128(r, _mm_slli_epi16(a, 8));
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + i * 4), _mm_unpacklo_epi16(bg, ra));
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + i * 4 + 16), _mm_unpackhi_epi16(bg, ra));
+        }
+        return i;
+    }
+
+    static inline __m128i encodeVector(__m128i pixels) {
+        __m128i value = _mm_or_si128(packChannel<BBits, 0, bShift>(pixels), packChannel<GBits, 8, gShift>(pixels));
+        value = _mm_or_si128(value, packChannel<RBits, 16, rShift>(pixels));
+        if constexpr (ABits > 0) value = _mm_or_si128(value, packChannel<ABits, 24, aShift>(pixels));
+        return _mm_srai_epi32(_mm_slli_epi32(value, 16), 16); // sign extend for packs
+    }
+
+    static uint64_t encodeBlocks(const uint8_t* src, uint8_t* dst, uint64_t count) {
+        uint64_t i = 0;
+        for (; i + 8 <= count; i += 8) {
+            __m128i first = encodeVector(_mm_loadu_si128(reinterpret_cast<const __m128i*>(src + i * 4)));
+            __m128i second = encodeVector(_mm_loadu_si128(reinterpret_cast<const __m128i*>(src + i * 4 + 16)));
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + i * 2), _mm_packs_epi32(first, second));
+        }
+        return i;
+    }
+#else
+    static uint64_t decodeBlocks(const uint8_t*, uint8_t*, uint64_t) { return 0; }
+    static uint64_t encodeBlocks(const uint8_t*, uint8_t*, uint64_t) { return 0; }
+#endif
+
+    static void decodeRow(const uint8_t* src, uint8_t* dst, uint64_t count) {
+        for (uint64_t i = decodeBlocks(src, dst, count); i < count; i++) {
+            uint16_t pixel;
+            memcpy(&pixel, src + i * 2, sizeof(uint16_t));
+            decode(pixel, dst + i * 4);
+        }
+    }
+
+    static void encodeRow(const uint8_t* src, uint8_t* dst, uint64_t count) {
+        for (uint64_t i = encodeBlocks(src, dst, count); i < count; i++) {
+            uint16_t pixel = encode(src + i * 4);
+            memcpy(dst + i * 2, &pixel, sizeof(uint16_t));
+        }
+    }
+};
+
+using ARGB1555Layout = Packed16<1, 5, 5, 5>;
+using RGB565Layout = Packed16<0, 5, 6, 5>;
+using ARGB4444Layout = Packed16<4, 4, 4, 4>;
+using RGB555Layout = Packed16<0, 5, 5, 5>;
+
+}
+
 PixelCodec::~PixelCodec() {}
 
+void PixelCodec::decodeRow(const uint8_t* src, uint8_t* dst, uint64_t count) {
+    uint64_t pixelSize = bpp() >> 3;
+    for (uint64_t i = 0; i < count; i++) {
+        decodePixel(const_cast<uint8_t*>(src), i * pixelSize, dst, i * 4);
+    }
+}
+
+void PixelCodec::encodeRow(const uint8_t* src, uint8_t* dst, uint64_t count) {
+    uint64_t pixelSize = bpp() >> 3;
+    for (uint64_t i = 0; i < count; i++) {
+        encodePixel(const_cast<uint8_t*>(src), i * 4, dst, i * pixelSize);
+    }
+}
+
 uint8_t* PixelCodec::decodePalette(uint8_t* src, uint64_t srcIndex, uint32_t numEntries) {
 
     uint8_t* palette = new uint8_t[numEntries * 4];
-    uint32_t _bpp = bpp();
-    for (uint32_t i = 0; i < numEntries; i++) {
-        decodePixel(src, srcIndex + (i * (_bpp >> 3)), palette + (i * 4), 0);
-    }
+    decodeRow(src + srcIndex, palette, numEntries);
     return palette;
 }
 
 uint8_t* PixelCodec::encodePalette(uint8_t* palette, uint32_t numEntries) {
-    uint32_t _bpp = bpp();
-    uint8_t* destination = new uint8_t[numEntries * (_bpp >> 3)];
-    uint64_t destinationIndex = 0;
-    for (uint32_t i = 0; i < numEntries; i++)
-    {
-        encodePixel(palette + i * 4, 0, destination, destinationIndex);
-        destinationIndex += (_bpp >> 3);
-    }
+    uint8_t* destination = new uint8_t[numEntries * (bpp() >> 3)];
+    encodeRow(palette, destination, numEntries);
     return destination;
 }
 
@@ -55,26 +248,56 @@ PixelCodec* PixelCodec::getPixelCodec(PixelFormat format) {
     }
 }
 
+PixelCodec* PixelCodec::get(PixelFormat format) {
+    static ARGB1555 argb1555;
+    static RGB565 rgb565;
+    static ARGB4444 argb4444;
+    static YUV422 yuv422;
+    static BUMP88 bump88;
+    static RGB555 rgb555;
+    static ARGB8888 argb8888;
+    switch (format)
+    {
+    case PixelFormat::ARGB1555:
+        return &argb1555;
+    case PixelFormat::RGB565:
+        return &rgb565;
+    case PixelFormat::ARGB4444:
+        return &argb4444;
+    case PixelFormat::YUV422:
+        return &yuv422;
+    case PixelFormat::BUMP88:
+        return &bump88;
+    case PixelFormat::RGB555:
+        return &rgb555;
+    case PixelFormat::ARGB8888:
+        return &argb8888;
+    default:
+        return nullptr;
+    }
+}
+
 
 // ARGB1555
 uint16_t ARGB1555::bpp() { return 16; }
 
 void ARGB1555::decodePixel(uint8_t* src, uint64_t srcIndex, uint8_t* dst, uint64_t dstIndex) {
-    uint16_t pixel = *reinterpret_cast<uint16_t*>(src + srcIndex);
-    dst[dstIndex + 3] = static_cast<uint8_t>(((pixel >> 15) & 0x01) * 0xFF);
-    dst[dstIndex + 2] = static_cast<uint8_t>(((pixel >> 10) & 0x1F) * 0xFF / 0x1F);
-    dst[dstIndex + 1] = static_cast<uint8_t>(((pixel >> 5) & 0x1F) * 0xFF / 0x1F);
-    dst[dstIndex + 0] = static_cast<uint8_t>(((pixel >> 0) & 0x1F) * 0xFF / 0x1F);
+    uint16_t pixel;
+    memcpy(&pixel, src + srcIndex, sizeof(uint16_t));
+    ARGB1555Layout::decode(pixel, dst + dstIndex);
 }
 
 void ARGB1555::encodePixel(uint8_t* src, uint64_t srcIndex, uint8_t* dst, uint64_t dstIndex) {
-    uint16_t pixel = 0x0000;
-    pixel |= static_cast<uint16_t>((src[srcIndex + 3] >> 7) << 15);
-    pixel |= static_cast<uint16_t>((src[srcIndex + 2] >> 3) << 10);
-    pixel |= static_cast<uint16_t>((src[srcIndex + 1] >> 3) << 5);
-    pixel |= static_cast<uint16_t>((src[srcIndex + 0] >> 3) << 0);
-    dst[dstIndex + 1] = static_cast<uint8_t>((pixel >> 8) & 0xFF);
-    dst[dstIndex + 0] = static_cast<uint8_t>(pixel & 0xFF);
+    uint16_t pixel = ARGB1555Layout::encode(src + srcIndex);
+    memcpy(dst + dstIndex, &pixel, sizeof(uint16_t));
+}
+
+void ARGB1555::decodeRow(const uint8_t* src, uint8_t* dst, uint64_t count) {
+    ARGB1555Layout::decodeRow(src, dst, count);
+}
+
+void ARGB1555::encodeRow(const uint8_t* src, uint8_t* dst, uint64_t count) {
+    ARGB1555Layout::encodeRow(src, dst, count);
 }
 
 
@@ -82,20 +305,22 @@ void ARGB1555::encodePixel(uint8_t* src, uint64_t srcIndex, uint8_t* dst, uint64
 uint16_t RGB565::bpp() { return 16; }
 
 void RGB565::decodePixel(uint8_t* src, uint64_t srcIndex, uint8_t* dst, uint64_t dstIndex) {
-    uint16_t pixel = *reinterpret_cast<uint16_t*>(src + srcIndex);
-    dst[dstIndex + 3] = 0xFF;
-    dst[dstIndex + 2] = static_cast<uint8_t>(((pixel >> 11) & 0x1F) * 0xFF / 0x1F);
-    dst[dstIndex + 1] = static_cast<uint8_t>(((pixel >> 5)  & 0x3F) * 0xFF / 0x3F);
-    dst[dstIndex + 0] = static_cast<uint8_t>(((pixel >> 0)  & 0x1F) * 0xFF / 0x1F);
+    uint16_t pixel;
+    memcpy(&pixel, src + srcIndex, sizeof(uint16_t));
+    RGB565Layout::decode(pixel, dst + dstIndex);
 }
 
 void RGB565::encodePixel(uint8_t* src, uint64_t srcIndex, uint8_t* dst, uint64_t dstIndex) {
-    uint16_t pixel = 0x0000;
-    pixel |= static_cast<uint16_t>((src[srcIndex + 2] >> 3) << 11);
-    pixel |= static_cast<uint16_t>((src[srcIndex + 1] >> 2) << 5);
-    pixel |= static_cast<uint16_t>((src[srcIndex + 0] >> 3) << 0);
-    dst[dstIndex + 1] = static_cast<uint8_t>((pixel >> 8) & 0xFF);
-    dst[dstIndex + 0] = static_cast<uint8_t>(pixel & 0xFF);
+    uint16_t pixel = RGB565Layout::encode(src + srcIndex);
+    memcpy(dst + dstIndex, &pixel, sizeof(uint16_t));
+}
+
+void RGB565::decodeRow(const uint8_t* src, uint8_t* dst, uint64_t count) {
+    RGB565Layout::decodeRow(src, dst, count);
+}
+
+void RGB565::encodeRow(const uint8_t* src, uint8_t* dst, uint64_t count) {
+    RGB565Layout::encodeRow(src, dst, count);
 }
 
 
@@ -103,134 +328,316 @@ void RGB565::encodePixel(uint8_t* src, uint64_t srcIndex, uint8_t* dst, uint64_t
 uint16_t ARGB4444::bpp() { return 16; }
 
 void ARGB4444::decodePixel(uint8_t* src, uint64_t srcIndex, uint8_t* dst, uint64_t dstIndex) {
-    uint16_t pixel = *reinterpret_cast<uint16_t*>(src + srcIndex);
-    dst[dstIndex + 3] = static_cast<uint8_t>(((pixel >> 12) & 0x0F) * 0xFF / 0x0F);
-    dst[dstIndex + 2] = static_cast<uint8_t>(((pixel >> 8)  & 0x0F) * 0xFF / 0x0F);
-    dst[dstIndex + 1] = static_cast<uint8_t>(((pixel >> 4)  & 0x0F) * 0xFF / 0x0F);
-    dst[dstIndex + 0] = static_cast<uint8_t>(((pixel >> 0)  & 0x0F) * 0xFF / 0x0F);
+    uint16_t pixel;
+    memcpy(&pixel, src + srcIndex, sizeof(uint16_t));
+    ARGB4444Layout::decode(pixel, dst + dstIndex);
 }
 
 void ARGB4444::encodePixel(uint8_t* src, uint64_t srcIndex, uint8_t* dst, uint64_t dstIndex) {
-    uint16_t pixel = 0x0000;
-    pixel |= static_cast<uint16_t>((src[srcIndex + 3] >> 4) << 12);
-    pixel |= static_cast<uint16_t>((src[srcIndex + 2] >> 4) << 8);
-    pixel |= static_cast<uint16_t>((src[srcIndex + 1] >> 4) << 4);
-    pixel |= static_cast<uint16_t>((src[srcIndex + 0] >> 4) << 0);
-    dst[dstIndex + 1] = static_cast<uint8_t>((pixel >> 8) & 0xFF);
-    dst[dstIndex + 0] = static_cast<uint8_t>(pixel & 0xFF);
+    uint16_t pixel = ARGB4444Layout::encode(src + srcIndex);
+    memcpy(dst + dstIndex, &pixel, sizeof(uint16_t));
+}
+
+void ARGB4444::decodeRow(const uint8_t* src, uint8_t* dst, uint64_t count) {
+    ARGB4444Layout::decodeRow(src, dst, count);
+}
+
+void ARGB4444::encodeRow(const uint8_t* src, uint8_t* dst, uint64_t count) {
+    ARGB4444Layout::encodeRow(src, dst, count);
 }
 
 
 // YUV422
-uint16_t YUV422::bpp() { return 32; } // using 32 Bpp because YUV requires two pixels to decode one pixel
+namespace {
 
-void YUV422::decodePixel(uint8_t* src, uint64_t srcIndex, uint8_t* dst, uint64_t dstIndex) {
-    uint16_t pixel1 = *reinterpret_cast<uint16_t*>(src + srcIndex);
-    uint16_t pixel2 = *reinterpret_cast<uint16_t*>(src + srcIndex + 2);
+inline uint8_t clampByte(int value) {
+    return static_cast<uint8_t>(value < 0 ? 0 : (value > 0xFF ? 0xFF : value));
+}
 
-    int Y0 = (pixel1 & 0xFF00) >> 8, U = (pixel1 & 0x00FF);
-    int Y1 = (pixel2 & 0xFF00) >> 8, V = (pixel2 & 0x00FF);
+/**
+ * R = Y + 1.375 V, G = Y - 0.6875 V - 0.34375 U, B = Y + 1.71875 U
+ * with U and V centered on 128. The coefficients are exact in 1/32 steps.
+ */
+inline void decodeYUV(int y, int u, int v, uint8_t* dst) {
+    dst[0] = clampByte(y + ((55 * u + 16) >> 5));
+    dst[1] = clampByte(y + ((-22 * v - 11 * u + 16) >> 5));
+    dst[2] = clampByte(y + ((44 * v + 16) >> 5));
+    dst[3] = 0xFF;
+}
 
-    uint8_t r1 = std::clamp<uint8_t>(static_cast<uint8_t>(Y0 + 1.375 * (V - 128.0)), 0, 255);
-    uint8_t g1 = std::clamp<uint8_t>(static_cast<uint8_t>(Y0 - 0.6875 * (V - 128.0) - 0.34375 * (U - 128)), 0, 255);
-    uint8_t b1 = std::clamp<uint8_t>(static_cast<uint8_t>(Y0 + 1.71875 * (U - 128)), 0, 255);
+inline void decodeYUVPair(const uint8_t* src, uint8_t* dst) {
+    int u = src[0] - 128, v = src[2] - 128;
+    decodeYUV(src[1], u, v, dst);
+    decodeYUV(src[3], u, v, dst + 4);
+}
 
-    uint8_t r2 = std::clamp<uint8_t>(static_cast<uint8_t>(Y1 + 1.375 * (V - 128)), 0, 255);
-    uint8_t g2 = std::clamp<uint8_t>(static_cast<uint8_t>(Y1 - 0.6875 * (V - 128) - 0.34375 * (U - 128)), 0, 255);
-    uint8_t b2 = std::clamp<uint8_t>(static_cast<uint8_t>(Y1 + 1.71875 * (U - 128)), 0, 255);
+// inverse of decodeYUV: Y = 0.294 R + 0.588 G + 0.118 B, U = 0.582 (B - Y), V = 0.727 (R - Y)
+inline int lumaYUV(int r, int g, int b) {
+    return (75 * r + 151 * g + 30 * b + 128) >> 8;
+}
 
-    dst[dstIndex + 3] = 0xFF;
-    dst[dstIndex + 2] = r1;
-    dst[dstIndex + 1] = g1;
-    dst[dstIndex + 0] = b1;
+inline void encodeYUVPair(const uint8_t* src, uint8_t* dst) {
+    int b = (src[0] + src[4] + 1) >> 1;
+    int g = (src[1] + src[5] + 1) >> 1;
+    int r = (src[2] + src[6] + 1) >> 1;
+    int y = lumaYUV(r, g, b);
+    dst[0] = clampByte(128 + ((149 * (b - y) + 128) >> 8));
+    dst[1] = static_cast<uint8_t>(lumaYUV(src[2], src[1], src[0]));
+    dst[2] = clampByte(128 + ((186 * (r - y) + 128) >> 8));
+    dst[3] = static_cast<uint8_t>(lumaYUV(src[6], src[5], src[4]));
+}
 
-    dst[dstIndex + 4 + 3] = 0xFF;
-    dst[dstIndex + 4 + 2] = r2;
-    dst[dstIndex + 4 + 1] = g2;
-    dst[dstIndex + 4 + 0] = b2;
+#if defined(SHENDK_PIXEL_SSE2)
+inline __m128i packYUVChannel(__m128i y, __m128i chroma) {
+    return _mm_packus_epi16(_mm_add_epi16(y, _mm_srai_epi16(_mm_add_epi16(chroma, _mm_set1_epi16(16)), 5)), _mm_setzero_si128());
 }
 
-void YUV422::encodePixel(uint8_t* src, uint64_t srcIndex, uint8_t* dst, uint64_t dstIndex) {
-    uint8_t r1 = src[srcIndex + 2];
-    uint8_t g1 = src[srcIndex + 1];
-    uint8_t b1 = src[srcIndex];
+// 4 pixel pairs per iteration, returns the number of pairs decoded
+uint64_t decodeYUVBlocks(const uint8_t* src, uint8_t* dst, uint64_t pairs) {
+    uint64_t i = 0;
+    const __m128i bias = _mm_set1_epi16(128);
+    for (; i + 4 <= pairs; i += 4) {
+        __m128i data = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + i * 4));
+        __m128i y = _mm_srli_epi16(data, 8);                                    // Y0 Y1 per pixel
+        __m128i chroma = _mm_sub_epi16(_mm_and_si128(data, _mm_set1_epi16(0xFF)), bias); // U V per pixel
+        __m128i u = _mm_shufflehi_epi16(_mm_shufflelo_epi16(chroma, _MM_SHUFFLE(2, 2, 0, 0)), _MM_SHUFFLE(2, 2, 0, 0));
+        __m128i v = _mm_shufflehi_epi16(_mm_shufflelo_epi16(chroma, _MM_SHUFFLE(3, 3, 1, 1)), _MM_SHUFFLE(3, 3, 1, 1));
+
+        __m128i b = packYUVChannel(y, _mm_mullo_epi16(u, _mm_set1_epi16(55)));
+        __m128i g = packYUVChannel(y, _mm_sub_epi16(_mm_mullo_epi16(v, _mm_set1_epi16(-22)), _mm_mullo_epi16(u, _mm_set1_epi16(11))));
+        __m128i r = packYUVChannel(y, _mm_mullo_epi16(v, _mm_set1_epi16(44)));
+        __m128i bg = _mm_unpacklo_epi8(b, g);
+        __m128i ra = _mm_unpacklo_epi8(r, _mm_set1_epi8(static_cast<char>(0xFF)));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + i * 8), _mm_unpacklo_epi16(bg, ra));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + i * 8 + 16), _mm_unpackhi_epi16(bg, ra));
+    }
+    return i;
+}
 
-    uint8_t r2 = src[srcIndex + 4 + 2];
-    uint8_t g2 = src[srcIndex + 4 + 1];
-    uint8_t b2 = src[srcIndex + 4];
+// channel of 4 BGRA pixels as 32 bit lanes
+inline __m128i yuvChannel(__m128i pixels, int shift) {
+    return _mm_and_si128(_mm_srli_epi32(pixels, shift), _mm_set1_epi32(0xFF));
+}
 
-    uint32_t Y0 = static_cast<uint32_t>(0.299 * r1 + 0.587 * r2 + 0.114 * b1);
-    uint32_t Y1 = static_cast<uint32_t>(0.299 * r2 + 0.587 * g2 + 0.114 * b2);
+// lumaYUV of 8 pixels, the sums stay below 0x10000 so unsigned 16 bit lanes hold them
+inline __m128i lumaYUVVector(__m128i r, __m128i g, __m128i b) {
+    __m128i sum = _mm_add_epi16(_mm_mullo_epi16(r, _mm_set1_epi16(75)), _mm_mullo_epi16(g, _mm_set1_epi16(151)));
+    sum = _mm_add_epi16(sum, _mm_add_epi16(_mm_mullo_epi16(b, _mm_set1_epi16(30)), _mm_set1_epi16(128)));
+    return _mm_srli_epi16(sum, 8);
+}
 
-    uint8_t r = static_cast<uint8_t>((r2 + r1) / 2);
-    uint8_t g = static_cast<uint8_t>((g2 + g1) / 2);
-    uint8_t b = static_cast<uint8_t>((b2 + b1) / 2);
+// 128 + ((factor * difference + 128) >> 8) of the even 16 bit lanes as 32 bit lanes
+inline __m128i chromaYUVVector(__m128i difference, int16_t factor) {
+    __m128i product = _mm_madd_epi16(difference, _mm_set1_epi32(factor));
+    return _mm_add_epi32(_mm_srai_epi32(_mm_add_epi32(product, _mm_set1_epi32(128)), 8), _mm_set1_epi32(128));
+}
+
+// 4 pixel pairs per iteration, returns the number of pairs encoded
+uint64_t encodeYUVBlocks(const uint8_t* src, uint8_t* dst, uint64_t pairs) {
+    uint64_t i = 0;
+    for (; i + 4 <= pairs; i += 4) {
+        __m128i first = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + i * 8));
+        __m128i second = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + i * 8 + 16));
+        __m128i b = _mm_packs_epi32(yuvChannel(first, 0), yuvChannel(second, 0));   // 8 pixels per channel
+        __m128i g = _mm_packs_epi32(yuvChannel(first, 8), yuvChannel(second, 8));
+        __m128i r = _mm_packs_epi32(yuvChannel(first, 16), yuvChannel(second, 16));
+        __m128i luma = lumaYUVVector(r, g, b);
+
+        // pair averages and their luma in the even lanes
+        __m128i pairB = _mm_avg_epu16(b, _mm_srli_epi32(b, 16));
+        __m128i pairG = _mm_avg_epu16(g, _mm_srli_epi32(g, 16));
+        __m128i pairR = _mm_avg_epu16(r, _mm_srli_epi32(r, 16));
+        __m128i pairLuma = lumaYUVVector(pairR, pairG, pairB);
+        __m128i u = chromaYUVVector(_mm_sub_epi16(pairB, pairLuma), 149);
+        __m128i v = chromaYUVVector(_mm_sub_epi16(pairR, pairLuma), 186);
+
+        // U0..U3 V0..V3 clamped to bytes, interleaved to U V per pair
+        __m128i chroma = _mm_max_epi16(_mm_min_epi16(_mm_packs_epi32(u, v), _mm_set1_epi16(0xFF)), _mm_setzero_si128());
+        chroma = _mm_unpacklo_epi16(chroma, _mm_srli_si128(chroma, 8));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + i * 4), _mm_or_si128(chroma, _mm_slli_epi16(luma, 8)));
+    }
+    return i;
+}
+#else
+uint64_t decodeYUVBlocks(const uint8_t*, uint8_t*, uint64_t) { return 0; }
+uint64_t encodeYUVBlocks(const uint8_t*, uint8_t*, uint64_t) { return 0; }
+#endif
 
-    uint32_t U = static_cast<uint32_t>(128.0f - 0.14f * r - 0.29f * g + 0.43f * b);
-    uint32_t V = static_cast<uint32_t>(128.0f + 0.36f * r - 0.29f * g - 0.07f * b);
+}
 
-    uint16_t pixel1 = static_cast<uint16_t>((Y0 << 8) | U);
-    uint16_t pixel2 = static_cast<uint16_t>((Y1 << 8) | V);
+uint16_t YUV422::bpp() { return 16; }
 
-    dst[dstIndex + 3] = static_cast<uint8_t>((pixel2 >> 8) & 0xFF);
-    dst[dstIndex + 2] = static_cast<uint8_t>(pixel2 & 0xFF);
-    dst[dstIndex + 1] = static_cast<uint8_t>((pixel1 >> 8) & 0xFF);
-    dst[dstIndex] = static_cast<uint8_t>(pixel1 & 0xFF);
+void YUV422::decodePixel(uint8_t* src, uint64_t srcIndex, uint8_t* dst, uint64_t dstIndex) {
+    decodeYUVPair(src + srcIndex, dst + dstIndex);
+}
+
+void YUV422::encodePixel(uint8_t* src, uint64_t srcIndex, uint8_t* dst, uint64_t dstIndex) {
+    encodeYUVPair(src + srcIndex, dst + dstIndex);
+}
+
+void YUV422::decodeRow(const uint8_t* src, uint8_t* dst, uint64_t count) {
+    uint64_t pairs = count / 2;
+    for (uint64_t i = decodeYUVBlocks(src, dst, pairs); i < pairs; i++) {
+        decodeYUVPair(src + i * 4, dst + i * 8);
+    }
+    if (count & 1) { // a single pixel without V
+        decodeYUV(src[pairs * 4 + 1], src[pairs * 4] - 128, 0, dst + pairs * 8);
+    }
+}
+
+void YUV422::encodeRow(const uint8_t* src, uint8_t* dst, uint64_t count) {
+    uint64_t pairs = count / 2;
+    for (uint64_t i = encodeYUVBlocks(src, dst, pairs); i < pairs; i++) {
+        encodeYUVPair(src + i * 8, dst + i * 4);
+    }
+    if (count & 1) {
+        uint8_t pair[8];
+        memcpy(pair, src + pairs * 8, 4);
+        memcpy(pair + 4, src + pairs * 8, 4);
+        encodeYUVPair(pair, dst + pairs * 4);
+    }
 }
 
 
 // BUMP88
-uint16_t BUMP88::bpp() { return 16; }
+namespace {
+
+/**
+ * @brief BGRA normal colors of every R/S angle pair, indexed by the 16-bit pixel.
+ */
+const uint8_t* bumpTable() {
+    static const std::vector<uint8_t> table = []() {
+        std::vector<uint8_t> colors(0x10000 * 4);
+        for (uint32_t pixel = 0; pixel < 0x10000; pixel++) {
+            uint8_t r = static_cast<uint8_t>(pixel & 0xFF);
+            uint8_t s = static_cast<uint8_t>(pixel >> 8);
+
+            double rRadian = degreesToRadians(r / 255.0 * 360.0);
+            double sRadian = degreesToRadians(s / 255.0 * 90.0);
+
+            double x = std::cos(sRadian) * std::cos(rRadian);
+            double y = std::cos(sRadian) * std::sin(rRadian);
+            double z = std::sin(sRadian);
+
+            colors[pixel * 4 + 3] = 0xFF;
+            colors[pixel * 4 + 2] = static_cast<uint8_t>((0.5 * x + 0.5) * 255.0);
+            colors[pixel * 4 + 1] = static_cast<uint8_t>((0.5 * y + 0.5) * 255.0);
+            colors[pixel * 4 + 0] = static_cast<uint8_t>((0.5 * z + 0.5) * 255.0);
+        }
+        return colors;
+    }();
+    return table.data();
+}
 
-void BUMP88::decodePixel(uint8_t* src, uint64_t srcIndex, uint8_t* dst, uint64_t dstIndex) {
-    uint8_t r = src[srcIndex];
-    uint8_t s = src[srcIndex + 1];
+constexpr float bumpPi = 3.14159265358979f;
 
-    double rAngle = r / 255.0 * 360.0;
-    double sAngle = s / 255.0 * 90.0;
+// atan(t) for t in [0, 1], max error about 1e-5 radians
+inline float bumpAtan(float t) {
+    float t2 = t * t;
+    return t * (0.99997726f + t2 * (-0.33262347f + t2 * (0.19354346f + t2 * (-0.11643287f + t2 * (0.05265332f + t2 * -0.01172120f)))));
+}
 
-    double rRadian = degreesToRadians(rAngle);
-    double sRadian = degreesToRadians(sAngle);
+inline float bumpAtan2(float y, float x) {
+    float ax = std::fabs(x), ay = std::fabs(y);
+    float high = std::max(ax, ay);
+    float angle = bumpAtan(high > 0.0f ? std::min(ax, ay) / high : 0.0f);
+    if (ay > ax) angle = bumpPi * 0.5f - angle;
+    if (x < 0.0f) angle = bumpPi - angle;
+    return y < 0.0f ? -angle : angle;
+}
 
-    double x = std::cos(sRadian) * std::cos(rRadian);
-    double y = std::cos(sRadian) * std::sin(rRadian);
-    double z = std::sin(sRadian);
+inline void encodeBump(const uint8_t* src, uint8_t* dst) {
+    float x = src[2] * (2.0f / 255.0f) - 1.0f;
+    float y = src[1] * (2.0f / 255.0f) - 1.0f;
+    float z = src[0] * (2.0f / 255.0f) - 1.0f;
+    float rotation = bumpAtan2(y, x);
+    if (rotation < 0.0f) rotation += 2.0f * bumpPi;
+    float elevation = std::min(std::max(bumpAtan2(z, std::sqrt(x * x + y * y)), 0.0f), bumpPi * 0.5f);
+    dst[0] = static_cast<uint8_t>(rotation * (255.0f / (2.0f * bumpPi)) + 0.5f);
+    dst[1] = static_cast<uint8_t>(elevation * (255.0f / (0.5f * bumpPi)) + 0.5f);
+}
 
-    double colorR = 0.5 * x + 0.5;
-    double colorG = 0.5 * y + 0.5;
-    double colorB = 0.5 * z + 0.5;
+#if defined(SHENDK_PIXEL_SSE2)
+inline __m128 selectPs(__m128 mask, __m128 a, __m128 b) {
+    return _mm_or_ps(_mm_and_ps(mask, a), _mm_andnot_ps(mask, b));
+}
 
-    dst[dstIndex + 3] = 0xFF;
-    dst[dstIndex + 2] = static_cast<uint8_t>(colorR * 255.0);
-    dst[dstIndex + 1] = static_cast<uint8_t>(colorG * 255.0);
-    dst[dstIndex + 0] = static_cast<uint8_t>(colorB * 255.0);
+inline __m128 bumpAtan2(__m128 y, __m128 x) {
+    const __m128 signMask = _mm_set1_ps(-0.0f);
+    __m128 ax = _mm_andnot_ps(signMask, x), ay = _mm_andnot_ps(signMask, y);
+    __m128 high = _mm_max_ps(ax, ay);
+    __m128 nonZero = _mm_cmpgt_ps(high, _mm_setzero_ps());
+    __m128 t = _mm_and_ps(nonZero, _mm_div_ps(_mm_min_ps(ax, ay), _mm_or_ps(high, _mm_andnot_ps(nonZero, _mm_set1_ps(1.0f)))));
+    __m128 t2 = _mm_mul_ps(t, t);
+    __m128 angle = _mm_set1_ps(-0.01172120f);
+    angle = _mm_add_ps(_mm_mul_ps(angle, t2), _mm_set1_ps(0.05265332f));
+    angle = _mm_add_ps(_mm_mul_ps(angle, t2), _mm_set1_ps(-0.11643287f));
+    angle = _mm_add_ps(_mm_mul_ps(angle, t2), _mm_set1_ps(0.19354346f));
+    angle = _mm_add_ps(_mm_mul_ps(angle, t2), _mm_set1_ps(-0.33262347f));
+    angle = _mm_add_ps(_mm_mul_ps(angle, t2), _mm_set1_ps(0.99997726f));
+    angle = _mm_mul_ps(angle, t);
+    angle = selectPs(_mm_cmpgt_ps(ay, ax), _mm_sub_ps(_mm_set1_ps(bumpPi * 0.5f), angle), angle);
+    angle = selectPs(_mm_cmplt_ps(x, _mm_setzero_ps()), _mm_sub_ps(_mm_set1_ps(bumpPi), angle), angle);
+    return _mm_or_ps(angle, _mm_and_ps(y, signMask)); // angle is positive, copy the sign of y
 }
 
-void BUMP88::encodePixel(uint8_t* src, uint64_t srcIndex, uint8_t* dst, uint64_t dstIndex) {
-    uint8_t colorR = src[srcIndex + 2];
-    uint8_t colorG = src[srcIndex + 1];
-    uint8_t colorB = src[srcIndex];
+// 4 pixels per iteration
+uint64_t encodeBumpBlocks(const uint8_t* src, uint8_t* dst, uint64_t count) {
+    uint64_t i = 0;
+    const __m128 scale = _mm_set1_ps(2.0f / 255.0f);
+    const __m128 one = _mm_set1_ps(1.0f);
+    const __m128i byteMask = _mm_set1_epi32(0xFF);
+    for (; i + 4 <= count; i += 4) {
+        __m128i pixels = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + i * 4));
+        __m128 z = _mm_sub_ps(_mm_mul_ps(_mm_cvtepi32_ps(_mm_and_si128(pixels, byteMask)), scale), one);
+        __m128 y = _mm_sub_ps(_mm_mul_ps(_mm_cvtepi32_ps(_mm_and_si128(_mm_srli_epi32(pixels, 8), byteMask)), scale), one);
+        __m128 x = _mm_sub_ps(_mm_mul_ps(_mm_cvtepi32_ps(_mm_and_si128(_mm_srli_epi32(pixels, 16), byteMask)), scale), one);
+
+        __m128 rotation = bumpAtan2(y, x);
+        rotation = _mm_add_ps(rotation, _mm_and_ps(_mm_cmplt_ps(rotation, _mm_setzero_ps()), _mm_set1_ps(2.0f * bumpPi)));
+        __m128 elevation = bumpAtan2(z, _mm_sqrt_ps(_mm_add_ps(_mm_mul_ps(x, x), _mm_mul_ps(y, y))));
+        elevation = _mm_min_ps(_mm_max_ps(elevation, _mm_setzero_ps()), _mm_set1_ps(bumpPi * 0.5f));
+
+        const __m128 half = _mm_set1_ps(0.5f);
+        __m128i r = _mm_cvttps_epi32(_mm_add_ps(_mm_mul_ps(rotation, _mm_set1_ps(255.0f / (2.0f * bumpPi))), half));
+        __m128i s = _mm_cvttps_epi32(_mm_add_ps(_mm_mul_ps(elevation, _mm_set1_ps(255.0f / (0.5f * bumpPi))), half));
+        __m128i packed = _mm_or_si128(_mm_and_si128(r, byteMask), _mm_slli_epi32(_mm_and_si128(s, byteMask), 8));
+        packed = _mm_packs_epi32(_mm_srai_epi32(_mm_slli_epi32(packed, 16), 16), _mm_setzero_si128());
+        _mm_storel_epi64(reinterpret_cast<__m128i*>(dst + i * 2), packed);
+    }
+    return i;
+}
+#else
+uint64_t encodeBumpBlocks(const uint8_t*, uint8_t*, uint64_t) { return 0; }
+#endif
 
-    double x = colorR / 255.0 * 2.0 - 1.0;
-    double y = colorG / 255.0 * 2.0 - 1.0;
-    double z = colorB / 255.0 * 2.0 - 1.0;
+}
 
-    double radius = std::sqrt(std::pow(x, 2) + std::pow(y, 2) + std::pow(z, 2));
-    double rRadian = std::atan2(y, x);
-    double sRadian = std::asin(z / radius);
+uint16_t BUMP88::bpp() { return 16; }
 
-    double rAngle = radiansToDegrees(rRadian);
-    rAngle = rAngle < 0.0 ? rAngle + 360.0 : rAngle;
-    double sAngle = radiansToDegrees(sRadian);
+void BUMP88::decodePixel(uint8_t* src, uint64_t srcIndex, uint8_t* dst, uint64_t dstIndex) {
+    uint16_t pixel;
+    memcpy(&pixel, src + srcIndex, sizeof(uint16_t));
+    memcpy(dst + dstIndex, bumpTable() + pixel * 4, 4);
+}
 
-    rAngle = std::clamp<double>(rAngle, 0.0, 360.0);
-    sAngle = std::clamp<double>(sAngle, 0.0, 90.0);
+void BUMP88::encodePixel(uint8_t* src, uint64_t srcIndex, uint8_t* dst, uint64_t dstIndex) {
+    encodeBump(src + srcIndex, dst + dstIndex);
+}
 
-    uint8_t r = static_cast<uint8_t>(std::round(rAngle / 360.0 * 255.0));
-    uint8_t s = static_cast<uint8_t>(std::round(sAngle / 90.0 * 255.0));
+void BUMP88::decodeRow(const uint8_t* src, uint8_t* dst, uint64_t count) {
+    const uint8_t* table = bumpTable();
+    for (uint64_t i = 0; i < count; i++) {
+        uint16_t pixel;
+        memcpy(&pixel, src + i * 2, sizeof(uint16_t));
+        memcpy(dst + i * 4, table + pixel * 4, 4);
+    }
+}
 
-    dst[dstIndex + 1] = s;
-    dst[dstIndex + 0] = r;
+void BUMP88::encodeRow(const uint8_t* src, uint8_t* dst, uint64_t count) {
+    for (uint64_t i = encodeBumpBlocks(src, dst, count); i < count; i++) {
+        encodeBump(src + i * 4, dst + i * 2);
+    }
 }
 
 
@@ -238,32 +645,42 @@ void BUMP88::encodePixel(uint8_t* src, uint64_t srcIndex, uint8_t* dst, uint64_t
 uint16_t RGB555::bpp() { return 16; }
 
 void RGB555::decodePixel(uint8_t* src, uint64_t srcIndex, uint8_t* dst, uint64_t dstIndex) {
-    uint16_t pixel = *reinterpret_cast<uint16_t*>(src + srcIndex);
-    dst[dstIndex + 3] = 0xFF;
-    dst[dstIndex + 2] = static_cast<uint8_t>(((pixel >> 10) & 0x1F) * 0xFF / 0x1F);
-    dst[dstIndex + 1] = static_cast<uint8_t>(((pixel >> 5)  & 0x1F) * 0xFF / 0x1F);
-    dst[dstIndex + 0] = static_cast<uint8_t>(((pixel >> 0)  & 0x1F) * 0xFF / 0x1F);
+    uint16_t pixel;
+    memcpy(&pixel, src + srcIndex, sizeof(uint16_t));
+    RGB555Layout::decode(pixel, dst + dstIndex);
 }
 
 void RGB555::encodePixel(uint8_t* src, uint64_t srcIndex, uint8_t* dst, uint64_t dstIndex) {
-    uint16_t pixel = 0x0000;
-    pixel |= static_cast<uint16_t>((src[srcIndex + 2] >> 3) << 10);
-    pixel |= static_cast<uint16_t>((src[srcIndex + 1] >> 3) << 5);
-    pixel |= static_cast<uint16_t>((src[srcIndex + 0] >> 3) << 0);
-    dst[dstIndex + 1] = static_cast<uint8_t>((pixel >> 8) & 0xFF);
-    dst[dstIndex + 0] = static_cast<uint8_t>(pixel & 0xFF);
+    uint16_t pixel = RGB555Layout::encode(src + srcIndex);
+    memcpy(dst + dstIndex, &pixel, sizeof(uint16_t));
+}
+
+void RGB555::decodeRow(const uint8_t* src, uint8_t* dst, uint64_t count) {
+    RGB555Layout::decodeRow(src, dst, count);
+}
+
+void RGB555::encodeRow(const uint8_t* src, uint8_t* dst, uint64_t count) {
+    RGB555Layout::encodeRow(src, dst, count);
 }
 
 
 // ARGB8888
-uint16_t ARGB8888::bpp() { return 16; }
+uint16_t ARGB8888::bpp() { return 32; }
 
 void ARGB8888::decodePixel(uint8_t* src, uint64_t srcIndex, uint8_t* dst, uint64_t dstIndex) {
     memcpy(dst + dstIndex, src + srcIndex, 4);
 }
 
 void ARGB8888::encodePixel(uint8_t* src, uint64_t srcIndex, uint8_t* dst, uint64_t dstIndex) {
-    memcpy(src + srcIndex, dst + dstIndex, 4);
+    memcpy(dst + dstIndex, src + srcIndex, 4);
+}
+
+void ARGB8888::decodeRow(const uint8_t* src, uint8_t* dst, uint64_t count) {
+    memcpy(dst, src, count * 4);
+}
+
+void ARGB8888::encodeRow(const uint8_t* src, uint8_t* dst, uint64_t count) {
+    memcpy(dst, src, count * 4);
 }
 
 }
@@ -3,229 +3,256 @@
 #include <cstring>
 #include <algorithm>
 #include <limits>
+#include <random>
 
-#include <Eigen/Dense>
+#include "shendk/utils/parallel.h"
+#include "shendk/files/image/pvr/code_book_search.h"
 
-#include "shendk/utils/math.h"
-#include "shendk/files/image/pvr/twiddle.h"
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+    #include <emmintrin.h>
+    #define SHENDK_VQ_SSE2
+#endif
 
 namespace shendk {
 namespace pvr {
 
-struct VQBlock {
+namespace {
 
-    VQBlock()
-        : pixels(Eigen::MatrixXf(4, 4))
-    {}
+constexpr uint64_t chunkSize = 4096; // blocks per parallel work item
 
-    VQBlock(uint8_t blockSize, uint8_t pixelSize)
-        : pixels(Eigen::MatrixXf(blockSize, pixelSize))
-    {}
-
-    inline void zero() {
-        pixels = pixels.Zero(pixels.rows(), pixels.cols());
+/**
+ * @brief Squared error of two blocks, dimensions is a multiple of 4 (BGRA texels).
+ */
+inline float distance(const float* a, const float* b, uint32_t dimensions) {
+#if defined(SHENDK_VQ_SSE2)
+    __m128 sum = _mm_setzero_ps();
+    for (uint32_t i = 0; i < dimensions; i += 4) {
+        __m128 difference = _mm_sub_ps(_mm_loadu_ps(a + i), _mm_loadu_ps(b + i));
+        sum = _mm_add_ps(sum, _mm_mul_ps(difference, difference));
     }
-
-    inline void add(VQBlock& block) {
-        pixels += block.pixels;
+    sum = _mm_add_ps(sum, _mm_movehl_ps(sum, sum));
+    sum = _mm_add_ss(sum, _mm_shuffle_ps(sum, sum, 1));
+    return _mm_cvtss_f32(sum);
+#else
+    float sum = 0.0f;
+    for (uint32_t i = 0; i < dimensions; i++) {
+        float difference = a[i] - b[i];
+        sum += difference * difference;
     }
+    return sum;
+#endif
+}
 
-    inline void div(int group) {
-        pixels /= group;
-    }
+inline uint64_t chunkCount(uint64_t count) {
+    return (count + chunkSize - 1) / chunkSize;
+}
 
-    inline float distance(const VQBlock& block) const {
-        return std::abs((pixels - block.pixels).sum());
+/**
+ * @brief Training blocks as floats, evenly spread over the input when sampled.
+ */
+std::vector<float> trainingBlocks(const VQBlocks& blocks, uint64_t sampleSize) {
+    uint64_t count = blocks.count();
+    uint64_t samples = (sampleSize == 0 || sampleSize >= count) ? count : sampleSize;
+    uint32_t dimensions = blocks.blockSize();
+    std::vector<float> result(samples * dimensions);
+    for (uint64_t i = 0; i < samples; i++) {
+        const uint8_t* block = blocks.block(samples == count ? i : i * count / samples);
+        std::copy(block, block + dimensions, result.begin() + i * dimensions);
     }
+    return result;
+}
 
-    uint8_t* toArrayTwiddled() {
-        // TODO: only works with RGBA blocks
-        uint8_t* array = new uint8_t[pixels.rows() * 4];
-        uint64_t destinationIndex = 0;
-        int64_t sourceIndex = 0;
-        uint64_t* twiddleMap = createTwiddleMap(pixels.rows());
-        uint32_t blockHeight, blockWidth;
-        blockHeight = blockWidth = pixels.rows() / 2;
-        for (uint32_t y = 0; y < blockHeight; y++) {
-            for (uint32_t x = 0; x < blockWidth; x++) {
-                destinationIndex = (twiddleMap[x] << 1) | twiddleMap[y];
-                array[destinationIndex * 4]     = static_cast<uint8_t>(pixels(sourceIndex));
-                array[destinationIndex * 4 + 1] = static_cast<uint8_t>(pixels(sourceIndex + 1));
-                array[destinationIndex * 4 + 2] = static_cast<uint8_t>(pixels(sourceIndex + 2));
-                array[destinationIndex * 4 + 3] = static_cast<uint8_t>(pixels(sourceIndex + 3));
-                sourceIndex += 4;
-            }
-        }
-        delete[] twiddleMap;
-        return array;
-    }
+/**
+ * @brief k-means++: every further entry is picked with a probability proportional
+ *        to the squared error of a block to its nearest entry so far.
+ */
+void seedCodeBook(const std::vector<float>& points, uint32_t dimensions, uint32_t codeBookSize,
+                  std::mt19937& random, unsigned threads, std::vector<float>& codeBook) {
+    uint64_t count = points.size() / dimensions;
+    uint64_t chunks = chunkCount(count);
+    std::vector<float> errors(count, std::numeric_limits<float>::infinity());
+    std::vector<double> chunkErrors(chunks);
+    codeBook.assign(static_cast<uint64_t>(codeBookSize) * dimensions, 0.0f);
 
-    uint8_t* toArray() {
-        Eigen::Matrix<uint8_t, Eigen::Dynamic, Eigen::Dynamic> matrix = pixels.cast<uint8_t>();
-        uint8_t* array = new uint8_t(pixels.size());
-        memcpy(array, matrix.data(), pixels.size());
-        return array;
-        return nullptr;
-    }
+    uint64_t pick = random() % count;
+    for (uint32_t entry = 0; entry < codeBookSize; entry++) {
+        float* center = codeBook.data() + static_cast<uint64_t>(entry) * dimensions;
+        std::copy(points.begin() + pick * dimensions, points.begin() + (pick + 1) * dimensions, center);
+        if (entry + 1 == codeBookSize) break;
 
-    uint32_t group = 0;
-    Eigen::MatrixXf pixels;
-};
-
-int nearest(const VQBlock& block, VQBlock* cluster, int clusterSize, double& nearestDistance) {
-    int i = 0;
-    int nearestIndex = 0;
-    double distance = 0;
-    double minDistance = 0;
-    for (i = 0; i < clusterSize; i++) {
-        minDistance = std::numeric_limits<double>::infinity();
-        nearestIndex = block.group;
-        for (i = 0; i < clusterSize; i++) {
-            if (minDistance > (distance = cluster[i].distance(block))) {
-                minDistance = distance;
-                nearestIndex = i;
+        parallelFor(chunks, [&](size_t chunk) {
+            double sum = 0.0;
+            uint64_t end = std::min(count, (chunk + 1) * chunkSize);
+            for (uint64_t i = chunk * chunkSize; i < end; i++) {
+                errors[i] = std::min(errors[i], distance(points.data() + i * dimensions, center, dimensions));
+                sum += errors[i];
             }
-        }
-    }
-    nearestDistance = minDistance;
-    return nearestIndex;
-}
+            chunkErrors[chunk] = sum;
+        }, threads);
 
-std::vector<VQBlock> createBlocks(Image& image, int blockWidth, int blockHeight) {
-    //Convert bitmap to blocks
-    int width = image.width() / blockWidth;
-    int height = image.height() / blockHeight;
-    int blockSize = blockWidth * blockHeight * 4;
-    int blockCount = width * height;
-    std::vector<VQBlock> blocks(blockCount);
-
-    for (int y = 0; y < height - 1; y += blockHeight) {
-        for (int x = 0; x < width - 1; x += blockWidth) {
-            int blockIndex = (y / blockHeight) * width + (x / blockWidth);
-            blocks[blockIndex] = VQBlock(blockWidth * blockHeight, 4);
-            for (int k = 0; k < blockHeight; k++) {
-                for (int l = 0; l < blockWidth; l++) {
-                    int imageIndex = ((y + k) * width + (x + l)) * 4;
-                    int subVectorIndex = k * blockWidth + l;
-                    blocks[blockIndex].pixels(subVectorIndex * 4)     = image[imageIndex].b;
-                    blocks[blockIndex].pixels(subVectorIndex * 4 + 1) = image[imageIndex].g;
-                    blocks[blockIndex].pixels(subVectorIndex * 4 + 2) = image[imageIndex].r;
-                    blocks[blockIndex].pixels(subVectorIndex * 4 + 3) = image[imageIndex].a;
-                }
+        double total = 0.0;
+        for (double error : chunkErrors) total += error;
+        if (total <= 0.0) {
+            // every block is in the code book already, repeat blocks for the remaining entries
+            for (uint32_t rest = entry + 1; rest < codeBookSize; rest++) {
+                uint64_t block = rest % count;
+                std::copy(points.begin() + block * dimensions, points.begin() + (block + 1) * dimensions,
+                          codeBook.begin() + static_cast<uint64_t>(rest) * dimensions);
             }
+            break;
         }
-    }
-    return blocks;
-}
 
-std::vector<VQBlock> initializeCodeBook(std::vector<VQBlock> imageBlocks, int codeBookSize, bool fastInitialization) {
-    std::vector<VQBlock> codeBook(codeBookSize);
-    if (fastInitialization) {
-        int i = 0;
-        for (i = 0; i < codeBookSize; i++)
-        {
-            codeBook[i % codeBookSize] = VQBlock(imageBlocks[i]);
-        }
-        for (i = 0; i < imageBlocks.size(); i++)
-        {
-            imageBlocks[i].group = i % codeBookSize;
+        double target = std::uniform_real_distribution<double>(0.0, total)(random);
+        uint64_t chunk = 0;
+        while (chunk + 1 < chunks && target >= chunkErrors[chunk]) {
+            target -= chunkErrors[chunk++];
         }
-        return codeBook;
-    } else {
-        int i = 0;
-        int imageLength = imageBlocks.size();
-        double sum = 0.0;
-        double* distances = new double[imageBlocks.size()];
-        codeBook[0] = VQBlock(imageBlocks[std::rand() % imageBlocks.size()]);
-        for (int cluster = 1; cluster < codeBookSize; cluster++) {
-            sum = 0;
-            for (i = 0; i < imageLength; i++) {
-                nearest(imageBlocks[i], codeBook.data(), cluster, distances[i]);
-                sum += distances[i];
-            }
-            sum = sum * std::clamp(std::rand(), 0, 0x7fff) / (0x7fff - 1.0);
-            for (i = 0; i < imageLength; i++) {
-                if ((sum -= distances[i]) > 0) continue;
-                codeBook[cluster] = VQBlock(imageBlocks[i]);
+        uint64_t end = std::min(count, (chunk + 1) * chunkSize);
+        pick = end - 1;
+        for (uint64_t i = chunk * chunkSize; i < end; i++) {
+            if (errors[i] > 0.0f && (target -= errors[i]) < 0.0) {
+                pick = i;
                 break;
             }
         }
-        double dump = 0.0;
-        for (i = 0; i < imageLength; i++) {
-            imageBlocks[i].group = nearest(imageBlocks[i], codeBook.data(), codeBookSize, dump);
+    }
+}
+
+}
+
+VQBlocks::VQBlocks(uint8_t _blockWidth, uint8_t _blockHeight)
+    : blockWidth(_blockWidth)
+    , blockHeight(_blockHeight)
+{}
+
+void VQBlocks::add(const uint8_t* bgra, uint32_t width, uint32_t height) {
+    uint32_t blocksWide = std::max<uint32_t>(width / blockWidth, 1);
+    uint32_t blocksHigh = std::max<uint32_t>(height / blockHeight, 1);
+    uint64_t offset = texels.size();
+    texels.resize(offset + static_cast<uint64_t>(blocksWide) * blocksHigh * blockSize());
+    uint8_t* block = texels.data() + offset;
+    for (uint32_t y = 0; y < blocksHigh; y++) {
+        for (uint32_t x = 0; x < blocksWide; x++) {
+            for (uint32_t k = 0; k < blockHeight; k++) {
+                uint32_t imageY = std::min(y * blockHeight + k, height - 1);
+                for (uint32_t l = 0; l < blockWidth; l++, block += 4) {
+                    uint32_t imageX = std::min(x * blockWidth + l, width - 1);
+                    memcpy(block, bgra + (static_cast<uint64_t>(imageY) * width + imageX) * 4, 4);
+                }
+            }
         }
-        return codeBook;
     }
 }
 
-std::vector<VQBlock> createCodebook(Image& image, int codeBookSize, int blockWidth, int blockHeight)
-{
-    if (image.width() % blockWidth != 0 || image.height() % blockHeight != 0) {
-        throw std::runtime_error("The image can't be devided by the given block size!");
+std::vector<uint8_t> createCodeBook(const VQBlocks& blocks, uint32_t codeBookSize, const VQOptions& options) {
+    uint32_t dimensions = blocks.blockSize();
+    std::vector<uint8_t> result(static_cast<uint64_t>(codeBookSize) * dimensions);
+    if (blocks.count() == 0 || codeBookSize == 0) {
+        return result;
     }
 
-    std::vector<VQBlock> imageBlocks = createBlocks(image, blockWidth, blockHeight);
-    std::vector<VQBlock> codeBookBlocks = initializeCodeBook(imageBlocks, codeBookSize);
-
-    int i = 0;
-    int j = 0;
-    int changed = 0;
-    int nearestIndex = 0;
-    VQBlock imageBlock;
-    VQBlock codeBookBlock;
-    double dump = 0.0;
-    int runs = 0;
-
-    do {
-        for (i = 0; i < codeBookSize; i++) {
-            codeBookBlock = codeBookBlocks[i];
-            codeBookBlock.group = 0;
-            codeBookBlock.zero();
-        }
-        for (j = 0; j < imageBlocks.size(); j++) {
-            imageBlock = imageBlocks[j];
-            codeBookBlock = codeBookBlocks[imageBlock.group];
-            codeBookBlock.group += 1;
-            codeBookBlock.add(imageBlock);
-        }
-        for (i = 0; i < codeBookSize; i++) {
-            codeBookBlock = codeBookBlocks[i];
-            codeBookBlock.div(codeBookBlock.group);
+    std::vector<float> points = trainingBlocks(blocks, options.sampleSize);
+    uint64_t count = points.size() / dimensions;
+    uint64_t chunks = chunkCount(count);
+    std::mt19937 random(options.seed);
+    std::vector<float> codeBook;
+    seedCodeBook(points, dimensions, codeBookSize, random, options.threads, codeBook);
+
+    // Lloyd iterations, blocks are assigned and summed up per chunk in parallel
+    uint64_t sumSize = static_cast<uint64_t>(codeBookSize) * dimensions;
+    std::vector<double> sums(chunks * sumSize);
+    std::vector<uint32_t> counts(chunks * codeBookSize);
+    std::vector<uint64_t> entryCounts(codeBookSize);
+    std::vector<double> chunkErrors(chunks);
+    std::vector<uint64_t> chunkChanges(chunks);
+    std::vector<uint32_t> assignments(count, codeBookSize);
+    double previousError = std::numeric_limits<double>::infinity();
+    for (uint32_t iteration = 0; iteration < options.maxIterations; iteration++) {
+        CodeBookSearch search(codeBook.data(), codeBookSize, dimensions);
+        parallelFor(chunks, [&](size_t chunk) {
+            double* chunkSums = sums.data() + chunk * sumSize;
+            uint32_t* chunkCounts = counts.data() + chunk * codeBookSize;
+            std::fill(chunkSums, chunkSums + sumSize, 0.0);
+            std::fill(chunkCounts, chunkCounts + codeBookSize, 0);
+            double error = 0.0;
+            uint64_t changes = 0;
+            uint64_t end = std::min(count, (chunk + 1) * chunkSize);
+            for (uint64_t i = chunk * chunkSize; i < end; i++) {
+                const float* point = points.data() + i * dimensions;
+                float pointError;
+                uint32_t entry = search.nearest(point, pointError);
+                changes += entry != assignments[i];
+                assignments[i] = entry;
+                error += pointError;
+                chunkCounts[entry]++;
+                double* sum = chunkSums + static_cast<uint64_t>(entry) * dimensions;
+                for (uint32_t d = 0; d < dimensions; d++) {
+                    sum[d] += point[d];
+                }
+            }
+            chunkErrors[chunk] = error;
+            chunkChanges[chunk] = changes;
+        }, options.threads);
+
+        double error = 0.0;
+        uint64_t changes = 0;
+        for (uint64_t chunk = 0; chunk < chunks; chunk++) {
+            error += chunkErrors[chunk];
+            changes += chunkChanges[chunk];
         }
-        changed = 0;
-        for (j = 0; j < imageBlocks.size(); j++) {
-            imageBlock = imageBlocks[j];
-            nearestIndex = nearest(imageBlock, codeBookBlocks.data(), codeBookSize, dump);
-            if (nearestIndex != imageBlock.group)
-            {
-                changed++;
-                imageBlock.group = nearestIndex;
+        if (changes == 0) break;
+
+        // move the entries to the centroids of their blocks, empty entries restart at a random block
+        parallelFor(codeBookSize, [&](size_t entry) {
+            uint64_t entryCount = 0;
+            for (uint64_t chunk = 0; chunk < chunks; chunk++) {
+                entryCount += counts[chunk * codeBookSize + entry];
+            }
+            entryCounts[entry] = entryCount;
+            if (entryCount == 0) return;
+            float* center = codeBook.data() + entry * dimensions;
+            for (uint32_t d = 0; d < dimensions; d++) {
+                double sum = 0.0;
+                for (uint64_t chunk = 0; chunk < chunks; chunk++) {
+                    sum += sums[chunk * sumSize + entry * dimensions + d];
+                }
+                center[d] = static_cast<float>(sum / entryCount);
             }
+        }, options.threads);
+        for (uint32_t entry = 0; entry < codeBookSize; entry++) {
+            if (entryCounts[entry] != 0) continue;
+            uint64_t block = random() % count;
+            std::copy(points.begin() + block * dimensions, points.begin() + (block + 1) * dimensions,
+                      codeBook.begin() + static_cast<uint64_t>(entry) * dimensions);
         }
-        runs++;
-    } while (changed > (imageBlocks.size() >> 10));
 
-    for (i = 0; i < codeBookSize; i++) {
-        codeBookBlock = codeBookBlocks[i];
-        codeBookBlock.group = i;
+        if (previousError - error <= options.tolerance * previousError) break;
+        previousError = error;
     }
-    return codeBookBlocks;
-}
 
-uint8_t* quantizeImage(Image& image, std::vector<VQBlock> codeBook, uint8_t blockSize) {
-    std::vector<VQBlock> blocks = createBlocks(image, blockSize, blockSize);
-    uint8_t* result = new uint8_t[blocks.size()];
-    double dump = 0.0;
-    for (int i = 0; i < blocks.size(); i++) {
-        VQBlock block = blocks[i];
-        result[i] = nearest(block, codeBook.data(), codeBook.size(), dump);
+    for (uint64_t i = 0; i < codeBook.size(); i++) {
+        result[i] = static_cast<uint8_t>(std::clamp(codeBook[i] + 0.5f, 0.0f, 255.0f));
     }
     return result;
 }
 
-uint8_t* quantizeImage(Image& image, uint32_t codeBookSize, uint8_t blockSize, uint8_t pixelSize) {
-    std::vector<VQBlock> codeBook = createCodebook(image, codeBookSize);
-    return quantizeImage(image, codeBook, blockSize);
+std::vector<uint8_t> quantize(const VQBlocks& blocks, const std::vector<uint8_t>& codeBook, unsigned threads) {
+    uint32_t dimensions = blocks.blockSize();
+    std::vector<uint8_t> result(blocks.count());
+    if (codeBook.size() < dimensions) {
+        return result;
+    }
+    CodeBookSearch search(codeBook, dimensions);
+    parallelFor(chunkCount(result.size()), [&](size_t chunk) {
+        std::vector<float> block(dimensions);
+        uint64_t end = std::min<uint64_t>(result.size(), (chunk + 1) * chunkSize);
+        for (uint64_t i = chunk * chunkSize; i < end; i++) {
+            std::copy(blocks.block(i), blocks.block(i) + dimensions, block.begin());
+            float error;
+            result[i] = static_cast<uint8_t>(search.nearest(block.data(), error));
+        }
+    }, threads);
+    return result;
 }
 
 }
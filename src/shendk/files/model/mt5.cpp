@@ -2,6 +2,7 @@
 
 #include "shendk/files/model/mt5/mt5_node.h"
 #include "shendk/types/texture_id.h"
+#include "shendk/utils/binary_reader.h"
 
 namespace shendk {
 
@@ -18,9 +19,14 @@ void MT5::_read(std::istream& stream) {
     stream.read(reinterpret_cast<char*>(&header), sizeof(MT5::Header));
     if (!isValid(header.signature)) throw new std::runtime_error("Invalid signature for MT5 file!\n");
 
+    // the node tree ends where the appended nodes begin
+    stream.seekg(baseOffset, std::ios::beg);
+    std::vector<uint8_t> storage;
+    BinaryReader reader = BinaryReader::fromStream(stream, storage, header.nodesSize);
+
     // read nodes recursively
-    stream.seekg(baseOffset + header.firstNodeOffset, std::ios::beg);
-    model.rootNode = std::shared_ptr<ModelNode>(new mt5::MT5Node(&model, stream, baseOffset));
+    reader.seek(header.firstNodeOffset);
+    model.rootNode = std::shared_ptr<ModelNode>(new mt5::MT5Node(&model, reader));
 
     // clean mesh
     if (cleanMeshOnLoad) { cleanMesh(); }
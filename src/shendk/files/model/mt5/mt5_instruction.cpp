@@ -7,12 +7,12 @@ namespace mt5 {
 
 Instruction::Instruction() {}
 Instruction::Instruction(InstructionType t) : type(t) {}
-Instruction::Instruction(std::istream& stream) { read(stream); }
+Instruction::Instruction(BinaryReader& reader) { read(reader); }
 Instruction::~Instruction() {}
 
-void Instruction::read(std::istream& stream) {
-    stream.read(reinterpret_cast<char*>(&type), sizeof(uint16_t));
-    _read(stream);
+void Instruction::read(BinaryReader& reader) {
+    type = reader.read<InstructionType>();
+    _read(reader);
 }
 
 void Instruction::write(std::ostream& stream) {
@@ -23,21 +23,21 @@ void Instruction::write(std::ostream& stream) {
 
 
 InBasic::InBasic() {}
-InBasic::InBasic(std::istream& stream) { read(stream); }
+InBasic::InBasic(BinaryReader& reader) { read(reader); }
 InBasic::~InBasic() {}
-void InBasic::_read(std::istream& stream) {}
+void InBasic::_read(BinaryReader&) {}
 void InBasic::_write(std::ostream& stream) {}
 
 
 
 InAttributes::InAttributes() {}
-InAttributes::InAttributes(std::istream& stream) { read(stream); }
+InAttributes::InAttributes(BinaryReader& reader) { read(reader); }
 InAttributes::~InAttributes() {}
 
-void InAttributes::_read(std::istream& stream) {
-    stream.read(reinterpret_cast<char*>(&size), sizeof(uint16_t));
+void InAttributes::_read(BinaryReader& reader) {
+    size = reader.read<uint16_t>();
     data.resize(size);
-    stream.read(reinterpret_cast<char*>(&data[0]), size);
+    reader.readArray(data.data(), size);
 }
 
 void InAttributes::_write(std::ostream& stream) {
@@ -64,11 +64,11 @@ bool InAttributes::mirrorV() {
 
 
 InUnknown1::InUnknown1() {}
-InUnknown1::InUnknown1(std::istream& stream) { read(stream); }
+InUnknown1::InUnknown1(BinaryReader& reader) { read(reader); }
 InUnknown1::~InUnknown1() {}
 
-void InUnknown1::_read(std::istream& stream) {
-    stream.read(reinterpret_cast<char*>(&value), sizeof(uint16_t));
+void InUnknown1::_read(BinaryReader& reader) {
+    value = reader.read<uint16_t>();
 }
 
 void InUnknown1::_write(std::ostream& stream) {
@@ -78,11 +78,11 @@ void InUnknown1::_write(std::ostream& stream) {
 
 
 InTexture::InTexture() {}
-InTexture::InTexture(std::istream& stream) { read(stream); }
+InTexture::InTexture(BinaryReader& reader) { read(reader); }
 InTexture::~InTexture() {}
 
-void InTexture::_read(std::istream& stream) {
-    stream.read(reinterpret_cast<char*>(&textureIndex), sizeof(uint16_t));
+void InTexture::_read(BinaryReader& reader) {
+    textureIndex = reader.read<uint16_t>();
 }
 
 void InTexture::_write(std::ostream& stream) {
@@ -92,11 +92,11 @@ void InTexture::_write(std::ostream& stream) {
 
 
 InUvSize::InUvSize() {}
-InUvSize::InUvSize(std::istream& stream) { read(stream); }
+InUvSize::InUvSize(BinaryReader& reader) { read(reader); }
 InUvSize::~InUvSize() {}
 
-void InUvSize::_read(std::istream& stream) {
-    stream.read(reinterpret_cast<char*>(&uvSize), sizeof(uint16_t));
+void InUvSize::_read(BinaryReader& reader) {
+    uvSize = reader.read<uint16_t>();
 }
 
 void InUvSize::_write(std::ostream& stream) {
@@ -106,11 +106,11 @@ void InUvSize::_write(std::ostream& stream) {
 
 
 InUnknown2::InUnknown2() {}
-InUnknown2::InUnknown2(std::istream& stream) { read(stream); }
+InUnknown2::InUnknown2(BinaryReader& reader) { read(reader); }
 InUnknown2::~InUnknown2() {}
 
-void InUnknown2::_read(std::istream& stream) {
-    stream.read(reinterpret_cast<char*>(&data), sizeof(InUnknown2::Data));
+void InUnknown2::_read(BinaryReader& reader) {
+    data = reader.read<InUnknown2::Data>();
 }
 
 void InUnknown2::_write(std::ostream& stream) {
@@ -120,18 +120,18 @@ void InUnknown2::_write(std::ostream& stream) {
 
 
 InStrip::InStrip() {}
-InStrip::InStrip(std::istream& stream, MT5Mesh* mesh)
+InStrip::InStrip(BinaryReader& reader, MT5Mesh* mesh)
     : Instruction()
     , mesh(mesh)
 {
-    read(stream);
+    read(reader);
 }
 
 InStrip::~InStrip() {}
 
-void InStrip::_read(std::istream& stream) {
-    stream.read(reinterpret_cast<char*>(&unknown), sizeof(uint16_t));
-    stream.read(reinterpret_cast<char*>(&stripCount), sizeof(uint16_t));
+void InStrip::_read(BinaryReader& reader) {
+    unknown = reader.read<uint16_t>();
+    stripCount = reader.read<uint16_t>();
     if (stripCount == 0) return;
 
     bool uv = hasUV();
@@ -151,15 +151,13 @@ void InStrip::_read(std::istream& stream) {
             face.material.textureWrapMode = TextureWrapMode::Repeat;
         }
 
-        int16_t stripLength = 0;
-        stream.read(reinterpret_cast<char*>(&stripLength), sizeof(int16_t));
+        int16_t stripLength = reader.read<int16_t>();
         if (stripLength < 0) {
             stripLength = -stripLength;
         }
 
         for (int j = 0; j < stripLength; j++) {
-            int16_t vertexIndex = 0;
-            stream.read(reinterpret_cast<char*>(&vertexIndex), sizeof(int16_t));
+            int16_t vertexIndex = reader.read<int16_t>();
             ModelNode* parent = mesh->node->parent;
             uint32_t index = mesh->getIndex(vertexIndex);
 
@@ -170,9 +168,8 @@ void InStrip::_read(std::istream& stream) {
             face.nodeIndices.push_back(index);
 
             if (uv) {
-                uint16_t u,v;
-                stream.read(reinterpret_cast<char*>(&u), sizeof(uint16_t));
-                stream.read(reinterpret_cast<char*>(&v), sizeof(uint16_t));
+                uint16_t u = reader.read<uint16_t>();
+                uint16_t v = reader.read<uint16_t>();
                 double texU = u;
                 double texV = v;
                 if (isUVH) {
@@ -195,8 +192,7 @@ void InStrip::_read(std::istream& stream) {
             }
 
             if (color) {
-                BGRA bgra;
-                stream.read(reinterpret_cast<char*>(&bgra), sizeof(BGRA));
+                BGRA bgra = reader.read<BGRA>();
                 Vector4f color(bgra.b, bgra.g, bgra.r, bgra.a);
                 color /= 255.0f;
                 face.colorIndices.push_back(mesh->vertexBuffer().colors.size());
@@ -6,31 +6,29 @@ namespace shendk {
 namespace mt5 {
 
 MT5Mesh::MT5Mesh(MT5Node* node) : NodeMesh(node) {}
-MT5Mesh::MT5Mesh(MT5Node* node, std::istream& stream)
+MT5Mesh::MT5Mesh(MT5Node* node, BinaryReader& reader)
     : NodeMesh(node)
 {
-    read(stream);
+    read(reader);
 }
 
 MT5Mesh::~MT5Mesh() {}
 
-void MT5Mesh::read(std::istream& stream) {
+void MT5Mesh::read(BinaryReader& reader) {
 
     if (node->parent) {
         parentNode = dynamic_cast<MT5Node*>(node->parent);
     }
 
-    stream.read(reinterpret_cast<char*>(&header), sizeof(MT5Mesh::Header));
+    header = reader.read<MT5Mesh::Header>();
     node->center = Vector3f(header.centerX, header.centerY, header.centerZ);
     node->radius = header.radius;
     vertexCount = header.vertexCount;
 
-    stream.seekg(header.verticesOffset, std::ios::beg);
+    reader.seek(header.verticesOffset);
     for (int i = 0; i < header.vertexCount; i++) {
-        Vector3f pos;
-        Vector3f norm;
-        stream.read(reinterpret_cast<char*>(&pos), sizeof(Vector3f));
-        stream.read(reinterpret_cast<char*>(&norm), sizeof(Vector3f));
+        Vector3f pos = reader.read<Vector3f>();
+        Vector3f norm = reader.read<Vector3f>();
         node->model->vertexBuffer.positions.push_back(pos);
         node->model->vertexBuffer.normals.push_back(norm);
         Vector3f t_pos = pos.transformPosition(node->getTransformMatrix());
@@ -42,22 +40,18 @@ void MT5Mesh::read(std::istream& stream) {
         node->model->vertexBuffer.nodes.push_back(node->index);
     }
 
-    int64_t instructionOffset;
-    stream.seekg(header.facesOffset, std::ios::beg);
-    while (!stream.eof()) {
-        InstructionType stripType;
-        instructionOffset = stream.tellg();
-        stream.read(reinterpret_cast<char*>(&stripType), sizeof(uint16_t));
-        stream.seekg(instructionOffset, std::ios::beg);
+    reader.seek(header.facesOffset);
+    while (!reader.eof()) {
+        InstructionType stripType = reader.peek<InstructionType>();
 
         if (stripType == InstructionType::End_0080) { break; }
 
         switch(stripType) {
             case InstructionType::Zero_0000:
-                instructions.push_back(std::shared_ptr<Instruction>(new InBasic(stream)));
+                instructions.push_back(std::shared_ptr<Instruction>(new InBasic(reader)));
                 continue;
             case InstructionType::Skip_FFFF:
-                instructions.push_back(std::shared_ptr<Instruction>(new InBasic(stream)));
+                instructions.push_back(std::shared_ptr<Instruction>(new InBasic(reader)));
                 continue;
 
             case InstructionType::StripAttrib_0200:
@@ -67,14 +61,14 @@ void MT5Mesh::read(std::istream& stream) {
             case InstructionType::StripAttrib_0600:
             case InstructionType::StripAttrib_0700:
             {
-                std::shared_ptr<InAttributes>attr = std::shared_ptr<InAttributes>(new InAttributes(stream));
+                std::shared_ptr<InAttributes>attr = std::shared_ptr<InAttributes>(new InAttributes(reader));
                 state.attributes = *attr.get();
                 instructions.push_back(attr);
                 continue;
             }
             case InstructionType::Texture_0900:
             {
-                std::shared_ptr<InTexture>tex = std::shared_ptr<InTexture>(new InTexture(stream));
+                std::shared_ptr<InTexture>tex = std::shared_ptr<InTexture>(new InTexture(reader));
                 state.texture = *tex.get();
                 instructions.push_back(tex);
                 continue;
@@ -82,14 +76,14 @@ void MT5Mesh::read(std::istream& stream) {
             case InstructionType::Unknown1_0800:
             case InstructionType::Unknown1_0A00:
             {
-                std::shared_ptr<InUnknown1>u1 = std::shared_ptr<InUnknown1>(new InUnknown1(stream));
+                std::shared_ptr<InUnknown1>u1 = std::shared_ptr<InUnknown1>(new InUnknown1(reader));
                 state.unknown1 = *u1.get();
                 instructions.push_back(u1);
                 continue;
             }
             case InstructionType::UvSize_0B00:
             {
-                std::shared_ptr<InUvSize>uv = std::shared_ptr<InUvSize>(new InUvSize(stream));
+                std::shared_ptr<InUvSize>uv = std::shared_ptr<InUvSize>(new InUvSize(reader));
                 state.uvSize = *uv.get();
                 instructions.push_back(uv);
                 continue;
@@ -97,7 +91,7 @@ void MT5Mesh::read(std::istream& stream) {
             case InstructionType::Unknown2_0E00:
             case InstructionType::Unknown2_0F00:
             {
-                std::shared_ptr<InUnknown2>u2 = std::shared_ptr<InUnknown2>(new InUnknown2(stream));
+                std::shared_ptr<InUnknown2>u2 = std::shared_ptr<InUnknown2>(new InUnknown2(reader));
                 state.unknown2 = *u2.get();
                 instructions.push_back(u2);
                 continue;
@@ -112,7 +106,7 @@ void MT5Mesh::read(std::istream& stream) {
             case InstructionType::Strip_1A00:
             case InstructionType::Strip_1B00:
             case InstructionType::Strip_1C00:
-                instructions.push_back(std::shared_ptr<Instruction>(new InStrip(stream, this)));
+                instructions.push_back(std::shared_ptr<Instruction>(new InStrip(reader, this)));
                 continue;
             default:
                 stripType = InstructionType::End_0080;
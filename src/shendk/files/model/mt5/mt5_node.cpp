@@ -14,17 +14,17 @@ MT5Node::MT5Node(Model* model, MT5Node* _parent)
     parent = _parent;
 }
 
-MT5Node::MT5Node(Model* model, std::istream& stream, int64_t baseOffset, MT5Node* _parent)
+MT5Node::MT5Node(Model* model, BinaryReader& reader, MT5Node* _parent)
     : ModelNode(model)
 {
     parent = _parent;
-    read(stream, baseOffset);
+    read(reader);
 }
 
 MT5Node::~MT5Node() {}
 
-void MT5Node::read(std::istream& stream , int64_t baseOffset) {
-    stream.read(reinterpret_cast<char*>(&data), sizeof(MT5Node::Data));
+void MT5Node::read(BinaryReader& reader) {
+    data = reader.read<MT5Node::Data>();
 
     id = data.id;
     position = Vector3f(data.posX, data.posY, data.posZ);
@@ -34,19 +34,19 @@ void MT5Node::read(std::istream& stream , int64_t baseOffset) {
 
     // read mesh data
     if (data.meshOffset != 0) {
-        stream.seekg(baseOffset + data.meshOffset, std::ios::beg);
-        mesh = new MT5Mesh(this, stream);
+        reader.seek(data.meshOffset);
+        mesh = new MT5Mesh(this, reader);
     }
 
     // construct nodes
     if (data.childNodeOffset != 0) {
-        stream.seekg(baseOffset + data.childNodeOffset, std::ios::beg);
-        child = new MT5Node(model, stream, baseOffset, this);
+        reader.seek(data.childNodeOffset);
+        child = new MT5Node(model, reader, this);
     }
 
     if (data.nextNodeOffset != 0) {
-        stream.seekg(baseOffset + data.nextNodeOffset, std::ios::beg);
-        nextSibling = new MT5Node(model,stream, baseOffset, dynamic_cast<MT5Node*>(parent));
+        reader.seek(data.nextNodeOffset);
+        nextSibling = new MT5Node(model, reader, dynamic_cast<MT5Node*>(parent));
     }
 }
 
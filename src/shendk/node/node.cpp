@@ -1,6 +1,10 @@
 #include "shendk/node/node.h"
 
+#include <memory>
+#include <stdexcept>
+
 #include "shendk/utils/memstream.h"
+#include "shendk/utils/memory_view.h"
 
 namespace shendk {
 
@@ -10,18 +14,34 @@ Node::~Node() {}
 void Node::read(std::istream& stream) {
     baseOffset = stream.tellg();
     stream.read(reinterpret_cast<char*>(&header), sizeof(Node::Header));
+    if (stream.gcount() != sizeof(Node::Header)) {
+        throw new std::runtime_error("Truncated node header!");
+    }
 
     // check for invalid node
     if (header.signature == 0 || header.size == 0) {
         return;
     }
+    if (header.size < sizeof(Node::Header)) {
+        throw new std::runtime_error("Node size is smaller than its header!");
+    }
 
+    // parse the node body straight from the parent's memory if possible,
+    // so nested nodes don't copy their data again
     uint64_t bufferSize = header.size - sizeof(Node::Header);
-    char* buffer = new char[bufferSize];
-    stream.read(buffer, static_cast<int64_t>(bufferSize));
-    imstream nodeStream(buffer, bufferSize);
-    _read(nodeStream);
-    delete[] buffer;
+    MemoryView body = getMemoryView(stream).sub(baseOffset + sizeof(Node::Header), bufferSize);
+    if (body && body.size == bufferSize) {
+        imstream nodeStream(const_cast<char*>(body.data), bufferSize); // input only, never written to
+        _read(nodeStream);
+    } else {
+        std::unique_ptr<char[]> buffer(new char[bufferSize]);
+        stream.read(buffer.get(), static_cast<int64_t>(bufferSize));
+        if (static_cast<uint64_t>(stream.gcount()) != bufferSize) {
+            throw new std::runtime_error("Truncated node body!");
+        }
+        imstream nodeStream(buffer.get(), bufferSize);
+        _read(nodeStream);
+    }
     stream.seekg(baseOffset + header.size, std::ios::beg);
 }
 
@@ -3,9 +3,215 @@
 #include <stdint.h>
 #include <memory>
 #include <cstring>
+#include <algorithm>
+#include <array>
+#include <cmath>
+
+#include "shendk/utils/parallel.h"
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+    #include <emmintrin.h>
+    #define SHENDK_IMAGE_SSE2
+#endif
 
 namespace shendk {
 
+namespace {
+
+constexpr uint64_t serialPixels = 128 * 128; // levels up to this many pixels are not worth starting threads for
+
+/**
+ * @brief Worker threads for resampling between two sizes, small images run on the calling thread.
+ */
+unsigned resampleThreads(uint64_t srcPixels, uint64_t dstPixels, unsigned threads) {
+    return std::max(srcPixels, dstPixels) <= serialPixels ? 1 : threads;
+}
+
+// radius of a filter in source texels, before it is widened for downscaling
+double filterSupport(ResampleFilter filter) {
+    switch (filter) {
+    case ResampleFilter::Box: return 0.5;
+    case ResampleFilter::Triangle: return 1.0;
+    case ResampleFilter::Lanczos3: return 3.0;
+    }
+    return 1.0;
+}
+
+double filterWeight(ResampleFilter filter, double x) {
+    switch (filter) {
+    case ResampleFilter::Box:
+        return (x >= -0.5 && x < 0.5) ? 1.0 : 0.0;
+    case ResampleFilter::Triangle:
+        x = std::fabs(x);
+        return x < 1.0 ? 1.0 - x : 0.0;
+    case ResampleFilter::Lanczos3: {
+        const double pi = 3.14159265358979323846;
+        if (std::fabs(x) < 1e-8) return 1.0;
+        if (std::fabs(x) >= 3.0) return 0.0;
+        double px = pi * x;
+        return 3.0 * std::sin(px) * std::sin(px / 3.0) / (px * px);
+    }
+    }
+    return 0.0;
+}
+
+/**
+ * @brief Source texels and normalized weights of every destination texel along one axis,
+ *        count taps each (unused taps weigh 0). Texels beyond the edges are clamped.
+ */
+struct Taps {
+    uint32_t count;
+    std::vector<uint32_t> indices;
+    std::vector<float> weights;
+};
+
+Taps createTaps(uint32_t srcSize, uint32_t dstSize, ResampleFilter filter) {
+    double scale = static_cast<double>(srcSize) / dstSize;
+    double filterScale = std::max(scale, 1.0);
+    double support = filterSupport(filter) * filterScale;
+    Taps taps;
+    taps.count = static_cast<uint32_t>(std::ceil(support * 2.0)) + 1;
+    taps.indices.assign(static_cast<uint64_t>(dstSize) * taps.count, 0);
+    taps.weights.assign(static_cast<uint64_t>(dstSize) * taps.count, 0.0f);
+    std::vector<double> weights(taps.count);
+    for (uint32_t i = 0; i < dstSize; i++) {
+        double center = (i + 0.5) * scale;
+        int64_t first = static_cast<int64_t>(std::ceil(center - support - 0.5));
+        double total = 0.0;
+        for (uint32_t k = 0; k < taps.count; k++) {
+            weights[k] = filterWeight(filter, (first + k + 0.5 - center) / filterScale);
+            total += weights[k];
+        }
+        uint32_t* indices = taps.indices.data() + static_cast<uint64_t>(i) * taps.count;
+        float* normalized = taps.weights.data() + static_cast<uint64_t>(i) * taps.count;
+        if (total == 0.0) {
+            // nothing in reach, take the nearest texel
+            indices[0] = static_cast<uint32_t>(std::min<int64_t>(static_cast<int64_t>(center), srcSize - 1));
+            normalized[0] = 1.0f;
+            continue;
+        }
+        for (uint32_t k = 0, used = 0; k < taps.count; k++) {
+            if (weights[k] == 0.0) continue;
+            indices[used] = static_cast<uint32_t>(std::clamp<int64_t>(first + k, 0, srcSize - 1));
+            normalized[used++] = static_cast<float>(weights[k] / total);
+        }
+    }
+    return taps;
+}
+
+/**
+ * @brief sRGB values to linear light (both 0 to 255) and the midpoints between the linear values
+ *        of neighbouring sRGB values, to round back exactly.
+ */
+struct SRGBTables {
+    SRGBTables() {
+        for (int i = 0; i < 256; i++) {
+            double value = i / 255.0;
+            value = value <= 0.04045 ? value / 12.92 : std::pow((value + 0.055) / 1.055, 2.4);
+            toLinear[i] = static_cast<float>(value * 255.0);
+        }
+        for (int i = 0; i < 255; i++) {
+            midpoints[i] = (toLinear[i] + toLinear[i + 1]) * 0.5f;
+        }
+    }
+
+    std::array<float, 256> toLinear;
+    std::array<float, 255> midpoints;
+};
+
+const SRGBTables& srgbTables() {
+    static const SRGBTables tables;
+    return tables;
+}
+
+// RGBA texels to floats, color channels in linear light for sRGB
+std::vector<float> toFloat(const RGBA* pixels, uint32_t width, uint32_t height, bool srgb, unsigned threads) {
+    std::vector<float> result(static_cast<uint64_t>(width) * height * 4);
+    const SRGBTables& tables = srgbTables();
+    parallelFor(height, [&](size_t y) {
+        const uint8_t* src = reinterpret_cast<const uint8_t*>(pixels + y * width);
+        float* dst = result.data() + y * width * 4;
+        for (uint32_t i = 0; i < width * 4; i++) {
+            dst[i] = (srgb && (i & 3) != 3) ? tables.toLinear[src[i]] : src[i];
+        }
+    }, threads);
+    return result;
+}
+
+void fromFloat(const float* src, Image& image, bool srgb, unsigned threads) {
+    uint32_t width = image.width();
+    const SRGBTables& tables = srgbTables();
+    parallelFor(image.height(), [&](size_t y) {
+        const float* row = src + y * width * 4;
+        uint8_t* dst = reinterpret_cast<uint8_t*>(image.getDataPtr() + y * width);
+        for (uint32_t i = 0; i < width * 4; i++) {
+            if (srgb && (i & 3) != 3) {
+                dst[i] = static_cast<uint8_t>(std::upper_bound(tables.midpoints.begin(), tables.midpoints.end(), row[i]) - tables.midpoints.begin());
+            } else {
+                dst[i] = static_cast<uint8_t>(std::clamp(row[i] + 0.5f, 0.0f, 255.0f));
+            }
+        }
+    }, threads);
+}
+
+/**
+ * @brief Separable resampling of 4 float channels: source rows are filtered horizontally,
+ *        then the filtered rows are weighted into destination rows, both in parallel rows.
+ */
+void resample(const float* src, uint32_t srcWidth, uint32_t srcHeight, float* dst, uint32_t dstWidth, uint32_t dstHeight,
+              ResampleFilter filter, unsigned threads) {
+    Taps horizontal = createTaps(srcWidth, dstWidth, filter);
+    Taps vertical = createTaps(srcHeight, dstHeight, filter);
+    uint64_t rowSize = static_cast<uint64_t>(dstWidth) * 4;
+    std::vector<float> rows(rowSize * srcHeight);
+
+    parallelFor(srcHeight, [&](size_t y) {
+        const float* srcRow = src + y * srcWidth * 4;
+        float* row = rows.data() + y * rowSize;
+        for (uint32_t x = 0; x < dstWidth; x++) {
+            const uint32_t* indices = horizontal.indices.data() + static_cast<uint64_t>(x) * horizontal.count;
+            const float* weights = horizontal.weights.data() + static_cast<uint64_t>(x) * horizontal.count;
+#if defined(SHENDK_IMAGE_SSE2)
+            __m128 sum = _mm_setzero_ps();
+            for (uint32_t k = 0; k < horizontal.count; k++) {
+                sum = _mm_add_ps(sum, _mm_mul_ps(_mm_set1_ps(weights[k]), _mm_loadu_ps(srcRow + indices[k] * 4)));
+            }
+            _mm_storeu_ps(row + x * 4, sum);
+#else
+            float sum[4] = {};
+            for (uint32_t k = 0; k < horizontal.count; k++) {
+                for (int c = 0; c < 4; c++) {
+                    sum[c] += weights[k] * srcRow[indices[k] * 4 + c];
+                }
+            }
+            memcpy(row + x * 4, sum, sizeof(sum));
+#endif
+        }
+    }, threads);
+
+    parallelFor(dstHeight, [&](size_t y) {
+        float* dstRow = dst + y * rowSize;
+        std::fill(dstRow, dstRow + rowSize, 0.0f);
+        for (uint32_t k = 0; k < vertical.count; k++) {
+            float weight = vertical.weights[y * vertical.count + k];
+            if (weight == 0.0f) continue;
+            const float* row = rows.data() + vertical.indices[y * vertical.count + k] * rowSize;
+#if defined(SHENDK_IMAGE_SSE2)
+            __m128 weights = _mm_set1_ps(weight);
+            for (uint64_t i = 0; i < rowSize; i += 4) {
+                _mm_storeu_ps(dstRow + i, _mm_add_ps(_mm_loadu_ps(dstRow + i), _mm_mul_ps(weights, _mm_loadu_ps(row + i))));
+            }
+#else
+            for (uint64_t i = 0; i < rowSize; i++) {
+                dstRow[i] += weight * row[i];
+            }
+#endif
+        }
+    }, threads);
+}
+
+}
+
 BGRA& BGRA::operator+=(const BGRA& rhs) {
     r += rhs.r;
     g += rhs.g;
@@ -156,13 +362,47 @@ void Image::writeImage(Image& src, int srcX, int srcY, int dstX, int dstY, int w
     }
 }
 
-Image* Image::resize(uint32_t width, uint32_t height) {
+Image* Image::resize(uint32_t width, uint32_t height, const ResampleOptions& options) const {
     Image* resizedImage = new Image(width, height);
-
-    // TODO: implement
+    if (width == 0 || height == 0 || m_width == 0 || m_height == 0) {
+        return resizedImage;
+    }
+    unsigned threads = resampleThreads(static_cast<uint64_t>(m_width) * m_height, static_cast<uint64_t>(width) * height, options.threads);
+    std::vector<float> src = toFloat(m_rawData, m_width, m_height, options.srgb, threads);
+    std::vector<float> dst(static_cast<uint64_t>(width) * height * 4);
+    resample(src.data(), m_width, m_height, dst.data(), width, height, options.filter, threads);
+    fromFloat(dst.data(), *resizedImage, options.srgb, threads);
     return resizedImage;
 }
 
+std::vector<std::shared_ptr<Image>> Image::buildMipChain(const ResampleOptions& options) const {
+    std::vector<std::shared_ptr<Image>> result;
+    uint32_t width = m_width, height = m_height;
+    if (width == 0 || height == 0) {
+        return result;
+    }
+
+    // levels stay floats (linear light for sRGB) until they are stored
+    uint64_t pixels = static_cast<uint64_t>(width) * height;
+    std::vector<float> level = toFloat(m_rawData, width, height, options.srgb, resampleThreads(pixels, pixels, options.threads));
+    std::vector<float> next;
+    while (width > 1 || height > 1) {
+        uint32_t nextWidth = std::max(width >> 1, 1u);
+        uint32_t nextHeight = std::max(height >> 1, 1u);
+        uint64_t nextPixels = static_cast<uint64_t>(nextWidth) * nextHeight;
+        unsigned threads = resampleThreads(static_cast<uint64_t>(width) * height, nextPixels, options.threads);
+        next.resize(nextPixels * 4);
+        resample(level.data(), width, height, next.data(), nextWidth, nextHeight, options.filter, threads);
+        std::shared_ptr<Image> mipmap(new Image(nextWidth, nextHeight));
+        fromFloat(next.data(), *mipmap, options.srgb, threads);
+        result.push_back(mipmap);
+        level.swap(next);
+        width = nextWidth;
+        height = nextHeight;
+    }
+    return result;
+}
+
 std::vector<BGRA> Image::createBGRA8() {
     std::vector<BGRA> result(m_width * m_height);
     for (size_t i = 0; i < result.size(); i++) {
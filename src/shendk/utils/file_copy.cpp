@@ -0,0 +1,112 @@
+#include "shendk/utils/file_copy.h"
+
+#include <algorithm>
+#include <fstream>
+#include <vector>
+
+#if !defined(_WIN32)
+    #include <fcntl.h>
+    #include <unistd.h>
+    #include <sys/stat.h>
+#endif
+#if defined(__linux__)
+    #include <sys/sendfile.h>
+#endif
+
+namespace shendk {
+
+namespace {
+const uint64_t bufferSize = 1 << 20;
+
+// one buffer per thread, reused by every copy on that thread
+std::vector<char>& copyBuffer() {
+    thread_local std::vector<char> buffer(bufferSize);
+    return buffer;
+}
+}
+
+FileCopier::FileCopier(const std::string& source)
+    : m_source(source)
+{
+#if !defined(_WIN32)
+    m_fd = ::open(source.c_str(), O_RDONLY);
+#endif
+}
+
+FileCopier::~FileCopier() {
+#if !defined(_WIN32)
+    if (m_fd >= 0) ::close(m_fd);
+#endif
+}
+
+bool FileCopier::isOpen() const {
+#if defined(_WIN32)
+    return std::ifstream(m_source, std::ios::binary).is_open();
+#else
+    return m_fd >= 0;
+#endif
+}
+
+bool FileCopier::copy(uint64_t offset, uint64_t size, const std::string& destination) const {
+#if defined(_WIN32)
+    std::ifstream input(m_source, std::ios::binary);
+    std::ofstream output(destination, std::ios::binary);
+    if (!input.is_open() || !output.is_open()) return false;
+    input.seekg(offset, std::ios::beg);
+    std::vector<char>& buffer = copyBuffer();
+    while (size > 0 && input.good()) {
+        uint64_t chunk = std::min<uint64_t>(size, buffer.size());
+        input.read(buffer.data(), chunk);
+        output.write(buffer.data(), input.gcount());
+        size -= input.gcount();
+    }
+    return size == 0 && output.good();
+#else
+    if (m_fd < 0) return false;
+    int out = ::open(destination.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    if (out < 0) return false;
+
+    off_t position = static_cast<off_t>(offset);
+#if defined(__linux__)
+    // kernel side copy, may share extents on reflink capable file systems
+    while (size > 0) {
+        ssize_t copied = copy_file_range(m_fd, &position, out, nullptr, static_cast<size_t>(std::min(size, bufferSize << 4)), 0);
+        if (copied <= 0) break;
+        size -= static_cast<uint64_t>(copied);
+    }
+    // older kernels or cross file system copies
+    while (size > 0) {
+        ssize_t copied = sendfile(out, m_fd, &position, static_cast<size_t>(std::min(size, bufferSize << 4)));
+        if (copied <= 0) break;
+        size -= static_cast<uint64_t>(copied);
+    }
+#endif
+    if (size > 0) {
+        std::vector<char>& buffer = copyBuffer();
+        while (size > 0) {
+            ssize_t count = pread(m_fd, buffer.data(), static_cast<size_t>(std::min<uint64_t>(size, buffer.size())), position);
+            if (count <= 0) break;
+            ssize_t written = 0;
+            while (written < count) {
+                ssize_t result = ::write(out, buffer.data() + written, static_cast<size_t>(count - written));
+                if (result <= 0) break;
+                written += result;
+            }
+            if (written < count) break;
+            position += count;
+            size -= static_cast<uint64_t>(count);
+        }
+    }
+    bool success = ::close(out) == 0;
+    return success && size == 0;
+#endif
+}
+
+bool FileCopier::writeFile(const std::string& destination, MemoryView data) {
+    std::ofstream output(destination, std::ios::binary);
+    if (!output.is_open()) return false;
+    output.write(data.data, static_cast<std::streamsize>(data.size));
+    return output.good();
+}
+
+}
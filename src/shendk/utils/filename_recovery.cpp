@@ -0,0 +1,193 @@
+#include "shendk/utils/filename_recovery.h"
+
+#include <algorithm>
+#include <fstream>
+#include <mutex>
+
+#include "shendk/utils/hash_db.h"
+#include "shendk/utils/murmurhash2.h"
+#include "shendk/utils/parallel.h"
+
+namespace shendk {
+
+namespace {
+const uint64_t batchSize = 4096;
+}
+
+uint64_t FilenameRecovery::Segment::size() const {
+    if (words) return words->size();
+    if (rangeSize) return rangeSize;
+    return 1;
+}
+
+void FilenameRecovery::Segment::append(std::string& output, uint64_t index) const {
+    if (words) {
+        output += (*words)[index];
+    } else if (rangeSize) {
+        std::string number = std::to_string(rangeBegin + index);
+        if (number.size() < width) output.append(width - number.size(), '0');
+        output += number;
+    } else {
+        output += literal;
+    }
+}
+
+FilenameRecovery::FilenameRecovery(const TAD& tad, bool onlyUnknown)
+    : m_tad(tad)
+{
+    HashDB& db = HashDB::getInstance();
+    for (uint32_t i = 0; i < tad.entries.size(); i++) {
+        const TAD::Entry& entry = tad.entries[i];
+        if (onlyUnknown && !db.findFilepath(entry.hash1, entry.hash2).empty()) continue;
+        m_targets[entry.hash1].push_back(i);
+    }
+}
+
+void FilenameRecovery::addWordlist(const std::string& name, const std::vector<std::string>& words) {
+    m_wordlists[name] = words;
+}
+
+bool FilenameRecovery::loadWordlist(const std::string& name, const std::string& filepath) {
+    std::ifstream file(filepath);
+    if (!file.is_open()) return false;
+    std::vector<std::string> words;
+    std::string line;
+    while (std::getline(file, line)) {
+        if (!line.empty() && line.back() == '\r') line.pop_back();
+        if (!line.empty()) words.push_back(line);
+    }
+    addWordlist(name, words);
+    return true;
+}
+
+uint64_t FilenameRecovery::candidateCount(const std::string& pattern) const {
+    uint64_t count = 1;
+    for (auto& segment : parse(pattern)) {
+        uint64_t size = segment.size();
+        if (size && count > UINT64_MAX / size)
+            throw new std::runtime_error("Pattern expands to too many candidates: " + pattern + "\n");
+        count *= size;
+    }
+    return count;
+}
+
+std::vector<FilenameRecovery::Match> FilenameRecovery::search(const std::string& pattern, unsigned threads) const {
+    std::vector<Segment> segments = parse(pattern);
+    uint64_t count = candidateCount(pattern);
+
+    std::vector<Match> matches;
+    std::mutex matchMutex;
+    uint64_t batches = (count + batchSize - 1) / batchSize;
+    parallelFor(static_cast<size_t>(batches), [&](size_t batch) {
+        uint64_t begin = batch * batchSize;
+        size_t batchCount = static_cast<size_t>(std::min(batchSize, count - begin));
+
+        // decode the candidate index as a mixed radix number, last segment varies fastest
+        std::vector<std::string> candidates(batchCount);
+        std::vector<std::string_view> views(batchCount);
+        std::vector<uint64_t> digits(segments.size());
+        for (size_t i = 0; i < batchCount; i++) {
+            uint64_t index = begin + i;
+            for (size_t s = segments.size(); s-- > 0;) {
+                uint64_t size = segments[s].size();
+                digits[s] = index % size;
+                index /= size;
+            }
+            for (size_t s = 0; s < segments.size(); s++) {
+                segments[s].append(candidates[i], digits[s]);
+            }
+            views[i] = candidates[i];
+        }
+
+        std::vector<uint32_t> hashes(batchCount);
+        MurmurHash2::hashBatch(views.data(), batchCount, hashes.data(), toLower);
+
+        std::vector<Match> found;
+        check(views.data(), hashes.data(), batchCount, found);
+        if (!found.empty()) {
+            std::lock_guard<std::mutex> lock(matchMutex);
+            matches.insert(matches.end(), found.begin(), found.end());
+        }
+    }, threads);
+
+    std::sort(matches.begin(), matches.end(), [](const Match& a, const Match& b) {
+        return a.entryIndex < b.entryIndex;
+    });
+    return matches;
+}
+
+std::vector<FilenameRecovery::Match> FilenameRecovery::search(const std::vector<std::string>& candidates, unsigned threads) const {
+    std::vector<uint32_t> hashes = MurmurHash2::hashBatch(candidates, toLower, threads);
+    std::vector<std::string_view> views(candidates.begin(), candidates.end());
+    std::vector<Match> matches;
+    check(views.data(), hashes.data(), views.size(), matches);
+    std::sort(matches.begin(), matches.end(), [](const Match& a, const Match& b) {
+        return a.entryIndex < b.entryIndex;
+    });
+    return matches;
+}
+
+size_t FilenameRecovery::targetCount() const {
+    size_t count = 0;
+    for (auto& target : m_targets) count += target.second.size();
+    return count;
+}
+
+std::vector<FilenameRecovery::Segment> FilenameRecovery::parse(const std::string& pattern) const {
+    std::vector<Segment> segments;
+    size_t position = 0;
+    while (position < pattern.size()) {
+        size_t open = pattern.find('{', position);
+        if (open == std::string::npos) open = pattern.size();
+        if (open > position) {
+            Segment literal;
+            literal.literal = pattern.substr(position, open - position);
+            segments.push_back(literal);
+        }
+        if (open == pattern.size()) break;
+
+        size_t close = pattern.find('}', open);
+        if (close == std::string::npos)
+            throw new std::runtime_error("Unterminated placeholder in pattern: " + pattern + "\n");
+        std::string name = pattern.substr(open + 1, close - open - 1);
+        position = close + 1;
+
+        Segment segment;
+        size_t dash = name.find('-');
+        bool isRange = dash != std::string::npos && dash > 0 && dash + 1 < name.size()
+                && name.find_first_not_of("0123456789-") == std::string::npos;
+        if (isRange) {
+            uint64_t first = std::stoull(name.substr(0, dash));
+            uint64_t last = std::stoull(name.substr(dash + 1));
+            if (last < first)
+                throw new std::runtime_error("Invalid range in pattern: " + pattern + "\n");
+            segment.rangeBegin = first;
+            segment.rangeSize = last - first + 1;
+            segment.width = dash;
+        } else {
+            auto it = m_wordlists.find(name);
+            if (it == m_wordlists.end())
+                throw new std::runtime_error("Unknown wordlist in pattern: " + name + "\n");
+            segment.words = &it->second;
+        }
+        segments.push_back(segment);
+    }
+    return segments;
+}
+
+void FilenameRecovery::check(const std::string_view* candidates, const uint32_t* hashes, size_t count, std::vector<Match>& matches) const {
+    std::string buffer;
+    for (size_t i = 0; i < count; i++) {
+        auto it = m_targets.find(hashes[i]);
+        if (it == m_targets.end()) continue;
+
+        // hash1 hits are rare, the second hash is only reported since its scheme is not verified yet
+        uint32_t hash2 = MurmurHash2::hashFilenameSecond(candidates[i], hashes[i], toLower, buffer);
+        for (uint32_t entryIndex : it->second) {
+            const TAD::Entry& entry = m_tad.entries[entryIndex];
+            matches.push_back({ entryIndex, entry.hash1, entry.hash2, std::string(candidates[i]), entry.hash2 == hash2 });
+        }
+    }
+}
+
+}
@@ -0,0 +1,209 @@
+#include "shendk/utils/gzstream.h"
+
+#include <cstring>
+
+#include "shendk/files/container/gz_index.h"
+
+#if defined(_WIN32)
+    #define ZLIB_WINAPI
+#endif
+
+#include "zlib.h"
+
+
+gz_istreambuf::gz_istreambuf(std::istream& source, std::streamoff offset, size_t windowSize,
+                             const shendk::GZIndex* index)
+    : m_source(source)
+    , m_offset(offset < 0 ? static_cast<std::streamoff>(source.tellg()) : offset)
+    , m_context(shendk::ZStreamPool::acquireInflater())
+    , m_windowSize(windowSize)
+    , m_index(index)
+{
+    m_good = m_offset >= 0 && m_context;
+    if (m_good) {
+        // pooled windows keep their capacity between uses
+        if (m_context->input.size() < m_windowSize) m_context->input.resize(m_windowSize);
+        if (m_context->output.size() < m_windowSize) m_context->output.resize(m_windowSize);
+        m_good = restart();
+        m_restarts = 0;
+    }
+}
+
+gz_istreambuf::~gz_istreambuf() {}
+
+bool gz_istreambuf::isValid() const {
+    return m_good;
+}
+
+size_t gz_istreambuf::restarts() const {
+    return m_restarts;
+}
+
+gz_istreambuf::int_type gz_istreambuf::underflow() {
+    if (gptr() < egptr()) return traits_type::to_int_type(*gptr());
+    if (!fill()) return traits_type::eof();
+    return traits_type::to_int_type(*gptr());
+}
+
+gz_istreambuf::pos_type gz_istreambuf::seekoff(off_type off, std::ios_base::seekdir dir, std::ios_base::openmode mode) {
+    if (!(mode & std::ios_base::in) || !m_good) return pos_type(off_type(-1));
+    uint64_t current = m_windowPosition + static_cast<uint64_t>(gptr() - eback());
+    if (dir == std::ios_base::cur) {
+        if (off == 0) return pos_type(static_cast<off_type>(current));
+        return seekTo(current + off);
+    }
+    if (dir == std::ios_base::end) {
+        if (m_index) return seekTo(m_index->uncompressedSize + off);
+        // the decompressed size is only known after inflating everything
+        while (fill()) {}
+        if (!m_good) return pos_type(off_type(-1));
+        return seekTo(m_windowPosition + static_cast<uint64_t>(egptr() - eback()) + off);
+    }
+    return seekTo(static_cast<uint64_t>(off));
+}
+
+gz_istreambuf::pos_type gz_istreambuf::seekpos(pos_type pos, std::ios_base::openmode mode) {
+    if (!(mode & std::ios_base::in) || !m_good) return pos_type(off_type(-1));
+    return seekTo(static_cast<uint64_t>(off_type(pos)));
+}
+
+gz_istreambuf::pos_type gz_istreambuf::seekTo(uint64_t position) {
+    if (static_cast<int64_t>(position) < 0) return pos_type(off_type(-1));
+    uint64_t windowEnd = m_windowPosition + static_cast<uint64_t>(egptr() - eback());
+    if (position < m_windowPosition || position > windowEnd) {
+        if (!jump(position)) return pos_type(off_type(-1));
+    }
+    while (position > m_windowPosition + static_cast<uint64_t>(egptr() - eback())) {
+        if (!fill()) return pos_type(off_type(-1));
+    }
+    setg(eback(), eback() + (position - m_windowPosition), egptr());
+    return pos_type(static_cast<off_type>(position));
+}
+
+bool gz_istreambuf::restart() {
+    z_stream* stream = m_context.stream();
+    if (inflateReset2(stream, 16 + MAX_WBITS) != Z_OK) return false;
+    stream->next_in = nullptr;
+    stream->avail_in = 0;
+    m_source.clear();
+    m_source.seekg(m_offset, std::ios::beg);
+    m_windowPosition = 0;
+    m_end = false;
+    m_raw = false;
+    setg(m_context->output.data(), m_context->output.data(), m_context->output.data());
+    m_restarts++;
+    return m_source.good();
+}
+
+/**
+ * @brief Moves to the closest checkpoint before a position if that skips
+ *        inflating data, restarts if the position lies behind the current window.
+ */
+bool gz_istreambuf::jump(uint64_t position) {
+    const shendk::GZIndex::Checkpoint* checkpoint = m_index ? m_index->find(position) : nullptr;
+    uint64_t windowEnd = m_windowPosition + static_cast<uint64_t>(egptr() - eback());
+    if (!checkpoint || (position >= m_windowPosition && checkpoint->out <= windowEnd)) {
+        return position >= m_windowPosition || restart();
+    }
+
+    // resume raw inflating at the checkpoint's bit position with its window as dictionary
+    z_stream* stream = m_context.stream();
+    if (inflateReset2(stream, -MAX_WBITS) != Z_OK) return false;
+    stream->next_in = nullptr;
+    stream->avail_in = 0;
+    m_source.clear();
+    m_source.seekg(m_offset + static_cast<std::streamoff>(checkpoint->in - (checkpoint->bits ? 1 : 0)), std::ios::beg);
+    if (checkpoint->bits) {
+        int byte = m_source.get();
+        if (byte == std::char_traits<char>::eof()) return false;
+        inflatePrime(stream, checkpoint->bits, byte >> (8 - checkpoint->bits));
+    }
+    inflateSetDictionary(stream, checkpoint->window.data(), static_cast<uInt>(checkpoint->window.size()));
+    m_windowPosition = checkpoint->out;
+    m_end = false;
+    m_raw = true;
+    setg(m_context->output.data(), m_context->output.data(), m_context->output.data());
+    return m_source.good();
+}
+
+/**
+ * @brief Prepares inflating the next gzip member, returns false if none follows.
+ */
+bool gz_istreambuf::nextMember() {
+    z_stream* stream = m_context.stream();
+    auto refill = [&]() {
+        if (stream->avail_in > 0 || m_source.peek() == std::char_traits<char>::eof()) return;
+        m_source.read(m_context->input.data(), static_cast<std::streamsize>(m_windowSize));
+        stream->next_in = reinterpret_cast<Bytef*>(m_context->input.data());
+        stream->avail_in = static_cast<uInt>(m_source.gcount());
+    };
+
+    // raw deflate stops in front of the gzip trailer (crc and size)
+    if (m_raw) {
+        for (uInt skip = 8; skip > 0;) {
+            refill();
+            if (stream->avail_in == 0) return false;
+            uInt count = std::min(skip, stream->avail_in);
+            stream->next_in += count;
+            stream->avail_in -= count;
+            skip -= count;
+        }
+        m_raw = false;
+    }
+
+    refill();
+    if (stream->avail_in == 1) {
+        // keep the first byte of a header split across reads
+        char first = static_cast<char>(stream->next_in[0]);
+        m_context->input[0] = first;
+        m_source.read(m_context->input.data() + 1, static_cast<std::streamsize>(m_windowSize - 1));
+        stream->next_in = reinterpret_cast<Bytef*>(m_context->input.data());
+        stream->avail_in = static_cast<uInt>(1 + m_source.gcount());
+    }
+    if (stream->avail_in >= 2 && stream->next_in[0] == 0x1F && stream->next_in[1] == 0x8B) {
+        return inflateReset2(stream, 16 + MAX_WBITS) == Z_OK;
+    }
+    return false;
+}
+
+/**
+ * @brief Inflates the next window, returns false at the end of the data or on errors.
+ */
+bool gz_istreambuf::fill() {
+    char* output = m_context->output.data();
+    m_windowPosition += static_cast<uint64_t>(egptr() - eback());
+    setg(output, output, output);
+    if (m_end || !m_good) return false;
+
+    z_stream* stream = m_context.stream();
+    stream->next_out = reinterpret_cast<Bytef*>(output);
+    stream->avail_out = static_cast<uInt>(m_windowSize);
+    while (stream->avail_out > 0) {
+        if (stream->avail_in == 0) {
+            m_source.read(m_context->input.data(), static_cast<std::streamsize>(m_windowSize));
+            std::streamsize count = m_source.gcount();
+            if (count <= 0) {
+                m_end = true; // truncated data, hand out what was inflated
+                break;
+            }
+            stream->next_in = reinterpret_cast<Bytef*>(m_context->input.data());
+            stream->avail_in = static_cast<uInt>(count);
+        }
+
+        int err = inflate(stream, Z_NO_FLUSH);
+        if (err == Z_STREAM_END) {
+            // continue with the next gzip member if one follows
+            if (nextMember()) continue;
+            m_end = true;
+            break;
+        }
+        if (err != Z_OK && err != Z_BUF_ERROR) {
+            m_good = false;
+            break;
+        }
+    }
+
+    size_t produced = m_windowSize - stream->avail_out;
+    setg(output, output, output + produced);
+    return produced > 0;
+}
@@ -1,15 +1,205 @@
 #include "shendk/utils/hash_db.h"
 
+#include <algorithm>
+#include <cstring>
+#include <numeric>
+
 #include "json/json.h"
 #include "json/reader.h"
 
+#include "shendk/utils/mapped_file.h"
+
 namespace shendk {
 
+namespace {
+
+/*
+ * Compiled database layout:
+ *   Header
+ *   Record[recordCount]        sorted by (hash1, hash2)
+ *   uint32_t[slotCount]        (hash1, hash2) table, record index + 1 (0 = empty)
+ *   uint32_t[slotCount]        hash1 table, record index + 1 (0 = empty)
+ *   char[stringPoolSize]       null terminated paths
+ */
+struct Header {
+    uint32_t signature;
+    uint32_t version;
+    uint32_t recordCount;
+    uint32_t slotCount;
+    uint32_t stringPoolSize;
+    uint32_t reserved;
+};
+
+struct Record {
+    uint32_t hash1;
+    uint32_t hash2;
+    uint32_t pathOffset;
+    uint32_t pathLength;
+};
+
+inline uint32_t slotHash(uint32_t hash1, uint32_t hash2) {
+    uint32_t h = hash1 ^ (hash2 * 0x9E3779B1u);
+    h ^= h >> 16;
+    h *= 0x85EBCA6Bu;
+    h ^= h >> 13;
+    return h;
+}
+
+template<typename Match>
+inline uint32_t probe(const uint32_t* slots, uint32_t slotCount, uint32_t hash, Match match) {
+    uint32_t mask = slotCount - 1;
+    for (uint32_t i = hash & mask, n = 0; n < slotCount; i = (i + 1) & mask, n++) {
+        if (slots[i] == 0 || match(slots[i] - 1)) return slots[i];
+    }
+    return 0;
+}
+
+std::vector<char> buildDatabase(const std::vector<HashDB::Entry>& entries) {
+    // sort by key, ties keep their original order so the first entry wins
+    std::vector<uint32_t> order(entries.size());
+    std::iota(order.begin(), order.end(), 0);
+    std::stable_sort(order.begin(), order.end(), [&](uint32_t a, uint32_t b) {
+        if (entries[a].hash1 != entries[b].hash1) return entries[a].hash1 < entries[b].hash1;
+        return entries[a].hash2 < entries[b].hash2;
+    });
+
+    uint32_t slotCount = 16;
+    while (slotCount < entries.size() * 2) slotCount <<= 1;
+
+    uint64_t stringPoolSize = 0;
+    for (auto& entry : entries) stringPoolSize += entry.filepath.size() + 1;
+
+    uint64_t recordsOffset = sizeof(Header);
+    uint64_t pairSlotsOffset = recordsOffset + entries.size() * sizeof(Record);
+    uint64_t hash1SlotsOffset = pairSlotsOffset + slotCount * sizeof(uint32_t);
+    uint64_t stringsOffset = hash1SlotsOffset + slotCount * sizeof(uint32_t);
+    std::vector<char> buffer(stringsOffset + stringPoolSize, 0);
+
+    Header* header = reinterpret_cast<Header*>(buffer.data());
+    header->signature = HashDB::signature;
+    header->version = HashDB::version;
+    header->recordCount = static_cast<uint32_t>(entries.size());
+    header->slotCount = slotCount;
+    header->stringPoolSize = static_cast<uint32_t>(stringPoolSize);
+
+    Record* records = reinterpret_cast<Record*>(buffer.data() + recordsOffset);
+    uint32_t* pairSlots = reinterpret_cast<uint32_t*>(buffer.data() + pairSlotsOffset);
+    uint32_t* hash1Slots = reinterpret_cast<uint32_t*>(buffer.data() + hash1SlotsOffset);
+    char* strings = buffer.data() + stringsOffset;
+
+    std::vector<uint32_t> position(entries.size());
+    uint32_t stringOffset = 0;
+    for (uint32_t i = 0; i < order.size(); i++) {
+        const HashDB::Entry& entry = entries[order[i]];
+        records[i] = { entry.hash1, entry.hash2, stringOffset, static_cast<uint32_t>(entry.filepath.size()) };
+        std::memcpy(strings + stringOffset, entry.filepath.c_str(), entry.filepath.size() + 1);
+        stringOffset += static_cast<uint32_t>(entry.filepath.size() + 1);
+        position[order[i]] = i;
+    }
+
+    // fill both tables in original order, the first entry for a key wins
+    uint32_t mask = slotCount - 1;
+    for (uint32_t i = 0; i < entries.size(); i++) {
+        const Record& record = records[position[i]];
+        uint32_t slot = slotHash(record.hash1, record.hash2) & mask;
+        while (pairSlots[slot] && !(records[pairSlots[slot] - 1].hash1 == record.hash1 &&
+                                    records[pairSlots[slot] - 1].hash2 == record.hash2)) {
+            slot = (slot + 1) & mask;
+        }
+        if (!pairSlots[slot]) pairSlots[slot] = position[i] + 1;
+
+        slot = slotHash(record.hash1, 0) & mask;
+        while (hash1Slots[slot] && records[hash1Slots[slot] - 1].hash1 != record.hash1) {
+            slot = (slot + 1) & mask;
+        }
+        if (!hash1Slots[slot]) hash1Slots[slot] = position[i] + 1;
+    }
+    return buffer;
+}
+
+}
+
+struct HashDB::Index {
+    std::vector<char> storage;
+    MappedFile mapping;
+
+    const Record* records = nullptr;
+    const uint32_t* pairSlots = nullptr;
+    const uint32_t* hash1Slots = nullptr;
+    const char* strings = nullptr;
+    uint32_t recordCount = 0;
+    uint32_t slotCount = 0;
+
+    /**
+     * @brief Validates a compiled database and points the tables into it.
+     */
+    bool attach(const char* data, uint64_t size) {
+        if (size < sizeof(Header)) return false;
+        Header header;
+        std::memcpy(&header, data, sizeof(Header));
+        if (header.signature != HashDB::signature || header.version != HashDB::version) return false;
+        if (header.slotCount == 0 || (header.slotCount & (header.slotCount - 1)) != 0) return false;
+        uint64_t expected = sizeof(Header) + uint64_t(header.recordCount) * sizeof(Record)
+                          + uint64_t(header.slotCount) * sizeof(uint32_t) * 2 + header.stringPoolSize;
+        if (expected != size) return false;
+
+        recordCount = header.recordCount;
+        slotCount = header.slotCount;
+        records = reinterpret_cast<const Record*>(data + sizeof(Header));
+        pairSlots = reinterpret_cast<const uint32_t*>(records + recordCount);
+        hash1Slots = pairSlots + slotCount;
+        strings = reinterpret_cast<const char*>(hash1Slots + slotCount);
+        for (uint32_t i = 0; i < recordCount; i++) {
+            if (uint64_t(records[i].pathOffset) + records[i].pathLength >= header.stringPoolSize) return false;
+        }
+        for (uint32_t i = 0; i < slotCount * 2; i++) {
+            if (pairSlots[i] > recordCount) return false;
+        }
+        return true;
+    }
+
+    std::string_view find(uint32_t hash1, uint32_t hash2) const {
+        uint32_t result;
+        if (hash2 == 0) {
+            result = probe(hash1Slots, slotCount, slotHash(hash1, 0), [&](uint32_t i) {
+                return records[i].hash1 == hash1;
+            });
+        } else {
+            result = probe(pairSlots, slotCount, slotHash(hash1, hash2), [&](uint32_t i) {
+                return records[i].hash1 == hash1 && records[i].hash2 == hash2;
+            });
+        }
+        if (result == 0) return std::string_view();
+        const Record& record = records[result - 1];
+        return std::string_view(strings + record.pathOffset, record.pathLength);
+    }
+};
+
 HashDB::HashDB()
-    : m_initialized(false)
+    : m_index(nullptr)
 {}
 
+HashDB::~HashDB() {}
+
 bool HashDB::initialize(const std::string& filepath) {
+    uint32_t fileSignature = 0;
+    {
+        std::ifstream file(filepath, std::ifstream::binary);
+        if (!file.is_open()) return false;
+        file.read(reinterpret_cast<char*>(&fileSignature), sizeof(uint32_t));
+    }
+
+    // compiled database, used in place through a mapping
+    if (fileSignature == HashDB::signature) {
+        std::unique_ptr<Index> index(new Index);
+        if (!index->mapping.open(filepath) || !index->attach(index->mapping.data(), index->mapping.size())) {
+            std::cout << "Hash database is not a valid compiled database: " << filepath << std::endl;
+            return false;
+        }
+        publish(std::move(index));
+        return true;
+    }
+
     Json::Value node;
     Json::Reader reader;
     std::ifstream file(filepath, std::ifstream::binary);
@@ -19,37 +209,70 @@ bool HashDB::initialize(const std::string& filepath) {
                   << reader.getFormattedErrorMessages() << std::endl;
         return false;
     }
-    std::lock_guard lock(m_mutex);
-    m_entries.empty();
+    std::vector<HashDB::Entry> entries;
+    entries.reserve(node.size());
     for (auto& entry : node) {
         HashDB::Entry newEntry;
         newEntry.hash1 = entry["Hash"].asUInt();
         newEntry.hash2 = entry["HashPath"].asUInt();
         newEntry.filepath = entry["Path"].asString();
-        m_entries.push_back(newEntry);
+        entries.push_back(newEntry);
     }
-    m_initialized = true;
+    return initialize(entries);
+}
+
+bool HashDB::initialize(const std::vector<HashDB::Entry>& entries) {
+    std::unique_ptr<Index> index(new Index);
+    index->storage = buildDatabase(entries);
+    if (!index->attach(index->storage.data(), index->storage.size())) return false;
+    publish(std::move(index));
     return true;
 }
 
-std::string HashDB::getFilepath(uint32_t hash1, uint32_t hash2) {
-    if (!m_initialized) return "";
-    if (hash2 == 0) {
-        std::lock_guard lock(m_mutex);
-        for (auto& entry : m_entries) {
-            if (entry.hash1 == hash1) {
-                return entry.filepath;
-            }
-        }
+bool HashDB::compile(const std::string& filepath) const {
+    const Index* index = m_index.load(std::memory_order_acquire);
+    if (!index) return false;
+    std::vector<char> buffer;
+    if (!index->storage.empty()) {
+        buffer = index->storage;
     } else {
-        std::lock_guard lock(m_mutex);
-        for (auto& entry : m_entries) {
-            if (entry.hash1 == hash1 && entry.hash2 == hash2) {
-                return entry.filepath;
-            }
+        // rebuild from a mapped database
+        std::vector<HashDB::Entry> entries(index->recordCount);
+        for (uint32_t i = 0; i < index->recordCount; i++) {
+            const Record& record = index->records[i];
+            entries[i] = { record.hash1, record.hash2, std::string(index->strings + record.pathOffset, record.pathLength) };
         }
+        buffer = buildDatabase(entries);
     }
-    return "";
+    std::ofstream file(filepath, std::ios::binary);
+    if (!file.is_open()) return false;
+    file.write(buffer.data(), buffer.size());
+    return file.good();
+}
+
+std::string HashDB::getFilepath(uint32_t hash1, uint32_t hash2) const {
+    return std::string(findFilepath(hash1, hash2));
+}
+
+std::string_view HashDB::findFilepath(uint32_t hash1, uint32_t hash2) const {
+    const Index* index = m_index.load(std::memory_order_acquire);
+    if (!index) return std::string_view();
+    return index->find(hash1, hash2);
+}
+
+size_t HashDB::size() const {
+    const Index* index = m_index.load(std::memory_order_acquire);
+    return index ? index->recordCount : 0;
+}
+
+bool HashDB::isInitialized() const {
+    return m_index.load(std::memory_order_acquire) != nullptr;
+}
+
+void HashDB::publish(std::unique_ptr<Index> index) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_index.store(index.get(), std::memory_order_release);
+    m_indices.push_back(std::move(index));
 }
 
 }
@@ -0,0 +1,89 @@
+#include "shendk/utils/mapped_file.h"
+
+#if defined(_WIN32)
+    #define WIN32_LEAN_AND_MEAN
+    #include <windows.h>
+#else
+    #include <fcntl.h>
+    #include <unistd.h>
+    #include <sys/mman.h>
+    #include <sys/stat.h>
+#endif
+
+namespace shendk {
+
+MappedFile::MappedFile() = default;
+MappedFile::MappedFile(const std::string& filepath) { open(filepath); }
+MappedFile::~MappedFile() { close(); }
+
+bool MappedFile::open(const std::string& filepath) {
+    close();
+#if defined(_WIN32)
+    HANDLE file = CreateFileA(filepath.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr,
+                              OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+    if (file == INVALID_HANDLE_VALUE) return false;
+
+    LARGE_INTEGER fileSize;
+    if (!GetFileSizeEx(file, &fileSize) || fileSize.QuadPart == 0) {
+        CloseHandle(file);
+        return false;
+    }
+
+    HANDLE mapping = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+    if (mapping == nullptr) {
+        CloseHandle(file);
+        return false;
+    }
+
+    void* data = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+    if (data == nullptr) {
+        CloseHandle(mapping);
+        CloseHandle(file);
+        return false;
+    }
+
+    m_file = file;
+    m_mapping = mapping;
+    m_data = static_cast<const char*>(data);
+    m_size = static_cast<uint64_t>(fileSize.QuadPart);
+#else
+    int fd = ::open(filepath.c_str(), O_RDONLY);
+    if (fd < 0) return false;
+
+    struct stat fileStat;
+    if (fstat(fd, &fileStat) != 0 || fileStat.st_size == 0) {
+        ::close(fd);
+        return false;
+    }
+
+    void* data = mmap(nullptr, static_cast<size_t>(fileStat.st_size), PROT_READ, MAP_PRIVATE, fd, 0);
+    ::close(fd); // the mapping keeps its own reference to the file
+    if (data == MAP_FAILED) return false;
+
+    m_data = static_cast<const char*>(data);
+    m_size = static_cast<uint64_t>(fileStat.st_size);
+#endif
+    return true;
+}
+
+void MappedFile::close() {
+    if (!m_data) return;
+#if defined(_WIN32)
+    UnmapViewOfFile(m_data);
+    CloseHandle(m_mapping);
+    CloseHandle(m_file);
+    m_mapping = nullptr;
+    m_file = nullptr;
+#else
+    munmap(const_cast<char*>(m_data), static_cast<size_t>(m_size));
+#endif
+    m_data = nullptr;
+    m_size = 0;
+}
+
+bool MappedFile::isOpen() const { return m_data != nullptr; }
+const char* MappedFile::data() const { return m_data; }
+uint64_t MappedFile::size() const { return m_size; }
+MemoryView MappedFile::view() const { return MemoryView(m_data, m_size); }
+
+}
@@ -2,8 +2,28 @@
 
 #include <algorithm>
 
+#include "shendk/utils/parallel.h"
+
 namespace shendk {
 
+namespace {
+const size_t lanes = 8;
+const size_t batchSize = 4096;
+
+/**
+ * @brief Loads up to 4 bytes as a little endian word, zero padded.
+ */
+inline uint32_t loadWord(const char* data, size_t length, bool toLower) {
+    uint32_t word = 0;
+    for (size_t i = 0; i < length; i++) {
+        uint8_t c = static_cast<uint8_t>(data[i]);
+        if (toLower && static_cast<uint8_t>(c - 'A') < 26) c += 32;
+        word |= static_cast<uint32_t>(c) << (i * 8);
+    }
+    return word;
+}
+}
+
 uint32_t MurmurHash2::hashData(const uint8_t* data, uint32_t length) {
     uint32_t hash = (length / 0xFFFFFFFF + length) ^ m_initializationSeed;
     uint32_t m = m_multiplier;
@@ -23,7 +43,7 @@ uint32_t MurmurHash2::hashData(const uint8_t* data, uint32_t length) {
 
     if (lengthRemaining > 0)
     {
-        uint8_t buffer[4];
+        uint8_t buffer[4] = { 0, 0, 0, 0 };
         if (lengthRemaining == 1)
         {
             buffer[0] = data[length - 1];
@@ -57,4 +77,74 @@ uint32_t MurmurHash2::hashFilenamePlain(std::string filename, bool toLower) {
     return hash;
 }
 
+uint32_t MurmurHash2::hashFilenameSecond(std::string_view filename, uint32_t firstHash, bool toLower, std::string& buffer) {
+    static const char digits[] = "0123456789abcdef";
+    buffer.assign(filename.data(), filename.size());
+    for (int shift = 28; shift >= 0; shift -= 4) {
+        buffer += digits[(firstHash >> shift) & 0xF];
+    }
+    std::string_view view(buffer);
+    uint32_t hash;
+    hashBatch(&view, 1, &hash, toLower);
+    return hash;
+}
+
+void MurmurHash2::hashBatch(const std::string_view* inputs, size_t count, uint32_t* hashes, bool toLower) {
+    const uint32_t m = m_multiplier;
+    const int r = m_rotationAmount;
+
+    for (size_t base = 0; base < count; base += lanes) {
+        size_t laneCount = std::min(lanes, count - base);
+        uint32_t hash[lanes] = {};
+        uint32_t blocks[lanes] = {};
+        uint32_t steps[lanes] = {};
+        uint32_t maxSteps = 0;
+        for (size_t j = 0; j < laneCount; j++) {
+            uint32_t length = static_cast<uint32_t>(inputs[base + j].size());
+            hash[j] = (length / 0xFFFFFFFF + length) ^ m_initializationSeed;
+            blocks[j] = length / 4;
+            steps[j] = blocks[j] + (length % 4 ? 1 : 0);
+            maxSteps = std::max(maxSteps, steps[j]);
+        }
+
+        for (uint32_t step = 0; step < maxSteps; step++) {
+            // gather one word per lane (block or zero padded tail)
+            uint32_t word[lanes] = {};
+            for (size_t j = 0; j < laneCount; j++) {
+                if (step >= steps[j]) continue;
+                size_t offset = static_cast<size_t>(step) * 4;
+                word[j] = loadWord(inputs[base + j].data() + offset,
+                                   std::min<size_t>(4, inputs[base + j].size() - offset), toLower);
+            }
+            // mix all lanes
+            for (size_t j = 0; j < lanes; j++) {
+                uint32_t k = word[j] * m;
+                uint32_t blockHash = hash[j] * m ^ (k >> r ^ k) * m;
+                uint32_t tailHash = (hash[j] ^ word[j]) * m;
+                hash[j] = step < blocks[j] ? blockHash : (step < steps[j] ? tailHash : hash[j]);
+            }
+        }
+
+        for (size_t j = 0; j < lanes; j++) {
+            uint32_t edx = (hash[j] >> 0x0D ^ hash[j]) * m;
+            hash[j] = edx >> 0x0F ^ edx;
+        }
+        for (size_t j = 0; j < laneCount; j++) {
+            hashes[base + j] = hash[j];
+        }
+    }
+}
+
+std::vector<uint32_t> MurmurHash2::hashBatch(const std::vector<std::string>& inputs, bool toLower, unsigned threads) {
+    std::vector<uint32_t> hashes(inputs.size());
+    size_t batches = (inputs.size() + batchSize - 1) / batchSize;
+    parallelFor(batches, [&](size_t batch) {
+        size_t begin = batch * batchSize;
+        size_t count = std::min(batchSize, inputs.size() - begin);
+        std::vector<std::string_view> views(inputs.begin() + begin, inputs.begin() + begin + count);
+        hashBatch(views.data(), count, hashes.data() + begin, toLower);
+    }, threads);
+    return hashes;
+}
+
 }
@@ -0,0 +1,114 @@
+#include "shendk/utils/zstream_pool.h"
+
+#include <cstring>
+
+#if defined(_WIN32)
+    #define ZLIB_WINAPI
+#endif
+
+#include "zlib.h"
+
+#include "shendk/utils/parallel.h"
+
+namespace shendk {
+
+namespace {
+// enough for an inflater and a deflater per core
+const size_t maxPooledContexts = std::max<size_t>(8, workerCount() * 2);
+}
+
+ZStreamPool::Context::Context(bool _deflate, int _level, int _strategy)
+    : stream(new z_stream)
+    , deflate(_deflate)
+    , level(_level)
+    , strategy(_strategy)
+{
+    std::memset(stream.get(), 0, sizeof(z_stream));
+    if (deflate) {
+        valid = deflateInit2(stream.get(), level, Z_DEFLATED, 16 + MAX_WBITS, 8, strategy) == Z_OK;
+    } else {
+        valid = inflateInit2(stream.get(), 16 + MAX_WBITS) == Z_OK;
+    }
+}
+
+ZStreamPool::Context::~Context() {
+    if (!valid) return;
+    if (deflate) {
+        deflateEnd(stream.get());
+    } else {
+        inflateEnd(stream.get());
+    }
+}
+
+ZStreamPool::Lease::Lease(std::unique_ptr<Context> context)
+    : m_context(std::move(context))
+{}
+
+ZStreamPool::Lease& ZStreamPool::Lease::operator=(Lease&& other) {
+    if (this != &other) {
+        Lease released(std::move(*this)); // returns the current context
+        m_context = std::move(other.m_context);
+    }
+    return *this;
+}
+
+ZStreamPool::Lease::~Lease() {
+    if (!m_context || !m_context->valid) return;
+    std::lock_guard<std::mutex> lock(mutex());
+    auto& pool = contexts();
+    if (pool.size() < maxPooledContexts) {
+        pool.push_back(std::move(m_context));
+    }
+}
+
+ZStreamPool::Lease ZStreamPool::acquireInflater() {
+    std::unique_ptr<Context> context;
+    {
+        std::lock_guard<std::mutex> lock(mutex());
+        auto& pool = contexts();
+        for (size_t i = pool.size(); i-- > 0;) {
+            if (pool[i]->deflate) continue;
+            context = std::move(pool[i]);
+            pool.erase(pool.begin() + i);
+            break;
+        }
+    }
+    if (!context) {
+        return Lease(std::unique_ptr<Context>(new Context(false, 0, 0)));
+    }
+    context->stream->next_in = nullptr;
+    context->stream->avail_in = 0;
+    inflateReset2(context->stream.get(), 16 + MAX_WBITS); // may have been switched to raw deflate
+    return Lease(std::move(context));
+}
+
+ZStreamPool::Lease ZStreamPool::acquireDeflater(int level, int strategy) {
+    std::unique_ptr<Context> context;
+    {
+        std::lock_guard<std::mutex> lock(mutex());
+        auto& pool = contexts();
+        for (size_t i = pool.size(); i-- > 0;) {
+            if (!pool[i]->deflate || pool[i]->level != level || pool[i]->strategy != strategy) continue;
+            context = std::move(pool[i]);
+            pool.erase(pool.begin() + i);
+            break;
+        }
+    }
+    if (!context) {
+        return Lease(std::unique_ptr<Context>(new Context(true, level, strategy)));
+    }
+    deflateReset(context->stream.get());
+    return Lease(std::move(context));
+}
+
+std::vector<std::unique_ptr<ZStreamPool::Context>>& ZStreamPool::contexts() {
+    static std::vector<std::unique_ptr<Context>> pool;
+    return pool;
+}
+
+std::mutex& ZStreamPool::mutex() {
+    static std::mutex poolMutex;
+    return poolMutex;
+}
+
+}
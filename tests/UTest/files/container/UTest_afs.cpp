@@ -1,6 +1,9 @@
 #include "gtest/gtest.h"
 
+#include <sstream>
+
 #include "shendk/files/container/afs.h"
+#include "shendk/files/container/afs_builder.h"
 #include "shendk/files/container/idx.h"
 
 namespace {
@@ -26,4 +29,116 @@ TEST(AFS, read_write)
     SUCCEED();
 }
 
+TEST(AFS, index_only)
+{
+    std::string filepath = (fs::temp_directory_path() / "shendk_index_only.afs").string();
+
+    shendk::AFS afs;
+    afs.header.signature = shendk::AFS::signature;
+    for (int i = 0; i < 3; i++) {
+        shendk::AFS::MetaEntry meta = {};
+        shendk::AFS::Entry entry(shendk::AFS::OffsetEntry(), meta);
+        std::vector<char> data(100 + i, static_cast<char>('a' + i));
+        entry.setData(data);
+        afs.entries.push_back(entry);
+    }
+    afs.write(filepath);
+
+    shendk::AFS lazy(filepath, shendk::AFS::ReadMode::IndexOnly);
+    ASSERT_EQ(lazy.entries.size(), 3);
+    for (int i = 0; i < 3; i++) {
+        EXPECT_FALSE(lazy.entries[i].isLoaded());
+        EXPECT_EQ(lazy.entries[i].offset.fileSize, 100 + i);
+    }
+
+    shendk::MemoryView view = lazy.getEntryView(1);
+    EXPECT_TRUE(lazy.entries[1].isLoaded());
+    EXPECT_FALSE(lazy.entries[2].isLoaded());
+    ASSERT_EQ(view.size, 101);
+    EXPECT_EQ(view.data[100], 'b');
+
+    // skipped entries are loaded before the source file is overwritten
+    lazy.write(filepath);
+    shendk::AFS rewritten(filepath);
+    ASSERT_EQ(rewritten.entries.size(), 3);
+    for (int i = 0; i < 3; i++) {
+        std::vector<char> data = rewritten.entries[i].getData();
+        EXPECT_EQ(data, std::vector<char>(100 + i, static_cast<char>('a' + i)));
+    }
+
+    // entries without meta data write zeroed meta entries
+    shendk::AFS::Entry bare(shendk::AFS::OffsetEntry{});
+    EXPECT_EQ(bare.meta.fileSize, 0u);
+    EXPECT_EQ(bare.meta.filename[0], 0);
+
+    fs::remove(filepath);
+}
+
+TEST(AFS, builder)
+{
+    std::string sourcePath = (fs::temp_directory_path() / "shendk_builder.bin").string();
+    std::string filepath = (fs::temp_directory_path() / "shendk_builder.afs").string();
+    std::string rebuildPath = (fs::temp_directory_path() / "shendk_rebuild.afs").string();
+    {
+        std::ofstream source(sourcePath, std::ios::binary);
+        source << std::string(5000, 'x');
+    }
+
+    shendk::AFSBuilder builder;
+    builder.addFile(sourcePath);
+    builder.addStream("STREAM.BIN", 3, []() -> std::unique_ptr<std::istream> {
+        return std::unique_ptr<std::istream>(new std::istringstream("abc"));
+    });
+    builder.build(filepath);
+
+    shendk::AFS afs(filepath, shendk::AFS::ReadMode::IndexOnly);
+    ASSERT_EQ(afs.entries.size(), 2);
+    EXPECT_EQ(std::string(afs.entries[0].meta.filename), "shendk_builder.bin");
+    EXPECT_EQ(afs.entries[0].offset.fileSize, 5000);
+    EXPECT_EQ(afs.entries[1].offset.fileOffset % 0x800, 0);
+    EXPECT_EQ(std::string(afs.getEntryView(1).data, 3), "abc");
+
+    // rebuild from an archive that was only indexed
+    shendk::AFSBuilder rebuilder;
+    rebuilder.addEntries(afs);
+    rebuilder.build(rebuildPath);
+    EXPECT_EQ(fs::file_size(rebuildPath), fs::file_size(filepath));
+
+    shendk::AFS rebuilt(rebuildPath);
+    ASSERT_EQ(rebuilt.entries.size(), 2);
+    EXPECT_EQ(rebuilt.entries[0].getData(), std::vector<char>(5000, 'x'));
+
+    fs::remove(sourcePath);
+    fs::remove(filepath);
+    fs::remove(rebuildPath);
+}
+
+TEST(AFS, unpack)
+{
+    std::string filepath = (fs::temp_directory_path() / "shendk_unpack.afs").string();
+    std::string folder = (fs::temp_directory_path() / "shendk_unpack").string();
+
+    shendk::AFSBuilder builder;
+    for (int i = 0; i < 8; i++) {
+        std::string content(1000 * (i + 1), static_cast<char>('a' + i));
+        builder.addStream("FILE" + std::to_string(i) + ".BIN", static_cast<uint32_t>(content.size()), [content]() -> std::unique_ptr<std::istream> {
+            return std::unique_ptr<std::istream>(new std::istringstream(content));
+        });
+    }
+    builder.build(filepath);
+
+    shendk::IDX idx;
+    idx.entries = { "IDXNAME0" };
+
+    shendk::AFS afs(filepath, shendk::AFS::ReadMode::IndexOnly);
+    shendk::AFS::UnpackStats stats = afs.unpack(folder, &idx, 4);
+    EXPECT_EQ(stats.files, 8);
+    EXPECT_EQ(stats.bytes, 36000);
+    EXPECT_EQ(fs::file_size(fs::path(folder) / "IDXNAME0"), 1000);
+    EXPECT_EQ(fs::file_size(fs::path(folder) / "FILE7.BIN"), 8000);
+
+    fs::remove_all(folder);
+    fs::remove(filepath);
+}
+
 }
@@ -1,11 +1,33 @@
 #include "gtest/gtest.h"
 
+#include <chrono>
 #include <iostream>
+#include <thread>
 
 #include "shendk/files/container/gz.h"
+#include "shendk/files/container/gz_index.h"
+#include "shendk/files/container/pks.h"
+#include "shendk/utils/gzstream.h"
+#include "shendk/utils/memstream.h"
+#include "shendk/utils/zstream_pool.h"
+#include "zlib.h"
 
 namespace {
 
+std::string gzipCompress(const std::string& data) {
+    z_stream stream = {};
+    deflateInit2(&stream, Z_DEFAULT_COMPRESSION, Z_DEFLATED, 16 + MAX_WBITS, 8, Z_DEFAULT_STRATEGY);
+    std::string output(deflateBound(&stream, data.size()), '\0');
+    stream.next_in = reinterpret_cast<Bytef*>(const_cast<char*>(data.data()));
+    stream.avail_in = static_cast<uInt>(data.size());
+    stream.next_out = reinterpret_cast<Bytef*>(&output[0]);
+    stream.avail_out = static_cast<uInt>(output.size());
+    deflate(&stream, Z_FINISH);
+    output.resize(stream.total_out);
+    deflateEnd(&stream);
+    return output;
+}
+
 TEST(GZ, read_write)
 {
     std::ifstream file("H:\\UTest\\gzip.gz", std::ios::binary);
@@ -23,4 +45,219 @@ TEST(GZ, read_write)
     SUCCEED();
 }
 
+TEST(GZ, stream)
+{
+    std::string data;
+    for (int i = 0; i < 100000; i++) {
+        data += std::to_string(i);
+    }
+    std::stringstream compressed("PREFIX" + gzipCompress(data));
+    compressed.seekg(6);
+    ASSERT_TRUE(shendk::GZ::testGzip(compressed));
+    EXPECT_EQ(compressed.tellg(), 6);
+
+    igzstream stream(compressed, -1, 4096);
+    ASSERT_TRUE(stream.good());
+    std::string head(10, '\0');
+    stream.read(&head[0], 10);
+    EXPECT_EQ(head, data.substr(0, 10));
+
+    stream.seekg(300000, std::ios::beg);
+    std::string middle(10, '\0');
+    stream.read(&middle[0], 10);
+    EXPECT_EQ(middle, data.substr(300000, 10));
+    EXPECT_EQ(stream.restarts(), 0);
+
+    stream.seekg(5, std::ios::beg);
+    stream.read(&head[0], 10);
+    EXPECT_EQ(head, data.substr(5, 10));
+    EXPECT_EQ(stream.restarts(), 1);
+
+    stream.seekg(0, std::ios::end);
+    EXPECT_EQ(static_cast<size_t>(stream.tellg()), data.size());
+
+    compressed.clear();
+    compressed.seekg(6);
+    uint64_t bufferSize = 0;
+    std::unique_ptr<char[]> buffer(shendk::GZ::inflateStream(compressed, bufferSize));
+    ASSERT_TRUE(buffer != nullptr);
+    EXPECT_EQ(std::string(buffer.get(), bufferSize), data);
+}
+
+TEST(GZ, compressed_pks)
+{
+    shendk::PKS pks;
+    pks.header.signature = shendk::PKS::signature;
+    pks.ipac.header.signature = shendk::IPAC::signature;
+    for (int i = 0; i < 3; i++) {
+        shendk::IPAC::EntryMeta meta = {};
+        shendk::IPAC::Entry entry(meta);
+        std::vector<char> entryData(1000 * (i + 1), static_cast<char>('a' + i));
+        entry.setData(entryData);
+        pks.ipac.entries.push_back(entry);
+    }
+    omstream plain;
+    pks.write(plain);
+    size_t plainSize = 0;
+    char* plainData = plain.getBuffer(plainSize);
+
+    std::stringstream compressed("PREFIX" + gzipCompress(std::string(plainData, plainSize)));
+    compressed.seekg(6);
+    shendk::PKS read(compressed);
+    ASSERT_EQ(read.ipac.entries.size(), 3);
+    EXPECT_EQ(read.ipac.entries[2].getData(), std::vector<char>(3000, 'c'));
+}
+
+TEST(GZ, parallel_deflate)
+{
+    shendk::GZ gz;
+    for (int i = 0; i < 200000; i++) {
+        std::string number = std::to_string(i * 7);
+        gz.data.insert(gz.data.end(), number.begin(), number.end());
+    }
+    gz.options.blockSize = 64 * 1024;
+    gz.options.threads = 4;
+
+    omstream compressed;
+    gz.write(compressed);
+    size_t compressedSize = 0;
+    char* compressedData = compressed.getBuffer(compressedSize);
+    EXPECT_LT(compressedSize, gz.data.size());
+
+    shendk::GZ read;
+    read.read(compressedData, compressedSize);
+    EXPECT_EQ(read.data, gz.data);
+
+    // compressed PKS round trip
+    shendk::PKS pks;
+    pks.header.signature = shendk::PKS::signature;
+    pks.ipac.header.signature = shendk::IPAC::signature;
+    shendk::IPAC::Entry entry(shendk::IPAC::EntryMeta{});
+    entry.setData(gz.data);
+    pks.ipac.entries.push_back(entry);
+    pks.Compressed = true;
+    pks.compression.blockSize = 64 * 1024;
+
+    omstream pksStream;
+    pks.write(pksStream);
+    size_t pksSize = 0;
+    char* pksData = pksStream.getBuffer(pksSize);
+    shendk::PKS readPks;
+    readPks.read(pksData, pksSize);
+    EXPECT_TRUE(readPks.Compressed);
+    ASSERT_EQ(readPks.ipac.entries.size(), 1);
+    EXPECT_EQ(readPks.ipac.entries[0].getData(), gz.data);
+}
+
+TEST(GZ, inflate_batch)
+{
+    std::vector<std::string> plain;
+    std::vector<std::string> compressed;
+    for (int i = 0; i < 32; i++) {
+        plain.push_back(std::string(1000 * i, static_cast<char>('a' + i % 26)) + std::to_string(i));
+        compressed.push_back(gzipCompress(plain.back()));
+    }
+    compressed.push_back("not gzip data");
+
+    std::vector<shendk::MemoryView> payloads;
+    for (auto& data : compressed) {
+        payloads.push_back(shendk::MemoryView(data.data(), data.size()));
+    }
+    std::vector<std::vector<char>> outputs = shendk::GZ::inflateBatch(payloads, 4);
+    ASSERT_EQ(outputs.size(), 33);
+    for (int i = 0; i < 32; i++) {
+        EXPECT_EQ(std::string(outputs[i].begin(), outputs[i].end()), plain[i]);
+    }
+    EXPECT_TRUE(outputs[32].empty());
+
+    // contexts are reused on the same thread
+    shendk::ZStreamPool::Context* context;
+    {
+        shendk::ZStreamPool::Lease lease = shendk::ZStreamPool::acquireInflater();
+        context = lease.get();
+    }
+    shendk::ZStreamPool::Lease lease = shendk::ZStreamPool::acquireInflater();
+    EXPECT_EQ(lease.get(), context);
+
+    // and outlive the threads that released them
+    lease = shendk::ZStreamPool::Lease();
+    std::thread([&]() {
+        shendk::ZStreamPool::Lease workerLease = shendk::ZStreamPool::acquireInflater();
+        context = workerLease.get();
+    }).join();
+    lease = shendk::ZStreamPool::acquireInflater();
+    EXPECT_EQ(lease.get(), context);
+}
+
+TEST(GZ, index)
+{
+    std::string data;
+    uint32_t seed = 1;
+    while (data.size() < 2000000) {
+        seed = seed * 1103515245 + 12345;
+        data += std::to_string(seed % 100000) + " ";
+    }
+
+    // single member and multi member (parallel deflate) data
+    shendk::GZ::Options options;
+    options.blockSize = 256 * 1024;
+    omstream multi;
+    shendk::GZ::deflateStream(data.data(), data.size(), multi, options);
+    size_t multiSize = 0;
+    char* multiData = multi.getBuffer(multiSize);
+    // trailing padding after the gzip data is not consumed by inflate
+    std::vector<std::string> variants = { gzipCompress(data), std::string(multiData, multiSize),
+                                          gzipCompress(data) + std::string(16, '\0') };
+
+    for (auto& compressed : variants) {
+        std::string filepath = (fs::temp_directory_path() / "shendk_index.gz").string();
+        std::ofstream(filepath, std::ios::binary).write(compressed.data(), compressed.size());
+        fs::remove(filepath + ".gzi");
+
+        shendk::GZIndex index;
+        ASSERT_TRUE(index.loadOrBuild(filepath, 64 * 1024));
+        EXPECT_TRUE(fs::exists(filepath + ".gzi"));
+        EXPECT_EQ(index.uncompressedSize, data.size());
+        EXPECT_GT(index.checkpoints.size(), 10);
+        EXPECT_EQ(index.sourceSize, compressed.size());
+
+        // a valid cache is used as it is, not rebuilt and rewritten
+        auto cacheTime = fs::last_write_time(filepath + ".gzi") - std::chrono::hours(1);
+        fs::last_write_time(filepath + ".gzi", cacheTime);
+        shendk::GZIndex cached;
+        ASSERT_TRUE(cached.loadOrBuild(filepath, 64 * 1024));
+        EXPECT_TRUE(fs::last_write_time(filepath + ".gzi") == cacheTime);
+        ASSERT_EQ(cached.checkpoints.size(), index.checkpoints.size());
+        EXPECT_EQ(cached.checkpoints.back().out, index.checkpoints.back().out);
+
+        std::stringstream source("PREFIX" + compressed);
+        igzstream stream(source, 6, 1 << 16, &cached);
+        uint64_t offsets[] = { 1500000, 20, 999999, 1999000, 300000, 0, data.size() - 10 };
+        for (uint64_t offset : offsets) {
+            char buffer[64] = {};
+            stream.clear();
+            stream.seekg(offset);
+            stream.read(buffer, sizeof(buffer));
+            std::string expected = data.substr(offset, sizeof(buffer));
+            EXPECT_EQ(std::string(buffer, stream.gcount()), expected) << offset;
+        }
+        EXPECT_EQ(stream.restarts(), 0);
+
+        // reading on from a checkpoint crosses block and member boundaries
+        stream.clear();
+        stream.seekg(300000);
+        std::string rest(data.size() - 300000, '\0');
+        stream.read(&rest[0], rest.size());
+        EXPECT_EQ(static_cast<size_t>(stream.gcount()), rest.size());
+        EXPECT_TRUE(rest == data.substr(300000));
+
+        stream.clear();
+        stream.seekg(-5, std::ios::end);
+        EXPECT_EQ(static_cast<uint64_t>(stream.tellg()), data.size() - 5);
+
+        fs::remove(filepath);
+        fs::remove(filepath + ".gzi");
+    }
+}
+
 }
@@ -2,6 +2,7 @@
 
 #include "shendk/files/container/tad.h"
 #include "shendk/utils/hash_db.h"
+#include "shendk/utils/string_helper.h"
 
 namespace {
 
@@ -18,4 +19,92 @@ namespace {
         SUCCEED();
 	}
 
+    TEST(TAD, extract)
+    {
+        std::string tacPath = (fs::temp_directory_path() / "shendk_extract.tac").string();
+        std::string folder = (fs::temp_directory_path() / "shendk_extract").string();
+
+        shendk::TAD tad;
+        {
+            std::ofstream tac(tacPath, std::ios::binary);
+            for (uint32_t i = 0; i < 12; i++) {
+                shendk::TAD::Entry entry = {};
+                entry.fileOffset = static_cast<uint32_t>(tac.tellp());
+                entry.fileSize = 100 * (i + 1);
+                tac << std::string(entry.fileSize, static_cast<char>('a' + i));
+                tad.entries.push_back(entry);
+            }
+        }
+
+        // unknown hashes are named by their index
+        EXPECT_TRUE(tad.extract(tacPath, folder, "1?", 2));
+        EXPECT_FALSE(fs::exists(fs::path(folder) / "1"));
+        EXPECT_EQ(fs::file_size(fs::path(folder) / "10"), 1100);
+        EXPECT_EQ(fs::file_size(fs::path(folder) / "11"), 1200);
+
+        EXPECT_TRUE(tad.extract(tacPath, folder));
+        EXPECT_EQ(fs::file_size(fs::path(folder) / "0"), 100);
+
+        fs::remove_all(folder);
+        fs::remove(tacPath);
+    }
+
+    TEST(TAD, glob)
+    {
+        EXPECT_TRUE(shendk::globMatch("*.PVR", "/data/scene/0001/MAP.PVR"));
+        EXPECT_TRUE(shendk::globMatch("/data/*/0001/*", "/data/scene/0001/MAP.PVR"));
+        EXPECT_TRUE(shendk::globMatch("MAP?.MT5", "MAP1.MT5"));
+        EXPECT_FALSE(shendk::globMatch("*.MT5", "MAP1.MT7"));
+        EXPECT_FALSE(shendk::globMatch("MAP?", "MAP"));
+    }
+
+    TEST(TAD, patch)
+    {
+        std::string tacPath = (fs::temp_directory_path() / "shendk_patch.tac").string();
+        std::string tadPath = (fs::temp_directory_path() / "shendk_patch.tad").string();
+
+        shendk::TAD tad;
+        {
+            std::ofstream tac(tacPath, std::ios::binary);
+            for (uint32_t i = 0; i < 3; i++) {
+                shendk::TAD::Entry entry = {};
+                entry.hash1 = i + 1;
+                entry.fileOffset = static_cast<uint32_t>(tac.tellp());
+                entry.fileSize = 100;
+                tac << std::string(entry.fileSize, static_cast<char>('a' + i));
+                tad.entries.push_back(entry);
+            }
+        }
+
+        std::string smaller(50, 'x');
+        std::string larger(300, 'y');
+        std::string added(10, 'z');
+        tad.patch(tacPath, 2, 0, smaller.data(), static_cast<uint32_t>(smaller.size()));
+        tad.patch(tacPath, 1, 0, larger.data(), static_cast<uint32_t>(larger.size()));
+        tad.patch(tacPath, 9, 9, added.data(), static_cast<uint32_t>(added.size()));
+
+        ASSERT_EQ(tad.entries.size(), 4);
+        EXPECT_EQ(tad.entries[1].fileOffset, 100); // reused slot
+        EXPECT_EQ(tad.entries[0].fileOffset, 304); // appended, aligned
+        EXPECT_EQ(tad.entries[3].fileOffset, 608);
+        EXPECT_EQ(tad.header.tacSize, fs::file_size(tacPath));
+
+        std::ifstream tac(tacPath, std::ios::binary);
+        std::string content((std::istreambuf_iterator<char>(tac)), std::istreambuf_iterator<char>());
+        EXPECT_EQ(content.substr(tad.entries[0].fileOffset, 300), larger);
+        EXPECT_EQ(content.substr(tad.entries[1].fileOffset, 50), smaller);
+        EXPECT_EQ(content.substr(tad.entries[2].fileOffset, 100), std::string(100, 'c'));
+        EXPECT_EQ(content.substr(tad.entries[3].fileOffset, 10), added);
+
+        tad.write(tadPath);
+        shendk::TAD written(tadPath);
+        ASSERT_EQ(written.entries.size(), 4);
+        EXPECT_EQ(written.entries[3].hash2, 9);
+        EXPECT_EQ(written.header.headerChecksum, tad.header.headerChecksum);
+
+        tac.close();
+        fs::remove(tacPath);
+        fs::remove(tadPath);
+    }
+
 }
@@ -1,9 +1,19 @@
 #include "gtest/gtest.h"
 
+#include <cmath>
+#include <cstring>
 #include <fstream>
 
 #include "shendk/files/image/pvr.h"
 #include "shendk/files/image/pvr/formats.h"
+#include "shendk/files/image/pvr/code_book_search.h"
+#include "shendk/files/image/pvr/compression_codec.h"
+#include "shendk/files/image/pvr/data_codec.h"
+#include "shendk/files/image/pvr/palette.h"
+#include "shendk/files/image/pvr/pixel_codec.h"
+#include "shendk/files/image/pvr/twiddle.h"
+#include "shendk/files/image/pvr/vector_quantizer.h"
+#include "shendk/utils/memstream.h"
 
 namespace {
 
@@ -33,4 +43,650 @@ namespace {
         SUCCEED();
 	}
 
+    TEST(PVR, rle)
+    {
+        // codec round trip for 1, 2 and 4 byte pixels
+        std::vector<shendk::pvr::PixelFormat> pixelFormats = { shendk::pvr::PixelFormat::ARGB1555, shendk::pvr::PixelFormat::ARGB8888 };
+        for (auto pixelFormat : pixelFormats) {
+            shendk::pvr::Rectangle rectangle;
+            rectangle.pixelCodec = shendk::pvr::PixelCodec::getPixelCodec(pixelFormat);
+            shendk::pvr::Index8 index8;
+            for (shendk::pvr::DataCodec* dataCodec : std::vector<shendk::pvr::DataCodec*>{ &rectangle, &index8 }) {
+                std::vector<uint8_t> input(16, 0xAB);
+                for (int i = 0; i < 3000; i++) {
+                    input.push_back(static_cast<uint8_t>(i < 1500 ? 7 : (i / 40) * 3));
+                }
+                uint64_t compressedSize = 0;
+                shendk::pvr::RLE rle;
+                uint8_t* compressed = rle.compress(input.data(), static_cast<uint32_t>(input.size()), 16, dataCodec, compressedSize);
+                EXPECT_LT(compressedSize, input.size() / 4);
+                EXPECT_EQ(shendk::pvr::CompressionCodec::decompressedSize(compressed, compressedSize), input.size());
+
+                uint8_t* decompressed = rle.decompress(compressed, static_cast<uint32_t>(compressedSize), 20, dataCodec);
+                ASSERT_TRUE(decompressed != nullptr);
+                EXPECT_EQ(std::vector<uint8_t>(decompressed, decompressed + input.size()), input);
+                EXPECT_EQ(shendk::pvr::RLE::decompress(compressed, compressedSize - 1, 20, shendk::pvr::RLE::pixelSize(dataCodec),
+                                                       decompressed, input.size()), 0);
+                delete[] compressed;
+                delete[] decompressed;
+            }
+            delete rectangle.pixelCodec;
+        }
+
+        // compressed textures read like uncompressed ones
+        shendk::PVR::Header header;
+        header.pixelFormat = shendk::pvr::PixelFormat::ARGB1555;
+        header.dataFormat = shendk::pvr::DataFormat::RECTANGLE;
+        header.width = 16;
+        header.height = 8;
+        header.size = 8 + header.width * header.height * 2;
+        std::vector<uint8_t> texture(sizeof(header));
+        memcpy(texture.data(), &header, sizeof(header));
+        for (int i = 0; i < header.width * header.height; i++) {
+            uint16_t pixel = static_cast<uint16_t>(0x8000 | (i / 10) * 0x421);
+            texture.push_back(pixel & 0xFF);
+            texture.push_back(pixel >> 8);
+        }
+
+        shendk::pvr::Rectangle rectangle;
+        rectangle.pixelCodec = shendk::pvr::PixelCodec::getPixelCodec(header.pixelFormat);
+        uint64_t compressedSize = 0;
+        shendk::pvr::RLE rle;
+        uint8_t* compressed = rle.compress(texture.data(), static_cast<uint32_t>(texture.size()), sizeof(header), &rectangle, compressedSize);
+        delete rectangle.pixelCodec;
+
+        imstream plainStream(reinterpret_cast<char*>(texture.data()), texture.size());
+        shendk::PVR plain(plainStream);
+        imstream compressedStream(reinterpret_cast<char*>(compressed), compressedSize);
+        shendk::PVR decompressed(compressedStream);
+        EXPECT_EQ(static_cast<uint64_t>(compressedStream.tellg()), compressedSize);
+        delete[] compressed;
+
+        ASSERT_EQ(plain.mipmaps.size(), 1);
+        ASSERT_EQ(decompressed.mipmaps.size(), 1);
+        EXPECT_EQ(decompressed.header.width, 16);
+        for (int i = 0; i < header.width * header.height; i++) {
+            shendk::RGBA a = (*plain.mipmaps[0])[i];
+            shendk::RGBA b = (*decompressed.mipmaps[0])[i];
+            EXPECT_EQ(memcmp(&a, &b, sizeof(shendk::RGBA)), 0);
+        }
+    }
+
+    TEST(PVR, twiddle)
+    {
+        auto reference = [](uint32_t value) {
+            uint32_t result = 0;
+            for (uint32_t bit = 0; bit < 16; bit++) {
+                result |= ((value >> bit) & 1) << (bit * 2);
+            }
+            return result;
+        };
+        for (uint32_t i = 0; i < 5000; i++) {
+            EXPECT_EQ(shendk::pvr::twiddleBits(i), reference(i));
+        }
+
+        // rectangles are made of twiddled squares
+        uint32_t sizes[][2] = { {1, 1}, {2, 2}, {4, 4}, {64, 64}, {64, 16}, {8, 32} };
+        for (auto& size : sizes) {
+            uint32_t width = size[0], height = size[1];
+            uint32_t square = std::min(width, height);
+            for (uint32_t pixelSize : { 1u, 2u, 3u, 4u }) {
+                std::vector<uint8_t> twiddled(width * height * pixelSize);
+                for (size_t i = 0; i < twiddled.size(); i++) {
+                    twiddled[i] = static_cast<uint8_t>(i * 7 + i / 251);
+                }
+                std::vector<uint8_t> linear(twiddled.size());
+                shendk::pvr::detwiddleRectangle(twiddled.data(), linear.data(), width, height, pixelSize);
+                for (uint32_t y = 0; y < height; y++) {
+                    for (uint32_t x = 0; x < width; x++) {
+                        uint32_t block = (y / square) * (width / square) + (x / square);
+                        uint32_t index = block * square * square + ((reference(x % square) << 1) | reference(y % square));
+                        ASSERT_EQ(memcmp(&linear[(y * width + x) * pixelSize], &twiddled[index * pixelSize], pixelSize), 0);
+                    }
+                }
+                std::vector<uint8_t> retwiddled(twiddled.size());
+                shendk::pvr::twiddleRectangle(linear.data(), retwiddled.data(), width, height, pixelSize);
+                EXPECT_EQ(retwiddled, twiddled);
+            }
+        }
+
+        // data codec round trip
+        shendk::pvr::RectangleTwiddled codec;
+        codec.pixelCodec = shendk::pvr::PixelCodec::getPixelCodec(shendk::pvr::PixelFormat::ARGB4444);
+        std::vector<uint8_t> pixels(32 * 8 * 4);
+        for (size_t i = 0; i < pixels.size(); i++) {
+            pixels[i] = static_cast<uint8_t>(((i * 13) & 0xF) * 0x11); // exact in 4 bits
+        }
+        uint8_t* encoded = codec.encode(pixels.data(), 32, 8, codec.pixelCodec);
+        uint8_t* decoded = codec.decode(encoded, 32, 8, codec.pixelCodec);
+        EXPECT_EQ(std::vector<uint8_t>(decoded, decoded + pixels.size()), pixels);
+        delete[] encoded;
+        delete[] decoded;
+        delete codec.pixelCodec;
+    }
+
+    TEST(PVR, pixel_rows)
+    {
+        std::vector<uint8_t> packed(65536 * 2);
+        for (uint32_t i = 0; i < 65536; i++) {
+            packed[i * 2] = static_cast<uint8_t>(i);
+            packed[i * 2 + 1] = static_cast<uint8_t>(i >> 8);
+        }
+        std::vector<uint8_t> bgra(65536 * 4);
+        for (size_t i = 0; i < bgra.size(); i++) {
+            bgra[i] = static_cast<uint8_t>(i * 2654435761u >> 13);
+        }
+
+        shendk::pvr::PixelFormat formats[] = {
+            shendk::pvr::PixelFormat::ARGB1555, shendk::pvr::PixelFormat::RGB565,
+            shendk::pvr::PixelFormat::ARGB4444, shendk::pvr::PixelFormat::RGB555
+        };
+        for (auto format : formats) {
+            shendk::pvr::PixelCodec* codec = shendk::pvr::PixelCodec::getPixelCodec(format);
+
+            // odd counts run the vector kernels and the scalar tail
+            std::vector<uint8_t> decoded(65536 * 4);
+            codec->decodeRow(packed.data(), decoded.data(), 65535);
+            std::vector<uint8_t> encoded(65536 * 2);
+            codec->encodeRow(bgra.data(), encoded.data(), 65535);
+            for (uint32_t i = 0; i < 65535; i++) {
+                uint8_t pixel[4];
+                codec->decodePixel(packed.data(), i * 2, pixel, 0);
+                ASSERT_EQ(memcmp(pixel, &decoded[i * 4], 4), 0) << i;
+                uint8_t value[2];
+                codec->encodePixel(bgra.data(), i * 4, value, 0);
+                ASSERT_EQ(memcmp(value, &encoded[i * 2], 2), 0) << i;
+            }
+            delete codec;
+        }
+
+        // expansion matches v * 255 / max
+        shendk::pvr::ARGB1555 argb1555;
+        uint16_t pixel = 0x8000 | (31 << 10) | (16 << 5) | 1;
+        uint8_t decoded[4];
+        argb1555.decodeRow(reinterpret_cast<uint8_t*>(&pixel), decoded, 1);
+        EXPECT_EQ(decoded[0], 1 * 255 / 31);
+        EXPECT_EQ(decoded[1], 16 * 255 / 31);
+        EXPECT_EQ(decoded[2], 255);
+        EXPECT_EQ(decoded[3], 255);
+    }
+
+    TEST(PVR, yuv_bump)
+    {
+        std::vector<uint8_t> packed(65536 * 2);
+        for (uint32_t i = 0; i < 65536; i++) {
+            uint32_t value = i * 2654435761u;
+            packed[i * 2] = static_cast<uint8_t>(value >> 8);
+            packed[i * 2 + 1] = static_cast<uint8_t>(value >> 24);
+        }
+
+        // YUV422 decodes with Y + round(coefficient * chroma), clamped
+        shendk::pvr::YUV422 yuv;
+        std::vector<uint8_t> decoded(65536 * 4);
+        yuv.decodeRow(packed.data(), decoded.data(), 65535);
+        auto expect = [](int y, double value) {
+            return static_cast<int>(std::min(std::max(std::floor(y + value + 0.5), 0.0), 255.0));
+        };
+        for (uint32_t i = 0; i < 65534; i++) {
+            const uint8_t* pair = &packed[(i & ~1u) * 2];
+            int y = pair[(i & 1) * 2 + 1], u = pair[0] - 128, v = pair[2] - 128;
+            ASSERT_EQ(decoded[i * 4 + 0], expect(y, 1.71875 * u)) << i;
+            ASSERT_EQ(decoded[i * 4 + 1], expect(y, -0.6875 * v - 0.34375 * u)) << i;
+            ASSERT_EQ(decoded[i * 4 + 2], expect(y, 1.375 * v)) << i;
+            ASSERT_EQ(decoded[i * 4 + 3], 0xFF);
+        }
+
+        // YUV422 round trip of pixel pairs with the same color
+        std::vector<uint8_t> colors;
+        for (int i = 0; i < 512; i++) {
+            uint8_t color[4] = { static_cast<uint8_t>(64 + i % 128), static_cast<uint8_t>(200 - i % 100), static_cast<uint8_t>(i * 3 % 256), 0xFF };
+            colors.insert(colors.end(), color, color + 4);
+            colors.insert(colors.end(), color, color + 4);
+        }
+        std::vector<uint8_t> yuvData(colors.size() / 2);
+        yuv.encodeRow(colors.data(), yuvData.data(), colors.size() / 4);
+        std::vector<uint8_t> yuvColors(colors.size());
+        yuv.decodeRow(yuvData.data(), yuvColors.data(), colors.size() / 4);
+        for (size_t i = 0; i < colors.size(); i++) {
+            EXPECT_NEAR(yuvColors[i], colors[i], 4) << i;
+        }
+
+        // vectorized YUV422 rows encode like single pixel pairs
+        std::vector<uint8_t> bgra(1027 * 4);
+        for (size_t i = 0; i < bgra.size(); i++) {
+            bgra[i] = static_cast<uint8_t>((i * 2654435761u) >> 13);
+        }
+        std::vector<uint8_t> rowData(1028 * 2), pairData(1028 * 2);
+        yuv.encodeRow(bgra.data(), rowData.data(), 1027);
+        for (uint32_t i = 0; i + 1 < 1027; i += 2) {
+            yuv.encodePixel(bgra.data(), i * 4, pairData.data(), i * 2);
+        }
+        for (size_t i = 0; i < 1026 * 2; i++) {
+            ASSERT_EQ(rowData[i], pairData[i]) << i;
+        }
+
+        // BUMP88 decode table matches the trigonometric conversion
+        const double pi = 3.14159265358979323846;
+        shendk::pvr::BUMP88 bump;
+        std::vector<uint8_t> all(65536 * 2);
+        for (uint32_t i = 0; i < 65536; i++) {
+            all[i * 2] = static_cast<uint8_t>(i);
+            all[i * 2 + 1] = static_cast<uint8_t>(i >> 8);
+        }
+        std::vector<uint8_t> normals(65536 * 4);
+        bump.decodeRow(all.data(), normals.data(), 65536);
+        for (uint32_t i = 0; i < 65536; i += 97) {
+            double r = (i & 0xFF) / 255.0 * 2.0 * pi;
+            double s = (i >> 8) / 255.0 * 0.5 * pi;
+            EXPECT_EQ(normals[i * 4 + 2], static_cast<uint8_t>((0.5 * std::cos(s) * std::cos(r) + 0.5) * 255.0));
+            EXPECT_EQ(normals[i * 4 + 1], static_cast<uint8_t>((0.5 * std::cos(s) * std::sin(r) + 0.5) * 255.0));
+            EXPECT_EQ(normals[i * 4 + 0], static_cast<uint8_t>((0.5 * std::sin(s) + 0.5) * 255.0));
+        }
+
+        // BUMP88 encode stays within one step of the double precision angles
+        std::vector<uint8_t> bumps(65536 * 2);
+        bump.encodeRow(normals.data(), bumps.data(), 65535);
+        for (uint32_t i = 0; i < 65535; i++) {
+            const uint8_t* color = &normals[i * 4];
+            double x = color[2] / 255.0 * 2.0 - 1.0;
+            double y = color[1] / 255.0 * 2.0 - 1.0;
+            double z = color[0] / 255.0 * 2.0 - 1.0;
+            double r = std::atan2(y, x);
+            r = r < 0.0 ? r + 2.0 * pi : r;
+            double s = std::min(std::max(std::asin(z / std::sqrt(x * x + y * y + z * z)), 0.0), 0.5 * pi);
+            int expectedR = static_cast<int>(std::round(r / (2.0 * pi) * 255.0));
+            int expectedS = static_cast<int>(std::round(s / (0.5 * pi) * 255.0));
+            int distanceR = std::abs(bumps[i * 2] - expectedR);
+            ASSERT_LE(std::min(distanceR, 255 - distanceR), 1) << i;
+            ASSERT_LE(std::abs(bumps[i * 2 + 1] - expectedS), 1) << i;
+        }
+    }
+
+    TEST(PVR, decode_into)
+    {
+        struct Case { shendk::pvr::PixelFormat pixelFormat; shendk::pvr::DataFormat dataFormat; uint16_t size; uint32_t paletteSize; };
+        std::vector<Case> cases = {
+            { shendk::pvr::PixelFormat::ARGB4444, shendk::pvr::DataFormat::SQUARE_TWIDDLED, 32, 0 },
+            { shendk::pvr::PixelFormat::RGB565, shendk::pvr::DataFormat::SQUARE_TWIDDLED_MIPMAP, 16, 0 },
+            { shendk::pvr::PixelFormat::ARGB8888, shendk::pvr::DataFormat::RECTANGLE, 8, 0 },
+            { shendk::pvr::PixelFormat::ARGB1555, shendk::pvr::DataFormat::VECTOR_QUANTIZATION, 16, 1024 * 2 },
+        };
+        for (auto& c : cases) {
+            shendk::pvr::DataCodec* reference = shendk::pvr::DataCodec::getDataCodec(c.dataFormat);
+            shendk::pvr::PixelCodec* pixelCodec = shendk::pvr::PixelCodec::getPixelCodec(c.pixelFormat);
+            reference->pixelCodec = pixelCodec;
+
+            // largest level last, the 1x1 level of SQUARE_TWIDDLED_MIPMAP is padded to 2x1
+            uint64_t levelSize = (static_cast<uint64_t>(c.size) * c.size * reference->bpp()) >> 3;
+            uint64_t dataSize = levelSize;
+            if (reference->hasMipmaps()) {
+                dataSize = 2;
+                for (uint32_t size = 1; size <= c.size; size <<= 1) {
+                    dataSize += (size * size * reference->bpp()) >> 3;
+                }
+            }
+
+            shendk::PVR::Header header;
+            header.size = static_cast<uint32_t>(8 + c.paletteSize + dataSize);
+            header.pixelFormat = c.pixelFormat;
+            header.dataFormat = c.dataFormat;
+            header.width = c.size;
+            header.height = c.size;
+            std::vector<char> file(sizeof(header) + c.paletteSize + dataSize);
+            memcpy(file.data(), &header, sizeof(header));
+            for (size_t i = sizeof(header); i < file.size(); i++) {
+                file[i] = static_cast<char>(i * 2654435761u >> 11);
+            }
+
+            imstream stream(file.data(), file.size());
+            shendk::PVR pvr(stream);
+            ASSERT_EQ(pvr.mipmaps.size(), reference->hasMipmaps() ? 5u : 1u);
+
+            // legacy BGRA top down decode of the largest level
+            uint8_t* data = reinterpret_cast<uint8_t*>(file.data()) + sizeof(header);
+            if (c.paletteSize) {
+                reference->setPalette(data, 0, reference->paletteEntries(c.size));
+            }
+            uint8_t* expected = reference->decode(data + c.paletteSize + dataSize - levelSize, c.size, c.size, pixelCodec);
+            shendk::Image& image = *pvr.mipmaps.front();
+            for (uint32_t y = 0; y < c.size; y++) {
+                for (uint32_t x = 0; x < c.size; x++) {
+                    const uint8_t* bgra = expected + ((c.size - 1 - y) * c.size + x) * 4;
+                    const shendk::RGBA& pixel = image[y * c.size + x];
+                    ASSERT_EQ(pixel.b, bgra[0]);
+                    ASSERT_EQ(pixel.g, bgra[1]);
+                    ASSERT_EQ(pixel.r, bgra[2]);
+                    ASSERT_EQ(pixel.a, bgra[3]);
+                }
+            }
+            delete[] expected;
+            delete reference;
+            delete pixelCodec;
+        }
+    }
+
+    TEST(PVR, encode)
+    {
+        using shendk::pvr::DataFormat;
+        using shendk::pvr::PixelFormat;
+
+        // image made of cells of 16 distinct colors, exact for every format below
+        auto createImage = [](uint32_t width, uint32_t height, uint32_t cell = 2) {
+            std::shared_ptr<shendk::Image> image(new shendk::Image(width, height));
+            for (uint32_t y = 0; y < height; y++) {
+                for (uint32_t x = 0; x < width; x++) {
+                    uint32_t color = ((x / cell) * 7 + (y / cell) * 3) % 16;
+                    shendk::RGBA& pixel = (*image)[y * width + x];
+                    pixel.r = static_cast<uint8_t>(color * 0x11);
+                    pixel.g = static_cast<uint8_t>((15 - color) * 0x11);
+                    pixel.b = static_cast<uint8_t>(((color * 5) & 0xF) * 0x11);
+                    pixel.a = static_cast<uint8_t>((color & 1) ? 0xFF : 0x88);
+                }
+            }
+            return image;
+        };
+        auto sameImage = [](const shendk::Image& a, const shendk::Image& b) {
+            if (a.width() != b.width() || a.height() != b.height()) return false;
+            return memcmp(a.getDataPtr(), b.getDataPtr(), a.width() * a.height() * sizeof(shendk::RGBA)) == 0;
+        };
+
+        // palettes and code books are shared by all levels, large cells keep the downsampled levels exact
+        struct Case { PixelFormat pixelFormat; DataFormat dataFormat; uint32_t width; uint32_t height; size_t levels; uint32_t cell; };
+        std::vector<Case> cases = {
+            { PixelFormat::ARGB4444, DataFormat::SQUARE_TWIDDLED, 32, 32, 1, 2 },
+            { PixelFormat::ARGB8888, DataFormat::SQUARE_TWIDDLED_MIPMAP, 32, 32, 6, 2 },
+            { PixelFormat::ARGB4444, DataFormat::RECTANGLE, 24, 6, 1, 2 },
+            { PixelFormat::ARGB8888, DataFormat::RECTANGLE_TWIDDLED, 64, 16, 1, 2 },
+            { PixelFormat::ARGB4444, DataFormat::PALETTIZE_4BIT_MIPMAP, 16, 16, 5, 8 },
+            { PixelFormat::ARGB8888, DataFormat::PALETTIZE_8BIT, 32, 16, 1, 2 },
+            { PixelFormat::ARGB4444, DataFormat::VECTOR_QUANTIZATION, 64, 64, 1, 2 },
+            { PixelFormat::ARGB4444, DataFormat::VECTOR_QUANTIZATION_SMALL_MIPMAP, 16, 16, 5, 8 },
+        };
+        for (auto& c : cases) {
+            shendk::PVR pvr(createImage(c.width, c.height, c.cell));
+            pvr.header.pixelFormat = c.pixelFormat;
+            pvr.header.dataFormat = c.dataFormat;
+            pvr.hasGlobalIndex = true;
+            pvr.globalIndex.index = 42;
+            omstream out;
+            pvr.write(out);
+            size_t size = 0;
+            char* data = out.getBuffer(size);
+
+            // 12 byte GBIX chunk: signature, size of the index, index, then PVRT
+            uint32_t gbix[4];
+            ASSERT_GE(size, sizeof(gbix));
+            memcpy(gbix, data, sizeof(gbix));
+            EXPECT_EQ(gbix[0], static_cast<uint32_t>(shendk::PVR::gbix));
+            EXPECT_EQ(gbix[1], 4u);
+            EXPECT_EQ(gbix[2], 42u);
+            EXPECT_EQ(gbix[3], static_cast<uint32_t>(shendk::PVR::pvrt));
+
+            shendk::PVR read;
+            read.palette = pvr.palette; // external palette of palettized formats
+            imstream in(data, size);
+            read.read(in);
+            EXPECT_EQ(static_cast<size_t>(in.tellg()), size);
+            EXPECT_EQ(read.globalIndex.index, 42u);
+            EXPECT_EQ(read.header.width, c.width);
+            ASSERT_EQ(read.mipmaps.size(), c.levels);
+            EXPECT_TRUE(sameImage(*read.mipmaps.front(), *pvr.mipmaps.front())) << static_cast<int>(c.dataFormat);
+            EXPECT_EQ(read.mipmaps.back()->width(), static_cast<int>(c.width >> (c.levels - 1)));
+        }
+
+        // 16 byte GBIX chunks (size 8, padded) are skipped by their size
+        {
+            shendk::PVR pvr(createImage(8, 8));
+            pvr.header.pixelFormat = PixelFormat::ARGB8888;
+            pvr.header.dataFormat = DataFormat::SQUARE_TWIDDLED;
+            pvr.hasGlobalIndex = true;
+            pvr.globalIndex.index = 7;
+            omstream out;
+            pvr.write(out);
+            size_t size = 0;
+            char* data = out.getBuffer(size);
+            std::vector<char> padded(data, data + 12);
+            padded.insert(padded.end(), 4, '\0');
+            padded.insert(padded.end(), data + 12, data + size);
+            uint32_t gbixSize = 8;
+            memcpy(padded.data() + 4, &gbixSize, sizeof(gbixSize));
+
+            shendk::PVR read;
+            imstream in(padded.data(), padded.size());
+            read.read(in);
+            EXPECT_EQ(read.globalIndex.index, 7u);
+            EXPECT_EQ(read.header.width, 8);
+            EXPECT_EQ(static_cast<size_t>(in.tellg()), padded.size());
+            ASSERT_EQ(read.mipmaps.size(), 1u);
+            EXPECT_TRUE(sameImage(*read.mipmaps.front(), *pvr.mipmaps.front()));
+        }
+
+        // downsampled mipmaps are 2x2 box filtered
+        shendk::PVR pvr(createImage(4, 4));
+        pvr.header.pixelFormat = PixelFormat::ARGB8888;
+        pvr.header.dataFormat = DataFormat::SQUARE_TWIDDLED_MIPMAP;
+        omstream out;
+        pvr.write(out);
+        size_t size = 0;
+        char* data = out.getBuffer(size);
+        shendk::PVR read;
+        read.read(data, size);
+        ASSERT_EQ(read.mipmaps.size(), 3u);
+        const shendk::Image& base = *pvr.mipmaps.front();
+        const shendk::RGBA& texel = (*read.mipmaps[1])[3];
+        EXPECT_EQ(texel.r, (base[10].r + base[11].r + base[14].r + base[15].r + 2) / 4);
+        EXPECT_EQ(texel.a, (base[10].a + base[11].a + base[14].a + base[15].a + 2) / 4);
+
+        // unsupported layouts
+        shendk::PVR rectangle(createImage(32, 16));
+        rectangle.header.pixelFormat = PixelFormat::RGB565;
+        rectangle.header.dataFormat = DataFormat::VECTOR_QUANTIZATION;
+        EXPECT_THROW(rectangle.write(out), std::runtime_error*);
+    }
+
+    TEST(PVR, vq_codebook)
+    {
+        // 200 distinct 2x2 blocks spread over a 256x256 image, clustered to 256 entries exactly
+        std::vector<uint8_t> patterns(200 * 16);
+        for (size_t i = 0; i < patterns.size(); i++) {
+            patterns[i] = static_cast<uint8_t>(i * 2654435761u >> 9);
+        }
+        std::vector<uint8_t> image(256 * 256 * 4);
+        for (uint32_t y = 0; y < 256; y++) {
+            for (uint32_t x = 0; x < 256; x++) {
+                uint32_t pattern = ((y / 2) * 131 + (x / 2) * 17) % 200;
+                uint32_t texel = (y % 2) * 2 + (x % 2);
+                memcpy(&image[(y * 256 + x) * 4], &patterns[pattern * 16 + texel * 4], 4);
+            }
+        }
+        shendk::pvr::VQBlocks blocks;
+        blocks.add(image.data(), 256, 256);
+        ASSERT_EQ(blocks.count(), 128u * 128u);
+
+        shendk::pvr::VQOptions options;
+        options.sampleSize = 0;
+        std::vector<uint8_t> codeBook = shendk::pvr::createCodeBook(blocks, 256, options);
+        ASSERT_EQ(codeBook.size(), 256u * 16u);
+        EXPECT_EQ(shendk::pvr::createCodeBook(blocks, 256, options), codeBook); // reproducible
+        std::vector<uint8_t> indices = shendk::pvr::quantize(blocks, codeBook);
+        for (uint64_t i = 0; i < blocks.count(); i++) {
+            ASSERT_EQ(memcmp(blocks.block(i), &codeBook[indices[i] * 16], 16), 0) << i;
+        }
+
+        // fewer entries than distinct blocks: error stays far below the one of a single entry
+        std::vector<uint8_t> small = shendk::pvr::createCodeBook(blocks, 64);
+        std::vector<uint8_t> single = shendk::pvr::createCodeBook(blocks, 1);
+        auto error = [&](const std::vector<uint8_t>& book) {
+            std::vector<uint8_t> mapping = shendk::pvr::quantize(blocks, book);
+            double sum = 0.0;
+            for (uint64_t i = 0; i < blocks.count(); i++) {
+                for (int j = 0; j < 16; j++) {
+                    double d = blocks.block(i)[j] - book[mapping[i] * 16 + j];
+                    sum += d * d;
+                }
+            }
+            return sum;
+        };
+        EXPECT_LT(error(small), error(single) * 0.6);
+    }
+
+    TEST(PVR, code_book_search)
+    {
+        // same errors as a brute force scan, for palettes (4 channels) and VQ blocks (16 channels)
+        uint32_t seed = 12345;
+        auto next = [&]() { seed = seed * 1664525u + 1013904223u; return static_cast<float>(seed >> 24); };
+        for (uint32_t dimensions : { 4u, 16u }) {
+            for (uint32_t size : { 1u, 16u, 256u }) {
+                std::vector<float> codeBook(size * dimensions);
+                for (auto& value : codeBook) value = next();
+                shendk::pvr::CodeBookSearch search(codeBook.data(), size, dimensions);
+                ASSERT_EQ(search.size(), size);
+                for (int query = 0; query < 2000; query++) {
+                    std::vector<float> block(dimensions);
+                    for (auto& value : block) value = next();
+                    float expected = INFINITY;
+                    uint32_t expectedIndex = 0;
+                    for (uint32_t i = 0; i < size; i++) {
+                        float d = 0.0f;
+                        for (uint32_t j = 0; j < dimensions; j++) {
+                            float difference = block[j] - codeBook[i * dimensions + j];
+                            d += difference * difference;
+                        }
+                        if (d < expected) {
+                            expected = d;
+                            expectedIndex = i;
+                        }
+                    }
+                    float distance;
+                    uint32_t index = search.nearest(block.data(), distance);
+                    ASSERT_NEAR(distance, expected, expected * 1e-5f + 1e-3f);
+                    if (distance != expected) continue;
+                    ASSERT_EQ(index, expectedIndex);
+                }
+                // entries find themselves
+                float distance;
+                EXPECT_EQ(search.nearest(codeBook.data() + (size - 1) * dimensions, distance), size - 1);
+                EXPECT_EQ(distance, 0.0f);
+            }
+        }
+    }
+
+    TEST(PVR, palette)
+    {
+        using shendk::pvr::DataFormat;
+        using shendk::pvr::PixelFormat;
+
+        // smooth gradient of far more than 256 colors, with a transparent border of arbitrary colors
+        uint32_t width = 64, height = 64;
+        std::shared_ptr<shendk::Image> image(new shendk::Image(width, height));
+        for (uint32_t y = 0; y < height; y++) {
+            for (uint32_t x = 0; x < width; x++) {
+                shendk::RGBA& pixel = (*image)[y * width + x];
+                bool border = x < 4 || y < 4 || x >= width - 4 || y >= height - 4;
+                pixel.r = static_cast<uint8_t>(x * 4);
+                pixel.g = static_cast<uint8_t>(y * 4);
+                pixel.b = static_cast<uint8_t>(border ? (x * 37 + y * 11) : 128);
+                pixel.a = static_cast<uint8_t>(border ? 0 : 0xFF);
+            }
+        }
+        std::vector<uint8_t> bgra(width * height * 4);
+        for (uint32_t i = 0; i < width * height; i++) {
+            const shendk::RGBA& pixel = (*image)[i];
+            bgra[i * 4] = pixel.b;
+            bgra[i * 4 + 1] = pixel.g;
+            bgra[i * 4 + 2] = pixel.r;
+            bgra[i * 4 + 3] = pixel.a;
+        }
+        shendk::pvr::VQBlocks colors(1, 1);
+        colors.add(bgra.data(), width, height);
+
+        // transparent texels share a transparent entry, the others stay close
+        std::vector<uint8_t> palette = shendk::pvr::createPalette(colors, 256);
+        ASSERT_EQ(palette.size(), 256u * 4u);
+        EXPECT_EQ(shendk::pvr::createPalette(colors, 256), palette); // reproducible
+        shendk::pvr::PaletteSearch search(palette);
+        double error = 0.0;
+        for (uint32_t i = 0; i < width * height; i++) {
+            const uint8_t* entry = &palette[search.index(&bgra[i * 4]) * 4];
+            if (bgra[i * 4 + 3] == 0) {
+                ASSERT_EQ(entry[3], 0) << i;
+                continue;
+            }
+            for (int c = 0; c < 4; c++) {
+                error += (bgra[i * 4 + c] - entry[c]) * (bgra[i * 4 + c] - entry[c]);
+            }
+        }
+        EXPECT_LT(std::sqrt(error / (width * height)), 6.0); // a 16x16 grid over the gradient gives 5.7
+
+        // refinement doesn't make the median cut worse
+        shendk::pvr::PaletteOptions unrefined;
+        unrefined.iterations = 0;
+        std::vector<uint8_t> median = shendk::pvr::createPalette(colors, 16, unrefined);
+        std::vector<uint8_t> refined = shendk::pvr::createPalette(colors, 16);
+        auto paletteError = [&](const std::vector<uint8_t>& entries) {
+            shendk::pvr::PaletteSearch entrySearch(entries);
+            double sum = 0.0;
+            for (uint32_t i = 0; i < width * height; i++) {
+                const uint8_t* entry = &entries[entrySearch.index(&bgra[i * 4]) * 4];
+                for (int c = 0; c < 4 && bgra[i * 4 + 3] != 0; c++) {
+                    sum += (bgra[i * 4 + c] - entry[c]) * (bgra[i * 4 + c] - entry[c]);
+                }
+            }
+            return sum;
+        };
+        EXPECT_LE(paletteError(refined), paletteError(median) * 1.01);
+
+        // indices are written straight into the twiddled layout of the index codecs
+        std::vector<shendk::pvr::DataCodec*> codecs = { new shendk::pvr::Index4(), new shendk::pvr::Index8() };
+        std::vector<std::pair<uint16_t, uint16_t>> sizes = { { 64, 64 }, { 64, 16 }, { 16, 32 }, { 4, 4 }, { 4, 2 }, { 1, 1 } };
+        for (shendk::pvr::DataCodec* codec : codecs) {
+            std::vector<uint8_t> entries = shendk::pvr::createPalette(colors, codec->paletteEntries(0));
+            shendk::pvr::PaletteSearch entrySearch(entries);
+            for (auto& size : sizes) {
+                std::vector<uint8_t> indices(size.first * size.second);
+                for (uint32_t y = 0; y < size.second; y++) {
+                    for (uint32_t x = 0; x < size.first; x++) {
+                        indices[y * size.first + x] = entrySearch.index(&bgra[(y * width + x) * 4]);
+                    }
+                }
+                std::vector<uint8_t> rows(size.first * size.second * 4);
+                for (uint32_t y = 0; y < size.second; y++) {
+                    memcpy(&rows[y * size.first * 4], &bgra[y * width * 4], size.first * 4);
+                }
+                uint64_t dataSize = codec->dataSize(size.first, size.second, nullptr);
+                std::vector<uint8_t> expected(dataSize), encoded(dataSize, 0xCD);
+                codec->encodeInto(indices.data(), size.first, size.second, nullptr, expected.data());
+                codec->encodeIndexed(rows.data(), size.first, size.second, entrySearch, encoded.data());
+                EXPECT_EQ(encoded, expected) << size.first << "x" << size.second;
+            }
+            delete codec;
+        }
+        shendk::pvr::SquareTwiddled twiddled;
+        EXPECT_THROW(twiddled.encodeIndexed(bgra.data(), 8, 8, search, palette.data()), std::runtime_error*);
+
+        // palettized textures round trip with their created palette
+        shendk::PVR pvr(image);
+        pvr.header.pixelFormat = PixelFormat::ARGB8888;
+        pvr.header.dataFormat = DataFormat::PALETTIZE_8BIT_MIPMAP;
+        omstream out;
+        pvr.write(out);
+        ASSERT_EQ(pvr.palette.size(), 256u);
+        EXPECT_EQ(pvr.encodePalette().size(), 256u * 4u);
+        size_t size = 0;
+        char* data = out.getBuffer(size);
+        shendk::PVR read;
+        read.palette = pvr.palette;
+        read.read(data, size);
+        ASSERT_EQ(read.mipmaps.size(), 7u);
+        const shendk::Image& decoded = *read.mipmaps.front();
+        for (uint32_t i = 0; i < width * height; i++) {
+            if ((*image)[i].a == 0) {
+                EXPECT_EQ(decoded[i].a, 0) << i;
+            } else {
+                EXPECT_NEAR(decoded[i].r, (*image)[i].r, 24) << i;
+                EXPECT_NEAR(decoded[i].g, (*image)[i].g, 24) << i;
+            }
+        }
+    }
+
 }
@@ -0,0 +1,92 @@
+#include "gtest/gtest.h"
+
+#include <sstream>
+
+#include "shendk/node/node.h"
+#include "shendk/utils/binary_writer.h"
+#include "shendk/utils/memstream.h"
+
+namespace {
+
+struct LeafNode : public shendk::Node {
+    uint32_t value = 0;
+
+protected:
+    void _read(std::istream& stream) override {
+        stream.read(reinterpret_cast<char*>(&value), sizeof(value));
+    }
+};
+
+struct ParentNode : public shendk::Node {
+    uint32_t value = 0;
+    LeafNode child;
+
+protected:
+    void _read(std::istream& stream) override {
+        stream.read(reinterpret_cast<char*>(&value), sizeof(value));
+        child.read(stream);
+    }
+};
+
+// PRNT { value, LEAF { value } } followed by a trailing word
+std::string createNodes(uint32_t parentSize = 24) {
+    shendk::BinaryWriter writer;
+    writer.write<uint32_t>(0x544E5250); // PRNT
+    writer.write<uint32_t>(parentSize);
+    writer.write<uint32_t>(7);
+    writer.write<uint32_t>(0x4641454C); // LEAF
+    writer.write<uint32_t>(12);
+    writer.write<uint32_t>(42);
+    writer.write<uint32_t>(0xFFFFFFFF);
+    std::vector<uint8_t> buffer = writer.release();
+    return std::string(buffer.begin(), buffer.end());
+}
+
+TEST(Node, read_nested)
+{
+    std::string data = createNodes();
+
+    // memory backed stream, bodies are parsed from the parent's memory
+    ParentNode fromMemory;
+    imstream memoryStream(&data[0], data.size());
+    fromMemory.read(memoryStream);
+    EXPECT_EQ(static_cast<int64_t>(memoryStream.tellg()), 24);
+
+    // plain stream, the body is buffered once
+    ParentNode fromStream;
+    std::istringstream plainStream(data);
+    fromStream.read(plainStream);
+    EXPECT_EQ(static_cast<int64_t>(plainStream.tellg()), 24);
+
+    for (ParentNode* node : { &fromMemory, &fromStream }) {
+        EXPECT_EQ(node->header.signature, 0x544E5250u);
+        EXPECT_EQ(node->header.size, 24u);
+        EXPECT_EQ(node->value, 7u);
+        EXPECT_EQ(node->child.header.signature, 0x4641454Cu);
+        EXPECT_EQ(node->child.header.size, 12u);
+        EXPECT_EQ(node->child.value, 42u);
+    }
+}
+
+TEST(Node, read_invalid)
+{
+    // size smaller than the node header
+    std::string undersized = createNodes(4);
+    ParentNode node;
+    imstream undersizedStream(&undersized[0], undersized.size());
+    EXPECT_ANY_THROW(node.read(undersizedStream));
+
+    // header cut off
+    std::string truncated = createNodes().substr(0, 6);
+    std::istringstream truncatedStream(truncated);
+    EXPECT_ANY_THROW(node.read(truncatedStream));
+
+    // body past the end of the stream
+    std::string data = createNodes(100);
+    imstream memoryStream(&data[0], data.size());
+    EXPECT_ANY_THROW(node.read(memoryStream));
+    std::istringstream plainStream(data);
+    EXPECT_ANY_THROW(node.read(plainStream));
+}
+
+}
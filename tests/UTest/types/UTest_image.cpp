@@ -0,0 +1,113 @@
+#include "gtest/gtest.h"
+
+#include <cstdlib>
+#include <memory>
+
+#include "shendk/types/image.h"
+
+namespace {
+
+    std::shared_ptr<shendk::Image> createImage(uint32_t width, uint32_t height) {
+        std::shared_ptr<shendk::Image> image(new shendk::Image(width, height));
+        for (uint32_t i = 0; i < width * height; i++) {
+            shendk::RGBA& pixel = (*image)[i];
+            pixel.r = static_cast<uint8_t>(i * 37);
+            pixel.g = static_cast<uint8_t>(i * 11 + 5);
+            pixel.b = static_cast<uint8_t>(255 - i * 3);
+            pixel.a = static_cast<uint8_t>(i * 53);
+        }
+        return image;
+    }
+
+    TEST(Image, resize)
+    {
+        std::vector<shendk::ResampleFilter> filters = {
+            shendk::ResampleFilter::Box, shendk::ResampleFilter::Triangle, shendk::ResampleFilter::Lanczos3
+        };
+        std::shared_ptr<shendk::Image> image = createImage(12, 10);
+        for (auto filter : filters) {
+            for (bool srgb : { false, true }) {
+                shendk::ResampleOptions options;
+                options.filter = filter;
+                options.srgb = srgb;
+
+                // same size is a copy
+                std::unique_ptr<shendk::Image> same(image->resize(12, 10, options));
+                EXPECT_EQ(memcmp(same->getDataPtr(), image->getDataPtr(), image->size()), 0);
+
+                // flat images stay flat, up and down
+                shendk::Image flat(7, 5);
+                for (auto& pixel : flat) pixel = { 200, 17, 90, 128 };
+                for (auto size : { std::make_pair(3u, 2u), std::make_pair(16u, 9u), std::make_pair(1u, 1u) }) {
+                    std::unique_ptr<shendk::Image> resized(flat.resize(size.first, size.second, options));
+                    ASSERT_EQ(resized->width(), static_cast<int>(size.first));
+                    ASSERT_EQ(resized->height(), static_cast<int>(size.second));
+                    for (auto& pixel : *resized) {
+                        EXPECT_EQ(pixel.r, 200);
+                        EXPECT_EQ(pixel.g, 17);
+                        EXPECT_EQ(pixel.b, 90);
+                        EXPECT_EQ(pixel.a, 128);
+                    }
+                }
+            }
+        }
+
+        // box halving averages 2x2 texels
+        shendk::ResampleOptions box;
+        box.filter = shendk::ResampleFilter::Box;
+        std::unique_ptr<shendk::Image> half(image->resize(6, 5, box));
+        for (int y = 0; y < 5; y++) {
+            for (int x = 0; x < 6; x++) {
+                int i = y * 2 * 12 + x * 2;
+                const shendk::RGBA& pixel = (*half)[y * 6 + x];
+                EXPECT_EQ(pixel.r, ((*image)[i].r + (*image)[i + 1].r + (*image)[i + 12].r + (*image)[i + 13].r + 2) / 4);
+                EXPECT_EQ(pixel.a, ((*image)[i].a + (*image)[i + 1].a + (*image)[i + 12].a + (*image)[i + 13].a + 2) / 4);
+            }
+        }
+
+        // sRGB averages in linear light, alpha stays linear
+        shendk::Image checker(2, 1);
+        checker[0] = { 0, 0, 0, 0 };
+        checker[1] = { 255, 255, 255, 255 };
+        std::unique_ptr<shendk::Image> linear(checker.resize(1, 1, box));
+        EXPECT_EQ((*linear)[0].r, 128);
+        box.srgb = true;
+        std::unique_ptr<shendk::Image> srgb(checker.resize(1, 1, box));
+        EXPECT_EQ((*srgb)[0].r, 188);
+        EXPECT_EQ((*srgb)[0].a, 128);
+
+        // upscaled gradients stay monotonic
+        shendk::Image ramp(4, 1);
+        for (int x = 0; x < 4; x++) ramp[x] = { static_cast<uint8_t>(x * 80), 0, 0, 255 };
+        std::unique_ptr<shendk::Image> upscaled(ramp.resize(16, 1));
+        for (int x = 1; x < 16; x++) {
+            EXPECT_GE((*upscaled)[x].r, (*upscaled)[x - 1].r);
+        }
+    }
+
+    TEST(Image, mip_chain)
+    {
+        std::shared_ptr<shendk::Image> image = createImage(16, 4);
+        shendk::ResampleOptions options;
+        options.filter = shendk::ResampleFilter::Box;
+        std::vector<std::shared_ptr<shendk::Image>> chain = image->buildMipChain(options);
+        std::vector<std::pair<int, int>> sizes = { { 8, 2 }, { 4, 1 }, { 2, 1 }, { 1, 1 } };
+        ASSERT_EQ(chain.size(), sizes.size());
+        for (size_t level = 0; level < sizes.size(); level++) {
+            EXPECT_EQ(chain[level]->width(), sizes[level].first);
+            EXPECT_EQ(chain[level]->height(), sizes[level].second);
+        }
+
+        // levels are filtered at full precision: the smallest one is the exact average
+        int sum = 0;
+        for (auto& pixel : *image) sum += pixel.g;
+        EXPECT_EQ((*chain.back())[0].g, (sum + 32) / 64);
+
+        // every filter reaches 1x1, single texels have no mipmaps
+        options.filter = shendk::ResampleFilter::Lanczos3;
+        options.srgb = true;
+        EXPECT_EQ(createImage(5, 3)->buildMipChain(options).size(), 2u);
+        EXPECT_TRUE(createImage(1, 1)->buildMipChain(options).empty());
+    }
+
+}
@@ -0,0 +1,46 @@
+#include "gtest/gtest.h"
+
+#include "shendk/utils/binary_reader.h"
+#include "shendk/utils/binary_writer.h"
+
+namespace {
+
+TEST(BinaryReader, read_write)
+{
+    shendk::BinaryWriter writer;
+    writer.write<uint32_t>(0x12345678);
+    writer.write<uint16_t>(0xBEEF);
+    writer.writeString("MOTN");
+    writer.align(16);
+    float values[3] = { 1.0f, 2.0f, 3.0f };
+    writer.writeArray(values, 3);
+    EXPECT_EQ(writer.tell(), 28);
+
+    std::vector<uint8_t> buffer = writer.release();
+    EXPECT_EQ(writer.size(), 0);
+
+    shendk::BinaryReader reader(buffer.data(), buffer.size());
+    EXPECT_EQ(reader.read<uint32_t>(), 0x12345678);
+    EXPECT_EQ(reader.peek<uint16_t>(), 0xBEEF);
+    EXPECT_EQ(reader.read<uint16_t>(), 0xBEEF);
+    EXPECT_EQ(reader.readString(), "MOTN");
+    reader.seek(16);
+    std::vector<float> floats = reader.readArray<float>(3);
+    EXPECT_EQ(floats[2], 3.0f);
+    EXPECT_TRUE(reader.eof());
+    EXPECT_TRUE(reader.good());
+
+    shendk::BinaryReader sub = reader.subReader(4, 2);
+    EXPECT_EQ(sub.read<uint16_t>(), 0xBEEF);
+    EXPECT_EQ(sub.read<uint16_t>(), 0);
+    EXPECT_FALSE(sub.good());
+
+    // out of bounds reads fail and zero fill
+    EXPECT_EQ(reader.read<uint32_t>(), 0);
+    EXPECT_FALSE(reader.good());
+    reader.clear();
+    reader.seek(0);
+    EXPECT_EQ(reader.read<uint32_t>(), 0x12345678);
+}
+
+}
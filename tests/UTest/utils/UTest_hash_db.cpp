@@ -0,0 +1,51 @@
+#include "gtest/gtest.h"
+
+#include <filesystem>
+#include <fstream>
+
+#include "shendk/utils/hash_db.h"
+
+namespace fs = std::filesystem;
+
+namespace {
+
+TEST(HashDB, lookup_compile)
+{
+    std::string jsonPath = (fs::temp_directory_path() / "shendk_hashdb.json").string();
+    std::string dbPath = (fs::temp_directory_path() / "shendk_hashdb.bin").string();
+    {
+        std::ofstream json(jsonPath);
+        json << "[";
+        for (uint32_t i = 0; i < 1000; i++) {
+            json << (i ? "," : "") << "{\"Hash\":" << (i % 500) + 1 << ",\"HashPath\":" << i + 1
+                 << ",\"Path\":\"/data/file" << i << ".bin\"}";
+        }
+        json << "]";
+    }
+
+    shendk::HashDB db;
+    EXPECT_FALSE(db.isInitialized());
+    EXPECT_EQ(db.getFilepath(1, 1), "");
+    ASSERT_TRUE(db.initialize(jsonPath));
+    EXPECT_EQ(db.size(), 1000);
+    EXPECT_EQ(db.getFilepath(1, 1), "/data/file0.bin");
+    EXPECT_EQ(db.getFilepath(1, 501), "/data/file500.bin");
+    EXPECT_EQ(db.getFilepath(1), "/data/file0.bin"); // first entry wins
+    EXPECT_EQ(db.getFilepath(1, 2), "");
+    EXPECT_EQ(db.getFilepath(501), "");
+
+    ASSERT_TRUE(db.compile(dbPath));
+
+    shendk::HashDB compiled;
+    ASSERT_TRUE(compiled.initialize(dbPath));
+    EXPECT_EQ(compiled.size(), 1000);
+    for (uint32_t i = 0; i < 1000; i++) {
+        EXPECT_EQ(compiled.findFilepath((i % 500) + 1, i + 1), "/data/file" + std::to_string(i) + ".bin");
+    }
+    EXPECT_EQ(compiled.getFilepath(500), "/data/file499.bin");
+
+    fs::remove(jsonPath);
+    fs::remove(dbPath);
+}
+
+}
@@ -0,0 +1,42 @@
+#include "gtest/gtest.h"
+
+#include <cstring>
+
+#include "shendk/files/container/ipac.h"
+#include "shendk/utils/mapped_file.h"
+
+namespace {
+
+TEST(MappedFile, ipac_views)
+{
+    std::string filepath = (fs::temp_directory_path() / "shendk_mapped.ipac").string();
+
+    shendk::IPAC ipac;
+    ipac.header.signature = shendk::IPAC::signature;
+    for (int i = 0; i < 3; i++) {
+        shendk::IPAC::EntryMeta meta = {};
+        memcpy(meta.filename, "ENTRY000", 8);
+        memcpy(meta.extension, "BIN ", 4);
+        shendk::IPAC::Entry entry(meta);
+        std::vector<char> data(100 + i, static_cast<char>('a' + i));
+        entry.setData(data);
+        ipac.entries.push_back(entry);
+    }
+    ipac.write(filepath);
+
+    shendk::IPAC mapped;
+    mapped.readMapped(filepath);
+    ASSERT_TRUE(mapped.mappedFile != nullptr);
+    ASSERT_EQ(mapped.entries.size(), 3);
+    for (int i = 0; i < 3; i++) {
+        shendk::MemoryView view = mapped.entries[i].getView();
+        EXPECT_TRUE(mapped.mappedFile->view().contains(view));
+        EXPECT_EQ(view.size, 100 + i);
+        EXPECT_EQ(view.data[0], 'a' + i);
+        EXPECT_EQ(mapped.entries[i].getData(), std::vector<char>(100 + i, static_cast<char>('a' + i)));
+    }
+
+    fs::remove(filepath);
+}
+
+}
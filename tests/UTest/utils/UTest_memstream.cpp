@@ -26,4 +26,48 @@ TEST(memstream, read_write)
     SUCCEED();
 }
 
+TEST(memstream, grow_and_release)
+{
+    omstream out(16);
+    EXPECT_GE(out.capacity(), 16);
+    for (int i = 0; i < 1000; i++) {
+        out.write("Hello", 5);
+    }
+    EXPECT_EQ(out.size(), 5000);
+
+    // seeking beyond the end zero fills the gap
+    out.seekp(6000);
+    out.put('!');
+    out.seekp(0, std::ios::end);
+    EXPECT_EQ(out.tellp(), 6001);
+
+    size_t bufferSize = 0;
+    std::unique_ptr<char[]> buffer = out.release(bufferSize);
+    ASSERT_EQ(bufferSize, 6001);
+    EXPECT_EQ(std::string(buffer.get() + 4995, 5), "Hello");
+    EXPECT_EQ(buffer[5500], 0);
+    EXPECT_EQ(buffer[6000], '!');
+    EXPECT_EQ(out.size(), 0);
+}
+
+TEST(memstream, chunked)
+{
+    ocmstream out(7);
+    for (int i = 0; i < 10; i++) {
+        out.write("0123456789", 10);
+    }
+    out.seekp(3);
+    out.write("abc", 3);
+    out.seekp(120);
+    out.put('!');
+
+    size_t bufferSize = 0;
+    std::unique_ptr<char[]> buffer = out.release(bufferSize);
+    ASSERT_EQ(bufferSize, 121);
+    EXPECT_EQ(std::string(buffer.get(), 10), "012abc6789");
+    EXPECT_EQ(std::string(buffer.get() + 90, 10), "0123456789");
+    EXPECT_EQ(buffer[110], 0);
+    EXPECT_EQ(buffer[120], '!');
+}
+
 }
@@ -0,0 +1,51 @@
+#include "gtest/gtest.h"
+
+#include "shendk/utils/murmurhash2.h"
+#include "shendk/utils/filename_recovery.h"
+
+namespace {
+
+TEST(MurmurHash2, batch)
+{
+    std::vector<std::string> inputs;
+    for (int i = 0; i < 100; i++) {
+        inputs.push_back(std::string("./TEX/Assets/").substr(0, i % 14) + std::string(i % 7, 'X') + std::to_string(i));
+    }
+    std::vector<uint32_t> hashes = shendk::MurmurHash2::hashBatch(inputs, true, 4);
+    std::vector<uint32_t> plain = shendk::MurmurHash2::hashBatch(inputs, false, 4);
+    for (size_t i = 0; i < inputs.size(); i++) {
+        EXPECT_EQ(hashes[i], shendk::MurmurHash2::hashFilenamePlain(inputs[i], true));
+        EXPECT_EQ(plain[i], shendk::MurmurHash2::hashFilenamePlain(inputs[i], false));
+    }
+}
+
+TEST(MurmurHash2, filename_recovery)
+{
+    shendk::TAD tad;
+    for (std::string path : { "/data/scene/0042/map.mt5", "/data/scene/0007/tree.mt5", "/data/unknown.bin" }) {
+        shendk::TAD::Entry entry = {};
+        entry.hash1 = shendk::MurmurHash2::hashFilenamePlain(path, true);
+        entry.hash2 = 0x12345678;
+        tad.entries.push_back(entry);
+    }
+
+    shendk::FilenameRecovery recovery(tad);
+    EXPECT_EQ(recovery.targetCount(), 3);
+    recovery.addWordlist("names", { "HOUSE", "MAP", "TREE" });
+    EXPECT_EQ(recovery.candidateCount("/DATA/SCENE/{0000-0099}/{names}.MT5"), 300);
+
+    std::vector<shendk::FilenameRecovery::Match> matches = recovery.search("/DATA/SCENE/{0000-0099}/{names}.MT5", 4);
+    ASSERT_EQ(matches.size(), 2);
+    EXPECT_EQ(matches[0].entryIndex, 0);
+    EXPECT_EQ(matches[0].filepath, "/DATA/SCENE/0042/MAP.MT5");
+    EXPECT_EQ(matches[1].filepath, "/DATA/SCENE/0007/TREE.MT5");
+
+    // the second hash scheme is unverified, so a differing hash2 is reported instead of filtered
+    EXPECT_EQ(matches[0].hash2, 0x12345678u);
+    EXPECT_FALSE(matches[0].hash2Confirmed);
+    std::string buffer;
+    EXPECT_EQ(shendk::MurmurHash2::hashFilenameSecond("/DATA/map.mt5", 0x0000ABCD, true, buffer),
+              shendk::MurmurHash2::hashFilenamePlain("/data/map.mt50000abcd", false));
+}
+
+}